@@ -38,6 +38,7 @@
 #include <common/bar-private.h>
 #include <common/bar-blconf.h>
 #include <common/bar-debug.h>
+#include <common/bar-trace.h>
 #include <common/bar-utils.h>
 #include <libbladebar/libbladebar.h>
 #include <libbladebar/blade-bar-plugin-provider.h>
@@ -61,6 +62,15 @@
 
 static void      bar_application_finalize           (GObject                *object);
 static gboolean  bar_application_autosave_timer     (gpointer                user_data);
+static gboolean  bar_application_input_hook         (GSignalInvocationHint  *ihint,
+                                                       guint                   n_param_values,
+                                                       const GValue           *param_values,
+                                                       gpointer                user_data);
+static void      bar_application_itembar_changed    (GtkWidget              *itembar,
+                                                       BarWindow            *window);
+static void      bar_application_plugin_set_dirty   (BladeBarPluginProvider *provider);
+static gboolean  bar_application_plugin_get_dirty   (BarApplication       *application,
+                                                       BladeBarPluginProvider *provider);
 static void      bar_application_plugin_move        (GtkWidget              *item,
                                                        BarApplication       *application);
 static gboolean  bar_application_plugin_insert      (BarApplication       *application,
@@ -128,6 +138,14 @@ struct _BarApplication
   /* autosave timer for plugins */
   guint               autosave_timer_id;
 
+  /* emission hooks to find plugins with user input */
+  guint               input_signal_ids[3];
+  gulong              input_hook_ids[3];
+
+  /* input in a window we could not relate to a plugin, all
+   * internal plugins are saved during the next autosave */
+  guint               plugins_dirty : 1;
+
 #ifdef GDK_WINDOWING_X11
   guint               wait_for_wm_timeout_id;
 #endif
@@ -177,10 +195,23 @@ static const GtkTargetEntry drop_targets[] =
 
 
 
+static const gchar *input_signals[] =
+{
+  "button-release-event",
+  "key-release-event",
+  "scroll-event"
+};
+
+
+
 G_DEFINE_TYPE (BarApplication, bar_application, G_TYPE_OBJECT)
 
 
 
+static GQuark dirty_quark = 0;
+
+
+
 static void
 bar_application_class_init (BarApplicationClass *klass)
 {
@@ -188,6 +219,8 @@ bar_application_class_init (BarApplicationClass *klass)
 
   gobject_class = G_OBJECT_CLASS (klass);
   gobject_class->finalize = bar_application_finalize;
+
+  dirty_quark = g_quark_from_static_string ("bar-application-dirty");
 }
 
 
@@ -195,14 +228,17 @@ bar_application_class_init (BarApplicationClass *klass)
 static void
 bar_application_init (BarApplication *application)
 {
-  GError *error = NULL;
-  gint    configver;
+  GError   *error = NULL;
+  gint      configver;
+  gpointer  widget_class;
+  guint     i;
 
   application->windows = NULL;
   application->dialogs = NULL;
   application->drop_desktop_files = FALSE;
   application->drop_data_ready = FALSE;
   application->drop_occurred = FALSE;
+  application->plugins_dirty = FALSE;
 
   /* get the blconf channel (singleton) */
   application->blconf = bar_properties_get_channel (G_OBJECT (application));
@@ -222,12 +258,33 @@ bar_application_init (BarApplication *application)
   if (blconf_channel_get_bool (application->blconf, "/force-all-external", FALSE))
     bar_module_factory_force_all_external ();
 
+  /* check if trusted plugins can share a wrapper process */
+  if (blconf_channel_get_bool (application->blconf, "/shared-wrapper", FALSE))
+    bar_module_factory_share_wrappers ();
+
+  /* limits for the watchdog of external plugins */
+  bar_plugin_external_set_watchdog (blconf_channel_get_uint (application->blconf, "/watchdog/cpu-percent", 0),
+                                      blconf_channel_get_uint (application->blconf, "/watchdog/memory-kb", 0),
+                                      blconf_channel_get_uint (application->blconf, "/watchdog/stall-seconds", 0));
+
   /* get a factory reference so it never unloads */
   application->factory = bar_module_factory_get ();
 
   /* start the autosave timer for plugins */
-  application->autosave_timer_id = g_timeout_add_seconds (60 * 10,
+  application->autosave_timer_id = g_timeout_add_seconds (AUTOSAVE_INTERVAL,
       bar_application_autosave_timer, application);
+
+  /* user input is what changes the configuration of most plugins, so
+   * watch it to only save the plugins that were used since the last
+   * autosave; external plugins are watched by their wrapper */
+  widget_class = g_type_class_ref (GTK_TYPE_WIDGET);
+  for (i = 0; i < G_N_ELEMENTS (input_signals); i++)
+    {
+      application->input_signal_ids[i] = g_signal_lookup (input_signals[i], GTK_TYPE_WIDGET);
+      application->input_hook_ids[i] = g_signal_add_emission_hook (application->input_signal_ids[i], 0,
+          bar_application_input_hook, application, NULL);
+    }
+  g_type_class_unref (widget_class);
 }
 
 
@@ -236,15 +293,20 @@ static void
 bar_application_finalize (GObject *object)
 {
   BarApplication *application = BAR_APPLICATION (object);
+  guint             i;
 
   bar_return_if_fail (application->dialogs == NULL);
 
+  for (i = 0; i < G_N_ELEMENTS (input_signals); i++)
+    g_signal_remove_emission_hook (application->input_signal_ids[i],
+                                   application->input_hook_ids[i]);
+
   if (application->autosave_timer_id != 0)
     {
       g_source_remove (application->autosave_timer_id);
 
-      /* save plugins */
-      bar_application_autosave_timer (application);
+      /* save all plugins, some also change without user input */
+      bar_application_save (application, SAVE_PLUGIN_PROVIDERS);
     }
 
 #ifdef GDK_WINDOWING_X11
@@ -272,14 +334,95 @@ bar_application_autosave_timer (gpointer user_data)
 {
   BarApplication *application = BAR_APPLICATION (user_data);
 
-  /* emit a save signal for the plugins */
-  bar_application_save (application, SAVE_PLUGIN_PROVIDERS);
+  /* save the bars and plugins that changed since the last save, so
+   * wrappers of plugins nobody used are not woken up */
+  bar_application_save (application, SAVE_PLUGIN_PROVIDERS | SAVE_PLUGIN_IDS
+                                      | SAVE_ONLY_CHANGED);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+bar_application_input_hook (GSignalInvocationHint *ihint,
+                              guint                  n_param_values,
+                              const GValue          *param_values,
+                              gpointer               user_data)
+{
+  BarApplication *application = BAR_APPLICATION (user_data);
+  GtkWidget        *widget;
+
+  /* walk up to the plugin, menus continue at their attach widget */
+  widget = g_value_get_object (param_values);
+  while (widget != NULL)
+    {
+      if (BLADE_IS_BAR_PLUGIN_PROVIDER (widget))
+        {
+          bar_application_plugin_set_dirty (BLADE_BAR_PLUGIN_PROVIDER (widget));
+          return TRUE;
+        }
+
+      /* input on the bar itself does not affect any plugin */
+      if (BAR_IS_WINDOW (widget))
+        return TRUE;
+
+      if (GTK_IS_MENU (widget))
+        widget = gtk_menu_get_attach_widget (GTK_MENU (widget));
+      else
+        widget = gtk_widget_get_parent (widget);
+    }
+
+  /* most likely a plugin dialog, we can't tell which plugin it belongs to */
+  application->plugins_dirty = TRUE;
 
   return TRUE;
 }
 
 
 
+static void
+bar_application_itembar_changed (GtkWidget   *itembar,
+                                   BarWindow *window)
+{
+  /* plugins were added, removed or moved on this bar */
+  g_object_set_qdata (G_OBJECT (window), dirty_quark, GINT_TO_POINTER (TRUE));
+}
+
+
+
+static void
+bar_application_plugin_set_dirty (BladeBarPluginProvider *provider)
+{
+  if (g_object_get_qdata (G_OBJECT (provider), dirty_quark) == NULL)
+    {
+      bar_debug (BAR_DEBUG_APPLICATION, "%s-%d needs saving",
+                 blade_bar_plugin_provider_get_name (provider),
+                 blade_bar_plugin_provider_get_unique_id (provider));
+
+      g_object_set_qdata (G_OBJECT (provider), dirty_quark, GINT_TO_POINTER (TRUE));
+    }
+}
+
+
+
+static gboolean
+bar_application_plugin_get_dirty (BarApplication         *application,
+                                    BladeBarPluginProvider *provider)
+{
+  /* 4.6 plugins never tell us their configuration changed */
+  if (BAR_IS_PLUGIN_EXTERNAL_46 (provider))
+    return TRUE;
+
+  if (application->plugins_dirty
+      && !BAR_IS_PLUGIN_EXTERNAL (provider))
+    return TRUE;
+
+  return g_object_get_qdata (G_OBJECT (provider), dirty_quark) != NULL;
+}
+
+
+
 static void
 bar_application_blconf_window_bindings (BarApplication *application,
                                           BarWindow      *window,
@@ -347,10 +490,13 @@ bar_application_load_real (BarApplication *application)
   GPtrArray    *bars;
   gint          bar_id;
   gboolean      save_changed_ids = FALSE;
+  GSList       *li;
 
   bar_return_if_fail (BAR_IS_APPLICATION (application));
   bar_return_if_fail (BLCONF_IS_CHANNEL (application->blconf));
 
+  bar_trace_begin ("load");
+
   display = gdk_display_get_default ();
 
   if (blconf_channel_get_property (application->blconf, "/bars", &val)
@@ -387,6 +533,8 @@ bar_application_load_real (BarApplication *application)
               bar_id = i;
             }
 
+          bar_trace_begin ("bar-%d", bar_id);
+
           /* start the bar directly on the correct screen */
           g_snprintf (buf, sizeof (buf), "/bars/bar-%d/output-name", bar_id);
           output_name = blconf_channel_get_string (application->blconf, buf, NULL);
@@ -406,7 +554,10 @@ bar_application_load_real (BarApplication *application)
           g_snprintf (buf, sizeof (buf), "/bars/bar-%d/plugin-ids", bar_id);
           array = blconf_channel_get_arrayv (application->blconf, buf);
           if (array == NULL)
-            continue;
+            {
+              bar_trace_end ("bar-%d", bar_id);
+              continue;
+            }
 
           for (j = 0; j < array->len; j++)
             {
@@ -441,6 +592,8 @@ bar_application_load_real (BarApplication *application)
             }
 
           blconf_array_free (array);
+
+          bar_trace_end ("bar-%d", bar_id);
         }
 
       /* free blconf array or uint */
@@ -451,8 +604,14 @@ bar_application_load_real (BarApplication *application)
   if (G_UNLIKELY (application->windows == NULL))
     bar_application_new_window (application, NULL, -1, TRUE);
 
+  /* the plugin ids of the loaded bars are in the channel */
+  for (li = application->windows; li != NULL; li = li->next)
+    g_object_set_qdata (G_OBJECT (li->data), dirty_quark, NULL);
+
   if (save_changed_ids)
     bar_application_save (application, SAVE_PLUGIN_IDS);
+
+  bar_trace_end ("load");
 }
 
 
@@ -492,6 +651,8 @@ bar_application_wait_for_window_manager_destroyed (gpointer data)
 
   application->wait_for_wm_timeout_id = 0;
 
+  bar_trace_async_end (0, "wait-for-wm");
+
   if (!wfwm->have_wm)
     {
       g_printerr (G_LOG_DOMAIN ": No window manager registered on screen 0. "
@@ -762,6 +923,11 @@ bar_application_plugin_provider_signal (BladeBarPluginProvider       *provider,
       /* signals we can ignore, only for external plugins */
       break;
 
+    case PROVIDER_SIGNAL_SAVE_NEEDED:
+      /* save the plugin during the next autosave */
+      bar_application_plugin_set_dirty (provider);
+      break;
+
     default:
       g_critical ("Received unknown provider signal %d", provider_signal);
       break;
@@ -785,17 +951,27 @@ bar_application_plugin_insert (BarApplication  *application,
   bar_return_val_if_fail (BAR_IS_WINDOW (window), FALSE);
   bar_return_val_if_fail (name != NULL, FALSE);
 
+  bar_trace_begin ("plugin %s-%d", name, unique_id);
+
   /* create a new bar plugin */
   provider = bar_module_factory_new_plugin (application->factory, name,
                                               gtk_window_get_screen (GTK_WINDOW (window)),
                                               unique_id, arguments, &new_unique_id);
   if (G_UNLIKELY (provider == NULL))
-    return FALSE;
+    {
+      bar_trace_end ("plugin %s-%d", name, unique_id);
+      return FALSE;
+    }
 
   /* make sure there is no bar configuration with this unique id when a
    * new plugin is created */
   if (G_UNLIKELY (unique_id == -1))
-    bar_application_plugin_delete_config (application, name, new_unique_id);
+    {
+      bar_application_plugin_delete_config (application, name, new_unique_id);
+
+      /* nothing of this plugin has been saved yet */
+      bar_application_plugin_set_dirty (BLADE_BAR_PLUGIN_PROVIDER (provider));
+    }
 
   /* add signal to monitor provider signals */
   g_signal_connect (G_OBJECT (provider), "provider-signal",
@@ -819,6 +995,8 @@ bar_application_plugin_insert (BarApplication  *application,
   /* show the plugin */
   gtk_widget_show (provider);
 
+  bar_trace_end ("plugin %s-%d", name, unique_id);
+
   return TRUE;
 }
 
@@ -1219,6 +1397,7 @@ bar_application_load (BarApplication  *application,
       g_strfreev (atom_names);
 
       /* setup timeout to check for a window manager */
+      bar_trace_async_begin (0, "wait-for-wm");
       application->wait_for_wm_timeout_id =
           g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, 50, bar_application_wait_for_window_manager,
                               wfwm, bar_application_wait_for_window_manager_destroyed);
@@ -1272,6 +1451,10 @@ bar_application_save (BarApplication *application,
       bar_application_save_window (application, li->data, save_types);
     }
 
+  /* all internal plugins were saved */
+  if (BAR_HAS_FLAG (save_types, SAVE_PLUGIN_PROVIDERS))
+    application->plugins_dirty = FALSE;
+
   if (bars != NULL)
     {
       /* store the bar ids */
@@ -1306,12 +1489,18 @@ bar_application_save_window (BarApplication *application,
       || !BAR_HAS_FLAG (save_types, SAVE_PLUGIN_IDS | SAVE_PLUGIN_PROVIDERS))
     return;
 
+  /* the plugin ids of this bar did not change since the last save */
+  if (BAR_HAS_FLAG (save_types, SAVE_ONLY_CHANGED)
+      && g_object_get_qdata (G_OBJECT (window), dirty_quark) == NULL)
+    BAR_UNSET_FLAG (save_types, SAVE_PLUGIN_IDS);
+
   bar_id = bar_window_get_id (window);
   bar_debug (BAR_DEBUG_APPLICATION,
-               "saving /bars/bar-%d: ids=%s, providers=%s",
+               "saving /bars/bar-%d: ids=%s, providers=%s, only-changed=%s",
                bar_id,
                BAR_DEBUG_BOOL (BAR_HAS_FLAG (save_types, SAVE_PLUGIN_IDS)),
-               BAR_DEBUG_BOOL (BAR_HAS_FLAG (save_types, SAVE_PLUGIN_PROVIDERS)));
+               BAR_DEBUG_BOOL (BAR_HAS_FLAG (save_types, SAVE_PLUGIN_PROVIDERS)),
+               BAR_DEBUG_BOOL (BAR_HAS_FLAG (save_types, SAVE_ONLY_CHANGED)));
 
   /* get the itembar children */
   itembar = gtk_bin_get_child (GTK_BIN (window));
@@ -1320,6 +1509,8 @@ bar_application_save_window (BarApplication *application,
   /* only cleanup and continue if there are no children */
   if (BAR_HAS_FLAG (save_types, SAVE_PLUGIN_IDS))
     {
+      g_object_set_qdata (G_OBJECT (window), dirty_quark, NULL);
+
       if (G_UNLIKELY (children == NULL))
         {
           g_snprintf (buf, sizeof (buf), "/bars/bar-%d/plugin-ids", bar_id);
@@ -1352,8 +1543,13 @@ bar_application_save_window (BarApplication *application,
         }
 
       /* ask the plugin to save */
-      if (BAR_HAS_FLAG (save_types, SAVE_PLUGIN_PROVIDERS))
-        blade_bar_plugin_provider_save (provider);
+      if (BAR_HAS_FLAG (save_types, SAVE_PLUGIN_PROVIDERS)
+          && (!BAR_HAS_FLAG (save_types, SAVE_ONLY_CHANGED)
+              || bar_application_plugin_get_dirty (application, provider)))
+        {
+          blade_bar_plugin_provider_save (provider);
+          g_object_set_qdata (G_OBJECT (provider), dirty_quark, NULL);
+        }
     }
 
   if (array != NULL)
@@ -1527,6 +1723,10 @@ bar_application_new_window (BarApplication *application,
   gtk_container_add (GTK_CONTAINER (window), itembar);
   gtk_widget_show (itembar);
 
+  /* save the plugin ids of this bar during the next autosave */
+  g_signal_connect (G_OBJECT (itembar), "changed",
+                    G_CALLBACK (bar_application_itembar_changed), window);
+
   /* set the itembar drag destination targets */
   gtk_drag_dest_set (GTK_WIDGET (window), 0,
                      drop_targets, G_N_ELEMENTS (drop_targets),
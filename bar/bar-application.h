@@ -39,6 +39,7 @@ typedef enum
   SAVE_PLUGIN_PROVIDERS = 1 << 1,
   SAVE_PLUGIN_IDS       = 1 << 2,
   SAVE_BAR_IDS        = 1 << 3,
+  SAVE_ONLY_CHANGED     = 1 << 4  /* skip clean bars and plugins */
 }
 BarSaveTypes;
 #define SAVE_EVERYTHING (SAVE_PLUGIN_PROVIDERS | SAVE_PLUGIN_IDS | SAVE_BAR_IDS)
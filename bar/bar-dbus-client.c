@@ -182,23 +182,31 @@ bar_dbus_client_gtype_from_string (const gchar *str)
 
 
 
+/**
+ * bar_dbus_client_plugin_event_parse:
+ * @plugin_event  : event in the PLUGIN-NAME:NAME[:TYPE:VALUE] syntax.
+ * @return_tokens : return location for the tokens, the plugin name and
+ *                  event name are the first two.
+ * @value         : an unset #GValue, initialized with the event value.
+ * @error         : return location for a #GError.
+ *
+ * Parses a plugin event for D-Bus or the popup socket. String values
+ * point into the tokens, so @value is unset before g_strfreev().
+ *
+ * Returns: %TRUE if the event was valid.
+ **/
 gboolean
-bar_dbus_client_plugin_event (const gchar  *plugin_event,
-                                gboolean     *return_succeed,
-                                GError      **error)
+bar_dbus_client_plugin_event_parse (const gchar   *plugin_event,
+                                    gchar       ***return_tokens,
+                                    GValue        *value,
+                                    GError       **error)
 {
-  DBusGProxy  *dbus_proxy;
-  gboolean     result = FALSE;
-  gchar      **tokens;
-  GType        type;
-  GValue       value = { 0, };
-  guint        n_tokens;
+  gchar **tokens;
+  GType   type;
+  guint   n_tokens;
 
   bar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
-
-  dbus_proxy = bar_dbus_client_get_proxy (error);
-  if (G_UNLIKELY (dbus_proxy == NULL))
-    return FALSE;
+  bar_return_val_if_fail (return_tokens != NULL, FALSE);
 
   tokens = g_strsplit (plugin_event, ":", -1);
   n_tokens = g_strv_length (tokens);
@@ -210,31 +218,31 @@ bar_dbus_client_plugin_event (const gchar  *plugin_event,
       g_set_error_literal (error, G_OPTION_ERROR, G_OPTION_ERROR_BAD_VALUE,
                            _("Invalid plugin event syntax specified. "
                              "Use PLUGIN-NAME:NAME[:TYPE:VALUE]."));
-      goto out;
+      goto error;
     }
   else if (n_tokens == 2)
     {
       /* set noop value, recognized by the dbus service as %NULL value */
-      g_value_init (&value, G_TYPE_UCHAR);
-      g_value_set_uchar (&value, '\0');
+      g_value_init (value, G_TYPE_UCHAR);
+      g_value_set_uchar (value, '\0');
     }
   else if (n_tokens == N_TOKENS)
     {
       type = bar_dbus_client_gtype_from_string (tokens[TYPE]);
       if (G_LIKELY (type != G_TYPE_NONE))
         {
-          g_value_init (&value, type);
+          g_value_init (value, type);
 
           if (type == G_TYPE_BOOLEAN)
-            g_value_set_boolean (&value, strcmp (tokens[VALUE], "true") == 0);
+            g_value_set_boolean (value, strcmp (tokens[VALUE], "true") == 0);
           else if (type == G_TYPE_DOUBLE)
-            g_value_set_double (&value, g_ascii_strtod (tokens[VALUE], NULL));
+            g_value_set_double (value, g_ascii_strtod (tokens[VALUE], NULL));
           else if (type == G_TYPE_INT)
-            g_value_set_int (&value, strtol (tokens[VALUE], NULL, 0));
+            g_value_set_int (value, strtol (tokens[VALUE], NULL, 0));
           else if (type == G_TYPE_STRING)
-            g_value_set_static_string (&value, tokens[VALUE]);
+            g_value_set_static_string (value, tokens[VALUE]);
           else if (type == G_TYPE_UINT)
-            g_value_set_uint (&value, strtol (tokens[VALUE], NULL, 0));
+            g_value_set_uint (value, strtol (tokens[VALUE], NULL, 0));
           else
             bar_assert_not_reached ();
         }
@@ -244,27 +252,58 @@ bar_dbus_client_plugin_event (const gchar  *plugin_event,
                        _("Invalid hint type \"%s\". Valid types "
                          "are bool, double, int, string and uint."),
                        tokens[TYPE]);
-          goto out;
+          goto error;
         }
     }
   else
     {
       bar_assert_not_reached ();
-      goto out;
+      goto error;
     }
 
-  /* send value over dbus */
-  bar_return_val_if_fail (G_IS_VALUE (&value), FALSE);
-  result = _bar_dbus_client_plugin_event (dbus_proxy,
-                                            tokens[PLUGIN_NAME],
-                                            tokens[NAME],
-                                            &value,
-                                            return_succeed,
-                                            error);
-  g_value_unset (&value);
+  *return_tokens = tokens;
+
+  return TRUE;
 
-out:
+error:
   g_strfreev (tokens);
+  *return_tokens = NULL;
+
+  return FALSE;
+}
+
+
+
+gboolean
+bar_dbus_client_plugin_event (const gchar  *plugin_event,
+                                gboolean     *return_succeed,
+                                GError      **error)
+{
+  DBusGProxy  *dbus_proxy;
+  gboolean     result = FALSE;
+  gchar      **tokens;
+  GValue       value = { 0, };
+
+  bar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  dbus_proxy = bar_dbus_client_get_proxy (error);
+  if (G_UNLIKELY (dbus_proxy == NULL))
+    return FALSE;
+
+  if (bar_dbus_client_plugin_event_parse (plugin_event, &tokens, &value, error))
+    {
+      /* send value over dbus */
+      bar_return_val_if_fail (G_IS_VALUE (&value), FALSE);
+      result = _bar_dbus_client_plugin_event (dbus_proxy,
+                                                tokens[PLUGIN_NAME],
+                                                tokens[NAME],
+                                                &value,
+                                                return_succeed,
+                                                error);
+      g_value_unset (&value);
+      g_strfreev (tokens);
+    }
+
   g_object_unref (G_OBJECT (dbus_proxy));
 
   return result;
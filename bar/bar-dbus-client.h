@@ -35,6 +35,11 @@ gboolean  bar_dbus_client_add_new_item               (const gchar  *plugin_name,
                                                         gchar       **arguments,
                                                         GError      **error);
 
+gboolean  bar_dbus_client_plugin_event_parse         (const gchar  *plugin_event,
+                                                        gchar      ***return_tokens,
+                                                        GValue       *value,
+                                                        GError      **error);
+
 gboolean  bar_dbus_client_plugin_event               (const gchar  *plugin_event,
                                                         gboolean     *return_succeed,
                                                         GError      **error);
@@ -20,9 +20,26 @@
 #include <config.h>
 #endif
 
+/* for struct ucred */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #ifdef HAVE_STRING_H
 #include <string.h>
 #endif
+#ifdef HAVE_SIGNAL_H
+#include <signal.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
 
 #include <dbus/dbus.h>
 #include <dbus/dbus-glib.h>
@@ -30,15 +47,21 @@
 #include <blxo/blxo.h>
 #include <common/bar-private.h>
 #include <common/bar-dbus.h>
+#include <common/bar-debug.h>
+#include <common/bar-popup-socket.h>
 #include <libbladeutil/libbladeutil.h>
 #include <libbladeui/libbladeui.h>
 #include <libbladebar/libbladebar.h>
 
 #include <bar/bar-dbus-service.h>
+#include <bar/bar-dbus-client.h>
 #include <bar/bar-application.h>
 #include <bar/bar-preferences-dialog.h>
 #include <bar/bar-item-dialog.h>
 #include <bar/bar-module-factory.h>
+#include <bar/bar-plugin-external.h>
+#include <bar/bar-plugin-external-46.h>
+#include <bar/bar-profiler.h>
 
 
 
@@ -63,9 +86,21 @@ static gboolean  bar_dbus_service_plugin_event               (BarDBusService  *s
                                                                 const GValue      *value,
                                                                 gboolean          *OUT_succeed,
                                                                 GError           **error);
+static gboolean  bar_dbus_service_get_plugin_stats           (BarDBusService   *service,
+                                                                GPtrArray         **OUT_stats,
+                                                                GError            **error);
+static gboolean  bar_dbus_service_get_plugin_profile         (BarDBusService   *service,
+                                                                GPtrArray         **OUT_profile,
+                                                                GError            **error);
+static gboolean  bar_dbus_service_dump_debug_log             (BarDBusService   *service,
+                                                                GError            **error);
 static gboolean  bar_dbus_service_terminate                  (BarDBusService   *service,
                                                                 gboolean            restart,
                                                                 GError            **error);
+#ifdef BAR_POPUP_SOCKET
+static void      bar_dbus_service_popup_socket_open          (BarDBusService   *service);
+static void      bar_dbus_service_popup_socket_close         (BarDBusService   *service);
+#endif
 
 
 
@@ -91,6 +126,13 @@ struct _BarDBusService
 
   /* whether the service is owner of the name */
   guint            is_owner : 1;
+
+#ifdef BAR_POPUP_SOCKET
+  /* listening popup socket and the connected clients */
+  gint             popup_fd;
+  guint            popup_watch_id;
+  GSList          *popup_clients;
+#endif
 };
 
 typedef struct
@@ -102,6 +144,18 @@ typedef struct
 }
 PluginEvent;
 
+#ifdef BAR_POPUP_SOCKET
+typedef struct
+{
+  BarDBusService *service;
+  gint            fd;
+  guint           watch_id;
+  gsize           len;
+  gchar           buffer[BAR_POPUP_SOCKET_MAX_EVENT];
+}
+PopupClient;
+#endif
+
 
 
 /* shared boolean for restart or quit */
@@ -136,6 +190,11 @@ bar_dbus_service_init (BarDBusService *service)
 
   service->is_owner = FALSE;
   service->remote_events = NULL;
+#ifdef BAR_POPUP_SOCKET
+  service->popup_fd = -1;
+  service->popup_watch_id = 0;
+  service->popup_clients = NULL;
+#endif
 
   service->connection = dbus_g_bus_get (DBUS_BUS_SESSION, &error);
   if (G_LIKELY (service->connection != NULL))
@@ -152,6 +211,11 @@ bar_dbus_service_init (BarDBusService *service)
           dbus_g_connection_register_g_object (service->connection,
                                                BAR_DBUS_PATH,
                                                G_OBJECT (service));
+
+#ifdef BAR_POPUP_SOCKET
+          /* low latency path for the popup scripts */
+          bar_dbus_service_popup_socket_open (service);
+#endif
         }
     }
   else
@@ -169,6 +233,10 @@ bar_dbus_service_finalize (GObject *object)
   BarDBusService *service = BAR_DBUS_SERVICE (object);
   DBusConnection   *connection;
 
+#ifdef BAR_POPUP_SOCKET
+  bar_dbus_service_popup_socket_close (service);
+#endif
+
   if (G_LIKELY (service->connection != NULL))
     {
       /* release the org.blade.Bar name */
@@ -316,6 +384,7 @@ bar_dbus_service_plugin_event_result (BladeBarPluginProvider *prev_provider,
 
               new_result = blade_bar_plugin_provider_remote_event (provider, event->name,
                                                                     &event->value, &new_handle);
+              blade_bar_plugin_provider_emit_signal (provider, PROVIDER_SIGNAL_SAVE_NEEDED);
 
               if (new_handle > 0 && lnext != NULL)
                 {
@@ -379,6 +448,9 @@ bar_dbus_service_plugin_event (BarDBusService  *service,
       bar_return_val_if_fail (BLADE_IS_BAR_PLUGIN_PROVIDER (li->data), FALSE);
       result = blade_bar_plugin_provider_remote_event (li->data, name, value, &handle);
 
+      /* the event might have changed the plugin configuration */
+      blade_bar_plugin_provider_emit_signal (li->data, PROVIDER_SIGNAL_SAVE_NEEDED);
+
       if (handle > 0 && lnext != NULL)
         {
           event = g_slice_new0 (PluginEvent);
@@ -426,6 +498,169 @@ bar_dbus_service_plugin_event (BarDBusService  *service,
 
 
 
+static gboolean
+bar_dbus_service_get_plugin_stats (BarDBusService  *service,
+                                     GPtrArray        **OUT_stats,
+                                     GError           **error)
+{
+  BarApplication    *application;
+  BarPluginExternal *external;
+  GSList            *li;
+  GList             *children, *lp;
+  GtkWidget         *itembar;
+  GValue             message = { 0, };
+  guint              cpu, rss, stall;
+
+  bar_return_val_if_fail (BAR_IS_DBUS_SERVICE (service), FALSE);
+  bar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  *OUT_stats = g_ptr_array_new ();
+
+  g_value_init (&message, BAR_TYPE_DBUS_PLUGIN_STATS);
+  g_value_take_boxed (&message, dbus_g_type_specialized_construct (G_VALUE_TYPE (&message)));
+
+  application = bar_application_get ();
+
+  for (li = bar_application_get_windows (application); li != NULL; li = li->next)
+    {
+      itembar = gtk_bin_get_child (GTK_BIN (li->data));
+      children = gtk_container_get_children (GTK_CONTAINER (itembar));
+
+      for (lp = children; lp != NULL; lp = lp->next)
+        {
+          if (!BAR_IS_PLUGIN_EXTERNAL (lp->data))
+            continue;
+
+          external = BAR_PLUGIN_EXTERNAL (lp->data);
+          bar_plugin_external_get_stats (external, &cpu, &rss, &stall);
+
+          dbus_g_type_struct_set (&message,
+                                  DBUS_STATS_UNIQUE_ID, external->unique_id,
+                                  DBUS_STATS_NAME, bar_module_get_name (external->module),
+                                  DBUS_STATS_PID, (gint) bar_plugin_external_get_pid (external),
+                                  DBUS_STATS_CPU, cpu,
+                                  DBUS_STATS_RSS, rss,
+                                  DBUS_STATS_STALL, stall,
+                                  G_MAXUINT);
+
+          g_ptr_array_add (*OUT_stats, g_value_dup_boxed (&message));
+        }
+
+      g_list_free (children);
+    }
+
+  g_object_unref (G_OBJECT (application));
+  g_value_unset (&message);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+bar_dbus_service_get_plugin_profile (BarDBusService  *service,
+                                       GPtrArray        **OUT_profile,
+                                       GError           **error)
+{
+  const GSList            *li;
+  BarProfilerStats        *stats;
+  BladeBarPluginProvider *provider;
+  GValue                   message = { 0, };
+
+  bar_return_val_if_fail (BAR_IS_DBUS_SERVICE (service), FALSE);
+  bar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  *OUT_profile = g_ptr_array_new ();
+
+  /* start measuring, the next call returns the results */
+  bar_profiler_init ();
+
+  g_value_init (&message, BAR_TYPE_DBUS_PLUGIN_PROFILE);
+  g_value_take_boxed (&message, dbus_g_type_specialized_construct (G_VALUE_TYPE (&message)));
+
+  for (li = bar_profiler_get_stats (); li != NULL; li = li->next)
+    {
+      stats = li->data;
+      if (!BLADE_IS_BAR_PLUGIN_PROVIDER (stats->plugin))
+        continue;
+
+      provider = BLADE_BAR_PLUGIN_PROVIDER (stats->plugin);
+
+      dbus_g_type_struct_set (&message,
+                              DBUS_PROFILE_UNIQUE_ID, blade_bar_plugin_provider_get_unique_id (provider),
+                              DBUS_PROFILE_NAME, blade_bar_plugin_provider_get_name (provider),
+                              DBUS_PROFILE_REQUEST_CALLS, stats->calls[BAR_PROFILER_SIZE_REQUEST],
+                              DBUS_PROFILE_REQUEST_USEC, stats->usec[BAR_PROFILER_SIZE_REQUEST],
+                              DBUS_PROFILE_ALLOCATE_CALLS, stats->calls[BAR_PROFILER_SIZE_ALLOCATE],
+                              DBUS_PROFILE_ALLOCATE_USEC, stats->usec[BAR_PROFILER_SIZE_ALLOCATE],
+                              DBUS_PROFILE_EXPOSE_CALLS, stats->calls[BAR_PROFILER_EXPOSE],
+                              DBUS_PROFILE_EXPOSE_USEC, stats->usec[BAR_PROFILER_EXPOSE],
+                              G_MAXUINT);
+
+      g_ptr_array_add (*OUT_profile, g_value_dup_boxed (&message));
+    }
+
+  g_value_unset (&message);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+bar_dbus_service_dump_debug_log (BarDBusService  *service,
+                                   GError           **error)
+{
+  BarApplication *application;
+  GSList           *li, *pids = NULL;
+  GList            *children, *lp;
+  GtkWidget        *itembar;
+  GPid              pid;
+
+  bar_return_val_if_fail (BAR_IS_DBUS_SERVICE (service), FALSE);
+  bar_return_val_if_fail (error == NULL || *error == NULL, FALSE);
+
+  if (!bar_debug_has_domain (BAR_DEBUG_RING))
+    return TRUE;
+
+  bar_debug_dump ();
+
+#ifdef HAVE_SIGNAL_H
+  /* ask the wrappers to dump their ring, once for a shared host */
+  application = bar_application_get ();
+
+  for (li = bar_application_get_windows (application); li != NULL; li = li->next)
+    {
+      itembar = gtk_bin_get_child (GTK_BIN (li->data));
+      children = gtk_container_get_children (GTK_CONTAINER (itembar));
+
+      for (lp = children; lp != NULL; lp = lp->next)
+        {
+          /* 4.6 plugins don't handle the signal */
+          if (!BAR_IS_PLUGIN_EXTERNAL (lp->data)
+              || BAR_IS_PLUGIN_EXTERNAL_46 (lp->data))
+            continue;
+
+          pid = bar_plugin_external_get_pid (BAR_PLUGIN_EXTERNAL (lp->data));
+          if (pid > 0 && g_slist_find (pids, GINT_TO_POINTER (pid)) == NULL)
+            {
+              kill (pid, SIGUSR2);
+              pids = g_slist_prepend (pids, GINT_TO_POINTER (pid));
+            }
+        }
+
+      g_list_free (children);
+    }
+
+  g_slist_free (pids);
+  g_object_unref (G_OBJECT (application));
+#endif
+
+  return TRUE;
+}
+
+
+
 static gboolean
 bar_dbus_service_terminate (BarDBusService  *service,
                               gboolean           restart,
@@ -441,6 +676,204 @@ bar_dbus_service_terminate (BarDBusService  *service,
 
 
 
+#ifdef BAR_POPUP_SOCKET
+static void
+bar_dbus_service_popup_client_free (PopupClient *client)
+{
+  BarDBusService *service = client->service;
+
+  if (client->watch_id != 0)
+    g_source_remove (client->watch_id);
+
+  close (client->fd);
+
+  service->popup_clients = g_slist_remove (service->popup_clients, client);
+  g_slice_free (PopupClient, client);
+}
+
+
+
+static void
+bar_dbus_service_popup_client_event (PopupClient *client)
+{
+  gchar    **tokens;
+  GValue     value = { 0, };
+  GError    *error = NULL;
+  gboolean   succeed = FALSE;
+  gchar      reply;
+
+  if (bar_dbus_client_plugin_event_parse (client->buffer, &tokens, &value, &error))
+    {
+      /* same dispatch as the D-Bus method */
+      bar_dbus_service_plugin_event (client->service, tokens[0], tokens[1],
+                                     &value, &succeed, NULL);
+
+      g_value_unset (&value);
+      g_strfreev (tokens);
+    }
+  else
+    {
+      bar_debug (BAR_DEBUG_MAIN, "invalid popup event \"%s\": %s",
+                 client->buffer, error->message);
+      g_error_free (error);
+    }
+
+  reply = succeed ? BAR_POPUP_SOCKET_HANDLED : BAR_POPUP_SOCKET_NOT_HANDLED;
+  if (write (client->fd, &reply, 1) != 1)
+    bar_debug (BAR_DEBUG_MAIN, "failed to reply to the popup client: %s",
+               g_strerror (errno));
+}
+
+
+
+static gboolean
+bar_dbus_service_popup_client_read (GIOChannel   *source,
+                                    GIOCondition  condition,
+                                    gpointer      data)
+{
+  PopupClient *client = data;
+  gssize       n;
+  gchar       *newline;
+
+  n = read (client->fd, client->buffer + client->len,
+            sizeof (client->buffer) - client->len - 1);
+  if (n < 0 && (errno == EINTR || errno == EAGAIN))
+    return TRUE;
+
+  if (n > 0)
+    {
+      client->len += n;
+      client->buffer[client->len] = '\0';
+
+      /* wait for the rest of the event */
+      newline = memchr (client->buffer, '\n', client->len);
+      if (newline == NULL
+          && client->len < sizeof (client->buffer) - 1)
+        return TRUE;
+
+      if (newline != NULL)
+        {
+          *newline = '\0';
+          bar_dbus_service_popup_client_event (client);
+        }
+    }
+
+  /* one event per connection */
+  client->watch_id = 0;
+  bar_dbus_service_popup_client_free (client);
+
+  return FALSE;
+}
+
+
+
+static gboolean
+bar_dbus_service_popup_socket_accept (GIOChannel   *source,
+                                      GIOCondition  condition,
+                                      gpointer      data)
+{
+  BarDBusService *service = BAR_DBUS_SERVICE (data);
+  PopupClient    *client;
+  gint            fd;
+  struct ucred    cred;
+  socklen_t       len = sizeof (cred);
+  GIOChannel     *channel;
+
+  fd = accept (service->popup_fd, NULL, NULL);
+  if (fd == -1)
+    return TRUE;
+
+  /* the abstract namespace has no permissions, only talk
+   * to processes of our own user */
+  if (getsockopt (fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == -1
+      || cred.uid != getuid ())
+    {
+      close (fd);
+      return TRUE;
+    }
+
+  fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) | O_NONBLOCK);
+  fcntl (fd, F_SETFD, FD_CLOEXEC);
+
+  client = g_slice_new0 (PopupClient);
+  client->service = service;
+  client->fd = fd;
+  service->popup_clients = g_slist_prepend (service->popup_clients, client);
+
+  channel = g_io_channel_unix_new (fd);
+  client->watch_id = g_io_add_watch_full (channel, G_PRIORITY_HIGH,
+                                          G_IO_IN | G_IO_HUP | G_IO_ERR,
+                                          bar_dbus_service_popup_client_read,
+                                          client, NULL);
+  g_io_channel_unref (channel);
+
+  return TRUE;
+}
+
+
+
+static void
+bar_dbus_service_popup_socket_open (BarDBusService *service)
+{
+  struct sockaddr_un  addr;
+  socklen_t           len;
+  GIOChannel         *channel;
+
+  bar_return_if_fail (service->popup_fd == -1);
+
+  service->popup_fd = socket (AF_UNIX, SOCK_STREAM, 0);
+  if (G_UNLIKELY (service->popup_fd == -1))
+    return;
+
+  fcntl (service->popup_fd, F_SETFL, fcntl (service->popup_fd, F_GETFL) | O_NONBLOCK);
+  fcntl (service->popup_fd, F_SETFD, FD_CLOEXEC);
+
+  len = bar_popup_socket_address (&addr, gdk_display_get_name (gdk_display_get_default ()));
+  if (bind (service->popup_fd, (struct sockaddr *) &addr, len) == -1
+      || listen (service->popup_fd, 8) == -1)
+    {
+      /* the scripts will use D-Bus */
+      bar_debug (BAR_DEBUG_MAIN, "failed to open the popup socket: %s",
+                 g_strerror (errno));
+
+      close (service->popup_fd);
+      service->popup_fd = -1;
+
+      return;
+    }
+
+  /* dispatch before redraws, so the menu is shown in the next frame */
+  channel = g_io_channel_unix_new (service->popup_fd);
+  service->popup_watch_id = g_io_add_watch_full (channel, G_PRIORITY_HIGH, G_IO_IN,
+                                                 bar_dbus_service_popup_socket_accept,
+                                                 service, NULL);
+  g_io_channel_unref (channel);
+}
+
+
+
+static void
+bar_dbus_service_popup_socket_close (BarDBusService *service)
+{
+  while (service->popup_clients != NULL)
+    bar_dbus_service_popup_client_free (service->popup_clients->data);
+
+  if (service->popup_watch_id != 0)
+    {
+      g_source_remove (service->popup_watch_id);
+      service->popup_watch_id = 0;
+    }
+
+  if (service->popup_fd != -1)
+    {
+      close (service->popup_fd);
+      service->popup_fd = -1;
+    }
+}
+#endif
+
+
+
 BarDBusService *
 bar_dbus_service_get (void)
 {
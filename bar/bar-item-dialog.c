@@ -52,10 +52,6 @@ static void         bar_item_dialog_response               (GtkDialog          *
 static void         bar_item_dialog_unique_changed         (BarModuleFactory *factory,
                                                               BarModule        *module,
                                                               BarItemDialog    *dialog);
-static gboolean     bar_item_dialog_unique_changed_foreach (GtkTreeModel       *model,
-                                                              GtkTreePath        *path,
-                                                              GtkTreeIter        *iter,
-                                                              gpointer            user_data);
 static gboolean     bar_item_dialog_separator_func         (GtkTreeModel       *model,
                                                               GtkTreeIter        *iter,
                                                               gpointer            user_data);
@@ -79,7 +75,6 @@ static void         bar_item_dialog_drag_data_received     (GtkWidget          *
                                                               guint               info,
                                                               guint               drag_time,
                                                               BarItemDialog    *dialog);
-static void         bar_item_dialog_populate_store         (BarItemDialog    *dialog);
 static gint         bar_item_dialog_compare_func           (GtkTreeModel       *model,
                                                               GtkTreeIter        *a,
                                                               GtkTreeIter        *b,
@@ -87,6 +82,11 @@ static gint         bar_item_dialog_compare_func           (GtkTreeModel       *
 static gboolean     bar_item_dialog_visible_func           (GtkTreeModel       *model,
                                                               GtkTreeIter        *iter,
                                                               gpointer            user_data);
+static void         bar_item_dialog_icon_renderer          (GtkTreeViewColumn  *column,
+                                                              GtkCellRenderer    *renderer,
+                                                              GtkTreeModel       *model,
+                                                              GtkTreeIter        *iter,
+                                                              gpointer            user_data);
 static void         bar_item_dialog_text_renderer          (GtkTreeViewColumn  *column,
                                                               GtkCellRenderer    *renderer,
                                                               GtkTreeModel       *model,
@@ -111,19 +111,11 @@ struct _BarItemDialog
   BarWindow        *active;
 
   /* pointers to list */
-  GtkListStore       *store;
+  GtkTreeModel       *store;
   GtkTreeView        *treeview;
   GtkWidget          *add_button;
 };
 
-enum
-{
-  COLUMN_ICON_NAME,
-  COLUMN_MODULE,
-  COLUMN_SENSITIVE,
-  N_COLUMNS
-};
-
 static const GtkTargetEntry drag_targets[] =
 {
   { "blade-bar/plugin-name", 0, 0 }
@@ -169,6 +161,7 @@ bar_item_dialog_init (BarItemDialog *dialog)
   GtkWidget         *scroll;
   GtkWidget         *treeview;
   GtkTreeModel      *filter;
+  GtkTreeModel      *sort;
   GtkTreeViewColumn *column;
   GtkCellRenderer   *renderer;
   GtkTreeSelection  *selection;
@@ -234,13 +227,18 @@ bar_item_dialog_init (BarItemDialog *dialog)
   gtk_scrolled_window_set_shadow_type (GTK_SCROLLED_WINDOW (scroll), GTK_SHADOW_IN);
   gtk_widget_show (scroll);
 
-  /* create the store and automatically sort it */
-  dialog->store = gtk_list_store_new (N_COLUMNS, G_TYPE_STRING, G_TYPE_OBJECT, G_TYPE_BOOLEAN);
-  gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (dialog->store), COLUMN_MODULE, bar_item_dialog_compare_func, NULL, NULL);
-  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (dialog->store), COLUMN_MODULE, GTK_SORT_ASCENDING);
+  /* the module store is kept up-to-date by the factory, so it does
+   * not have to be rebuilt every time the dialog is opened */
+  dialog->store = bar_module_factory_get_store (dialog->factory);
+
+  /* automatically sort the store */
+  sort = gtk_tree_model_sort_new_with_model (dialog->store);
+  gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (sort), BAR_MODULE_FACTORY_COLUMN_MODULE, bar_item_dialog_compare_func, NULL, NULL);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort), BAR_MODULE_FACTORY_COLUMN_MODULE, GTK_SORT_ASCENDING);
 
   /* create treemodel with filter */
-  filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (dialog->store), NULL);
+  filter = gtk_tree_model_filter_new (sort, NULL);
+  g_object_unref (G_OBJECT (sort));
   gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (filter), bar_item_dialog_visible_func, entry, NULL);
   g_signal_connect_swapped (G_OBJECT (entry), "changed", G_CALLBACK (gtk_tree_model_filter_refilter), filter);
 
@@ -271,7 +269,9 @@ bar_item_dialog_init (BarItemDialog *dialog)
 
   /* icon renderer */
   renderer = gtk_cell_renderer_pixbuf_new ();
-  column = gtk_tree_view_column_new_with_attributes ("", renderer, "icon-name", COLUMN_ICON_NAME, "sensitive", COLUMN_SENSITIVE, NULL);
+  column = gtk_tree_view_column_new ();
+  gtk_tree_view_column_pack_start (column, renderer, FALSE);
+  gtk_tree_view_column_set_cell_data_func (column, renderer, bar_item_dialog_icon_renderer, dialog, NULL);
   g_object_set (G_OBJECT (renderer), "stock-size", GTK_ICON_SIZE_DND, NULL);
   gtk_tree_view_append_column (GTK_TREE_VIEW (treeview), column);
 
@@ -279,12 +279,9 @@ bar_item_dialog_init (BarItemDialog *dialog)
   renderer = gtk_cell_renderer_text_new ();
   column = gtk_tree_view_column_new ();
   gtk_tree_view_column_pack_start (column, renderer, TRUE);
-  gtk_tree_view_column_set_cell_data_func (column, renderer, bar_item_dialog_text_renderer, NULL, NULL);
-  gtk_tree_view_column_set_attributes (column, renderer, "sensitive", COLUMN_SENSITIVE, NULL);
+  gtk_tree_view_column_set_cell_data_func (column, renderer, bar_item_dialog_text_renderer, dialog, NULL);
   g_object_set (G_OBJECT (renderer), "ellipsize", PANGO_ELLIPSIZE_END, NULL);
   gtk_tree_view_append_column (GTK_TREE_VIEW (treeview), column);
-
-  bar_item_dialog_populate_store (dialog);
 }
 
 
@@ -355,13 +352,9 @@ bar_item_dialog_unique_changed (BarModuleFactory *factory,
   bar_return_if_fail (BAR_IS_MODULE_FACTORY (factory));
   bar_return_if_fail (BAR_IS_MODULE (module));
   bar_return_if_fail (BAR_IS_ITEM_DIALOG (dialog));
-  bar_return_if_fail (GTK_IS_LIST_STORE (dialog->store));
 
-  /* search the module and update its sensitivity */
-  g_object_set_data (G_OBJECT (dialog->store), "dialog", dialog);
-  gtk_tree_model_foreach (GTK_TREE_MODEL (dialog->store),
-      bar_item_dialog_unique_changed_foreach, module);
-  g_object_set_data (G_OBJECT (dialog->store), "dialog", NULL);
+  /* the factory already emitted row-changed for the module, so
+   * the treeview redraws the row with the new sensitivity */
 
   /* update button sensitivity */
   bar_item_dialog_selection_changed (gtk_tree_view_get_selection (dialog->treeview), dialog);
@@ -369,47 +362,6 @@ bar_item_dialog_unique_changed (BarModuleFactory *factory,
 
 
 
-static gboolean
-bar_item_dialog_unique_changed_foreach (GtkTreeModel *model,
-                                          GtkTreePath  *path,
-                                          GtkTreeIter  *iter,
-                                          gpointer      user_data)
-{
-  BarModule *module;
-  gboolean     result;
-  GtkWidget   *dialog;
-
-  bar_return_val_if_fail (BAR_IS_MODULE (user_data), FALSE);
-
-  /* get the module of this iter */
-  gtk_tree_model_get (model, iter, COLUMN_MODULE, &module, -1);
-
-  /* skip the separator */
-  if (G_UNLIKELY (module == NULL))
-    return FALSE;
-
-  /* check if this is the module we're looking for */
-  result = !!(module == BAR_MODULE (user_data));
-
-  if (result)
-    {
-      dialog = g_object_get_data (G_OBJECT (model), "dialog");
-      bar_return_val_if_fail (BAR_IS_ITEM_DIALOG (dialog), FALSE);
-
-      /* update the module unique status */
-      gtk_list_store_set (GTK_LIST_STORE (model), iter,
-                          COLUMN_SENSITIVE, bar_module_is_usable (module,
-                              gtk_widget_get_screen (dialog)), -1);
-    }
-
-  g_object_unref (G_OBJECT (module));
-
-  /* continue searching or break if the module was found */
-  return result;
-}
-
-
-
 static gboolean
 bar_item_dialog_separator_func (GtkTreeModel *model,
                                   GtkTreeIter  *iter,
@@ -418,7 +370,7 @@ bar_item_dialog_separator_func (GtkTreeModel *model,
   BarModule *module;
 
   /* it's a separator if the module is null */
-  gtk_tree_model_get (model, iter, COLUMN_MODULE, &module, -1);
+  gtk_tree_model_get (model, iter, BAR_MODULE_FACTORY_COLUMN_MODULE, &module, -1);
   if (G_UNLIKELY (module == NULL))
     return TRUE;
   g_object_unref (G_OBJECT (module));
@@ -465,7 +417,7 @@ bar_item_dialog_get_selected_module (GtkTreeView *treeview)
     {
       if (gtk_tree_selection_get_selected (selection, &model, &iter))
         {
-          gtk_tree_model_get (model, &iter, COLUMN_MODULE, &module, -1);
+          gtk_tree_model_get (model, &iter, BAR_MODULE_FACTORY_COLUMN_MODULE, &module, -1);
           if (G_LIKELY (module != NULL))
             {
               /* check if the module is still valid */
@@ -580,41 +532,6 @@ bar_item_dialog_drag_data_received (GtkWidget        *treeview,
 
 
 
-static void
-bar_item_dialog_populate_store (BarItemDialog *dialog)
-{
-  GList       *modules, *li;
-  gint         n;
-  GtkTreeIter  iter;
-  BarModule *module;
-
-  bar_return_if_fail (BAR_IS_ITEM_DIALOG (dialog));
-  bar_return_if_fail (BAR_IS_MODULE_FACTORY (dialog->factory));
-  bar_return_if_fail (GTK_IS_LIST_STORE (dialog->store));
-
-  /* add all known modules in the factory */
-  modules = bar_module_factory_get_modules (dialog->factory);
-  for (li = modules, n = 0; li != NULL; li = li->next, n++)
-    {
-      module = BAR_MODULE (li->data);
-
-      gtk_list_store_insert_with_values (dialog->store, &iter, n,
-          COLUMN_MODULE, module,
-          COLUMN_ICON_NAME, bar_module_get_icon_name (module),
-          COLUMN_SENSITIVE, bar_module_is_usable (module,
-              gtk_widget_get_screen (GTK_WIDGET (dialog))), -1);
-    }
-
-  g_list_free (modules);
-
-  /* add an empty item for separator in 2nd position */
-  if (bar_module_factory_has_launcher (dialog->factory))
-    gtk_list_store_insert_with_values (dialog->store, &iter, 1,
-                                       COLUMN_MODULE, NULL, -1);
-}
-
-
-
 static gint
 bar_item_dialog_compare_func (GtkTreeModel *model,
                                 GtkTreeIter  *a,
@@ -628,26 +545,32 @@ bar_item_dialog_compare_func (GtkTreeModel *model,
   gint         result;
 
   /* get modules a name */
-  gtk_tree_model_get (model, a, COLUMN_MODULE, &module_a, -1);
-  gtk_tree_model_get (model, b, COLUMN_MODULE, &module_b, -1);
+  gtk_tree_model_get (model, a, BAR_MODULE_FACTORY_COLUMN_MODULE, &module_a, -1);
+  gtk_tree_model_get (model, b, BAR_MODULE_FACTORY_COLUMN_MODULE, &module_b, -1);
 
-  if (G_UNLIKELY (module_a == NULL || module_b == NULL))
+  if (G_UNLIKELY (module_a == module_b))
     {
-      /* don't move the separator */
       result = 0;
     }
-  else if (blxo_str_is_equal (LAUNCHER_PLUGIN_NAME,
-                             bar_module_get_name (module_a)))
+  else if (module_a != NULL
+           && blxo_str_is_equal (LAUNCHER_PLUGIN_NAME,
+                                 bar_module_get_name (module_a)))
     {
       /* move the launcher to the first position */
       result = -1;
     }
-  else if (blxo_str_is_equal (LAUNCHER_PLUGIN_NAME,
-                             bar_module_get_name (module_b)))
+  else if (module_b != NULL
+           && blxo_str_is_equal (LAUNCHER_PLUGIN_NAME,
+                                 bar_module_get_name (module_b)))
     {
       /* move the launcher to the first position */
       result = 1;
     }
+  else if (module_a == NULL || module_b == NULL)
+    {
+      /* the separator follows the launcher */
+      result = module_a == NULL ? -1 : 1;
+    }
   else
     {
       /* get the visible module names */
@@ -693,7 +616,7 @@ bar_item_dialog_visible_func (GtkTreeModel *model,
   if (G_UNLIKELY (blxo_str_is_empty (text)))
     return TRUE;
 
-  gtk_tree_model_get (model, iter, COLUMN_MODULE, &module, -1);
+  gtk_tree_model_get (model, iter, BAR_MODULE_FACTORY_COLUMN_MODULE, &module, -1);
 
   /* hide separator when searching */
   if (G_UNLIKELY (module == NULL))
@@ -743,6 +666,35 @@ bar_item_dialog_visible_func (GtkTreeModel *model,
 
 
 
+static void
+bar_item_dialog_icon_renderer (GtkTreeViewColumn *column,
+                                 GtkCellRenderer   *renderer,
+                                 GtkTreeModel      *model,
+                                 GtkTreeIter       *iter,
+                                 gpointer           user_data)
+{
+  BarItemDialog *dialog = BAR_ITEM_DIALOG (user_data);
+  BarModule     *module;
+  GdkScreen       *screen;
+
+  gtk_tree_model_get (model, iter, BAR_MODULE_FACTORY_COLUMN_MODULE, &module, -1);
+  if (G_UNLIKELY (module == NULL))
+    return;
+
+  /* the factory caches the icons, so this does not touch
+   * the model or the icon theme while the view draws */
+  screen = gtk_widget_get_screen (GTK_WIDGET (dialog));
+  g_object_set (G_OBJECT (renderer),
+                "pixbuf", bar_module_factory_lookup_icon (dialog->factory,
+                                                            module, screen),
+                "sensitive", bar_module_is_usable (module, screen),
+                NULL);
+
+  g_object_unref (G_OBJECT (module));
+}
+
+
+
 static void
 bar_item_dialog_text_renderer (GtkTreeViewColumn *column,
                                  GtkCellRenderer   *renderer,
@@ -750,11 +702,12 @@ bar_item_dialog_text_renderer (GtkTreeViewColumn *column,
                                  GtkTreeIter       *iter,
                                  gpointer           user_data)
 {
-  BarModule *module;
-  gchar       *markup;
-  const gchar *name, *comment;
+  BarItemDialog *dialog = BAR_ITEM_DIALOG (user_data);
+  BarModule     *module;
+  gchar           *markup;
+  const gchar     *name, *comment;
 
-  gtk_tree_model_get (model, iter, COLUMN_MODULE, &module, -1);
+  gtk_tree_model_get (model, iter, BAR_MODULE_FACTORY_COLUMN_MODULE, &module, -1);
   if (G_UNLIKELY (module == NULL))
     return;
 
@@ -765,7 +718,11 @@ bar_item_dialog_text_renderer (GtkTreeViewColumn *column,
 
   name = bar_module_get_display_name (module);
   markup = g_markup_printf_escaped ("<b>%s</b>\n%s", name, comment);
-  g_object_set (G_OBJECT (renderer), "markup", markup, NULL);
+  g_object_set (G_OBJECT (renderer),
+                "markup", markup,
+                "sensitive", bar_module_is_usable (module,
+                    gtk_widget_get_screen (GTK_WIDGET (dialog))),
+                NULL);
   g_free (markup);
 
   g_object_unref (G_OBJECT (module));
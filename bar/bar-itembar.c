@@ -26,9 +26,11 @@
 #include <blxo/blxo.h>
 
 #include <common/bar-private.h>
+#include <common/bar-trace.h>
 #include <libbladebar/libbladebar.h>
 
 #include <bar/bar-itembar.h>
+#include <bar/bar-profiler.h>
 
 #define IS_HORIZONTAL(itembar) ((itembar)->mode == BLADE_BAR_PLUGIN_MODE_HORIZONTAL)
 #define HIGHLIGHT_SIZE         2
@@ -317,6 +319,10 @@ bar_itembar_size_request (GtkWidget      *widget,
   gint               rows_size;
   gint               total_len;
   gint               child_len;
+  gint64             start = 0;
+  gboolean           profile = bar_profiler_is_enabled ();
+
+  bar_trace_begin ("itembar-request");
 
   /* total length we request */
   total_len = 0;
@@ -335,7 +341,11 @@ bar_itembar_size_request (GtkWidget      *widget,
             continue;
 
           /* get the child's size request */
+          if (G_UNLIKELY (profile))
+            start = bar_profiler_now ();
           gtk_widget_size_request (child->widget, &child_req);
+          if (G_UNLIKELY (profile))
+            bar_profiler_add (child->widget, BAR_PROFILER_SIZE_REQUEST, start);
 
           /* check if the small child fits in a row */
           if (child->option == CHILD_OPTION_SMALL
@@ -389,6 +399,8 @@ bar_itembar_size_request (GtkWidget      *widget,
       requisition->height = total_len + border_width;
       requisition->width = rows_size + border_width;
     }
+
+  bar_trace_end ("itembar-request");
 }
 
 
@@ -414,6 +426,10 @@ bar_itembar_size_allocate (GtkWidget     *widget,
   gint               row_max_size;
   gint               col_count;
   gint               rows_size;
+  gint64             start = 0;
+  gboolean           profile = bar_profiler_is_enabled ();
+
+  bar_trace_begin ("itembar-allocate");
 
   /* the maximum allocation is limited by that of the
    * bar window, so take over the assigned allocation */
@@ -674,8 +690,14 @@ bar_itembar_size_allocate (GtkWidget     *widget,
             }
         }
 
+      if (G_UNLIKELY (profile))
+        start = bar_profiler_now ();
       gtk_widget_size_allocate (child->widget, &child_alloc);
+      if (G_UNLIKELY (profile))
+        bar_profiler_add (child->widget, BAR_PROFILER_SIZE_ALLOCATE, start);
     }
+
+  bar_trace_end ("itembar-allocate");
 }
 
 
@@ -684,14 +706,30 @@ static gboolean
 bar_itembar_expose_event (GtkWidget      *widget,
                             GdkEventExpose *event)
 {
-  BarItembar *itembar = BAR_ITEMBAR (widget);
-  gboolean      result;
-  cairo_t      *cr;
-  GdkWindow    *window;
-  GdkRectangle  rect;
-  gint          row_size;
+  BarItembar      *itembar = BAR_ITEMBAR (widget);
+  cairo_t           *cr;
+  GdkWindow         *window;
+  GdkRectangle       rect;
+  gint               row_size;
+  GSList            *li;
+  BarItembarChild *child;
+  gint64             start = 0;
+  gboolean           profile = bar_profiler_is_enabled ();
 
-  result = (*GTK_WIDGET_CLASS (bar_itembar_parent_class)->expose_event) (widget, event);
+  /* what GtkContainer does, but measured per plugin; children with
+   * a window receive their own expose (see bar-profiler.c) */
+  for (li = itembar->children; li != NULL; li = li->next)
+    {
+      child = li->data;
+      if (child == NULL || !GTK_WIDGET_NO_WINDOW (child->widget))
+        continue;
+
+      if (G_UNLIKELY (profile))
+        start = bar_profiler_now ();
+      gtk_container_propagate_expose (GTK_CONTAINER (widget), child->widget, event);
+      if (G_UNLIKELY (profile))
+        bar_profiler_add (child->widget, BAR_PROFILER_EXPOSE, start);
+    }
 
   if (itembar->highlight_index != -1)
     {
@@ -728,7 +766,7 @@ bar_itembar_expose_event (GtkWidget      *widget,
       cairo_destroy (cr);
     }
 
-  return result;
+  return FALSE;
 }
 
 
@@ -33,6 +33,7 @@
 
 #include <common/bar-private.h>
 #include <common/bar-debug.h>
+#include <common/bar-trace.h>
 
 #include <libbladebar/libbladebar.h>
 
@@ -52,6 +53,11 @@ static gboolean bar_module_factory_modules_cleanup (gpointer                  ke
                                                       gpointer                  user_data);
 static void     bar_module_factory_remove_plugin   (gpointer                  user_data,
                                                       GObject                  *where_the_object_was);
+static void     bar_module_factory_store_insert    (BarModuleFactory       *factory,
+                                                      BarModule              *module);
+static void     bar_module_factory_store_remove    (BarModuleFactory       *factory,
+                                                      BarModule              *module);
+static void     bar_module_factory_icon_free       (gpointer                  data);
 
 
 
@@ -73,17 +79,42 @@ struct _BarModuleFactory
   /* relation for name -> BarModule */
   GHashTable *modules;
 
-  /* all plugins in all windows */
-  GSList     *plugins;
+  /* all plugins in all windows, indexed by module name (a list of
+   * plugins, oldest first) and by unique id */
+  GHashTable *plugins_by_name;
+  GHashTable *plugins_by_id;
 
   /* if the factory contains the launcher plugin */
   guint       has_launcher : 1;
+
+  /* persistent store of all modules for the item dialog, the
+   * rows are updated when modules are added or removed */
+  GtkListStore *store;
+  GHashTable   *store_rows;
+  GtkTreeIter   store_separator;
+  guint         has_separator : 1;
+
+  /* module icons for the item dialog by icon name, loaded from
+   * icons_theme, a NULL value remembers a missing icon */
+  GHashTable   *icons;
+  GtkIconTheme *icons_theme;
 };
 
 
 
+typedef struct
+{
+  BarModuleFactory *factory;
+  gchar            *name;
+  gint              unique_id;
+}
+FactoryPlugin;
+
+
+
 static guint    factory_signals[LAST_SIGNAL];
 static gboolean force_all_external = FALSE;
+static gboolean share_wrappers = FALSE;
 
 
 
@@ -119,6 +150,12 @@ bar_module_factory_init (BarModuleFactory *factory)
   factory->has_launcher = FALSE;
   factory->modules = g_hash_table_new_full (g_str_hash, g_str_equal,
                                             g_free, g_object_unref);
+  factory->plugins_by_name = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                    g_free, NULL);
+  factory->plugins_by_id = g_hash_table_new (g_direct_hash, g_direct_equal);
+  factory->icons = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                          g_free, bar_module_factory_icon_free);
+  factory->icons_theme = NULL;
 
   /* load all the modules */
   bar_module_factory_load_modules (factory, TRUE);
@@ -130,9 +167,30 @@ static void
 bar_module_factory_finalize (GObject *object)
 {
   BarModuleFactory *factory = BAR_MODULE_FACTORY (object);
+  GHashTableIter    iter;
+  gpointer          plugins;
 
   g_hash_table_destroy (factory->modules);
-  g_slist_free (factory->plugins);
+
+  g_hash_table_iter_init (&iter, factory->plugins_by_name);
+  while (g_hash_table_iter_next (&iter, NULL, &plugins))
+    g_slist_free (plugins);
+  g_hash_table_destroy (factory->plugins_by_name);
+  g_hash_table_destroy (factory->plugins_by_id);
+
+  if (factory->store != NULL)
+    {
+      g_hash_table_destroy (factory->store_rows);
+      g_object_unref (G_OBJECT (factory->store));
+    }
+
+  g_hash_table_destroy (factory->icons);
+  if (factory->icons_theme != NULL)
+    {
+      g_signal_handlers_disconnect_matched (G_OBJECT (factory->icons_theme),
+          G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, factory);
+      g_object_unref (G_OBJECT (factory->icons_theme));
+    }
 
   (*G_OBJECT_CLASS (bar_module_factory_parent_class)->finalize) (object);
 }
@@ -194,12 +252,14 @@ bar_module_factory_load_modules_dir (BarModuleFactory *factory,
       /* try to load the module */
       module = bar_module_new_from_desktop_file (filename,
                                                    internal_name,
-                                                   force_all_external);
+                                                   force_all_external,
+                                                   share_wrappers);
 
       if (G_LIKELY (module != NULL))
         {
           /* add the module to the internal list */
           g_hash_table_insert (factory->modules, internal_name, module);
+          bar_module_factory_store_insert (factory, module);
 
           /* check if this is the launcher */
           if (!factory->has_launcher)
@@ -225,9 +285,13 @@ bar_module_factory_load_modules (BarModuleFactory *factory,
 {
   bar_return_if_fail (BAR_IS_MODULE_FACTORY (factory));
 
+  bar_trace_begin ("load-modules");
+
   /* load from the new and old location */
   bar_module_factory_load_modules_dir (factory, BAR_PLUGINS_DATA_DIR, warn_if_known);
   bar_module_factory_load_modules_dir (factory, BAR_PLUGINS_DATA_DIR_OLD, warn_if_known);
+
+  bar_trace_end ("load-modules");
 }
 
 
@@ -247,11 +311,15 @@ bar_module_factory_modules_cleanup (gpointer key,
   /* check if the executable/library still exists */
   remove_from_table = !bar_module_is_valid (module);
 
-  /* if we're going to remove this item, check if it is the launcher */
-  if (remove_from_table
-      && blxo_str_is_equal (LAUNCHER_PLUGIN_NAME,
-                           bar_module_get_name (module)))
-    factory->has_launcher = FALSE;
+  if (remove_from_table)
+    {
+      /* check if it is the launcher */
+      if (blxo_str_is_equal (LAUNCHER_PLUGIN_NAME,
+                             bar_module_get_name (module)))
+        factory->has_launcher = FALSE;
+
+      bar_module_factory_store_remove (factory, module);
+    }
 
   return remove_from_table;
 }
@@ -262,30 +330,141 @@ static void
 bar_module_factory_remove_plugin (gpointer  user_data,
                                     GObject  *where_the_object_was)
 {
-  BarModuleFactory *factory = BAR_MODULE_FACTORY (user_data);
+  FactoryPlugin    *fp = user_data;
+  BarModuleFactory *factory = fp->factory;
+  GSList           *plugins, *li;
+
+  /* remove the plugin from the indexes, without asking the
+   * provider, it is already disposed */
+  g_hash_table_remove (factory->plugins_by_id, GINT_TO_POINTER (fp->unique_id));
+
+  plugins = g_hash_table_lookup (factory->plugins_by_name, fp->name);
+  li = g_slist_remove (plugins, where_the_object_was);
+  if (li == NULL)
+    g_hash_table_remove (factory->plugins_by_name, fp->name);
+  else if (li != plugins)
+    g_hash_table_insert (factory->plugins_by_name, g_strdup (fp->name), li);
+
+  g_free (fp->name);
+  g_slice_free (FactoryPlugin, fp);
+}
+
 
-  /* remove the plugin from the internal list */
-  factory->plugins = g_slist_remove (factory->plugins, where_the_object_was);
+
+static void
+bar_module_factory_store_row_free (gpointer data)
+{
+  g_slice_free (GtkTreeIter, data);
 }
 
 
 
-static inline gboolean
-bar_module_factory_unique_id_exists (BarModuleFactory *factory,
-                                       gint                unique_id)
+static void
+bar_module_factory_store_insert (BarModuleFactory *factory,
+                                   BarModule        *module)
 {
-  GSList *li;
+  GtkTreeIter iter;
+
+  if (factory->store == NULL)
+    return;
+
+  gtk_list_store_insert_with_values (factory->store, &iter, -1,
+                                     BAR_MODULE_FACTORY_COLUMN_MODULE, module, -1);
+
+  /* list store iters persist, so we can remember them */
+  g_hash_table_insert (factory->store_rows, module,
+                       g_slice_dup (GtkTreeIter, &iter));
+}
 
-  for (li = factory->plugins; li != NULL; li = li->next)
-    if (blade_bar_plugin_provider_get_unique_id (
-        BLADE_BAR_PLUGIN_PROVIDER (li->data)) == unique_id)
-      return TRUE;
+
+
+static void
+bar_module_factory_store_remove (BarModuleFactory *factory,
+                                   BarModule        *module)
+{
+  GtkTreeIter *iter;
+
+  if (factory->store == NULL)
+    return;
+
+  iter = g_hash_table_lookup (factory->store_rows, module);
+  if (G_LIKELY (iter != NULL))
+    {
+      gtk_list_store_remove (factory->store, iter);
+      g_hash_table_remove (factory->store_rows, module);
+    }
+}
+
+
+
+static void
+bar_module_factory_store_update_separator (BarModuleFactory *factory)
+{
+  bar_return_if_fail (GTK_IS_LIST_STORE (factory->store));
+
+  /* separator between the launcher and the other plugins */
+  if (factory->has_launcher && !factory->has_separator)
+    {
+      gtk_list_store_insert_with_values (factory->store, &factory->store_separator, -1,
+                                         BAR_MODULE_FACTORY_COLUMN_MODULE, NULL, -1);
+      factory->has_separator = TRUE;
+    }
+  else if (!factory->has_launcher && factory->has_separator)
+    {
+      gtk_list_store_remove (factory->store, &factory->store_separator);
+      factory->has_separator = FALSE;
+    }
+}
+
+
+
+static void
+bar_module_factory_icon_free (gpointer data)
+{
+  if (data != NULL)
+    g_object_unref (G_OBJECT (data));
+}
+
+
+
+static gboolean
+bar_module_factory_store_row_changed (GtkTreeModel *model,
+                                        GtkTreePath  *path,
+                                        GtkTreeIter  *iter,
+                                        gpointer      user_data)
+{
+  gtk_tree_model_row_changed (model, path, iter);
 
   return FALSE;
 }
 
 
 
+static void
+bar_module_factory_icon_theme_changed (BarModuleFactory *factory)
+{
+  bar_return_if_fail (BAR_IS_MODULE_FACTORY (factory));
+
+  /* drop the cached icons and let the views reload them */
+  g_hash_table_remove_all (factory->icons);
+
+  if (factory->store != NULL)
+    gtk_tree_model_foreach (GTK_TREE_MODEL (factory->store),
+        bar_module_factory_store_row_changed, NULL);
+}
+
+
+
+static inline gboolean
+bar_module_factory_unique_id_exists (BarModuleFactory *factory,
+                                       gint                unique_id)
+{
+  return g_hash_table_lookup (factory->plugins_by_id,
+                              GINT_TO_POINTER (unique_id)) != NULL;
+}
+
+
+
 BarModuleFactory *
 bar_module_factory_get (void)
 {
@@ -323,6 +502,17 @@ bar_module_factory_force_all_external (void)
 
 
 
+void
+bar_module_factory_share_wrappers (void)
+{
+  share_wrappers = TRUE;
+
+  bar_debug (BAR_DEBUG_MODULE_FACTORY,
+               "running trusted plugins in a shared wrapper");
+}
+
+
+
 gboolean
 bar_module_factory_has_launcher (BarModuleFactory *factory)
 {
@@ -337,10 +527,25 @@ void
 bar_module_factory_emit_unique_changed (BarModule *module)
 {
   BarModuleFactory *factory;
+  GtkTreeIter        *iter;
+  GtkTreePath        *path;
 
   bar_return_if_fail (BAR_IS_MODULE (module));
 
   factory = bar_module_factory_get ();
+
+  /* let views of the store update the sensitivity of the row */
+  if (factory->store != NULL)
+    {
+      iter = g_hash_table_lookup (factory->store_rows, module);
+      if (G_LIKELY (iter != NULL))
+        {
+          path = gtk_tree_model_get_path (GTK_TREE_MODEL (factory->store), iter);
+          gtk_tree_model_row_changed (GTK_TREE_MODEL (factory->store), path, iter);
+          gtk_tree_path_free (path);
+        }
+    }
+
   g_signal_emit (G_OBJECT (factory), factory_signals[UNIQUE_CHANGED], 0, module);
   g_object_unref (G_OBJECT (factory));
 
@@ -348,11 +553,26 @@ bar_module_factory_emit_unique_changed (BarModule *module)
 
 
 
-GList *
-bar_module_factory_get_modules (BarModuleFactory *factory)
+GtkTreeModel *
+bar_module_factory_get_store (BarModuleFactory *factory)
 {
+  GHashTableIter  iter;
+  gpointer        module;
+
   bar_return_val_if_fail (BAR_IS_MODULE_FACTORY (factory), NULL);
 
+  if (G_UNLIKELY (factory->store == NULL))
+    {
+      factory->store = gtk_list_store_new (BAR_MODULE_FACTORY_N_COLUMNS,
+                                           BAR_TYPE_MODULE);
+      factory->store_rows = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                                   NULL, bar_module_factory_store_row_free);
+
+      g_hash_table_iter_init (&iter, factory->modules);
+      while (g_hash_table_iter_next (&iter, NULL, &module))
+        bar_module_factory_store_insert (factory, BAR_MODULE (module));
+    }
+
   /* add new modules to the hash table */
   bar_module_factory_load_modules (factory, FALSE);
 
@@ -360,7 +580,59 @@ bar_module_factory_get_modules (BarModuleFactory *factory)
   g_hash_table_foreach_remove (factory->modules,
       bar_module_factory_modules_cleanup, factory);
 
-  return g_hash_table_get_values (factory->modules);
+  bar_module_factory_store_update_separator (factory);
+
+  return GTK_TREE_MODEL (g_object_ref (G_OBJECT (factory->store)));
+}
+
+
+
+GdkPixbuf *
+bar_module_factory_lookup_icon (BarModuleFactory *factory,
+                                  BarModule        *module,
+                                  GdkScreen          *screen)
+{
+  GtkIconTheme *theme;
+  const gchar  *icon_name;
+  gpointer      icon;
+  gint          size;
+
+  bar_return_val_if_fail (BAR_IS_MODULE_FACTORY (factory), NULL);
+  bar_return_val_if_fail (BAR_IS_MODULE (module), NULL);
+  bar_return_val_if_fail (GDK_IS_SCREEN (screen), NULL);
+
+  icon_name = bar_module_get_icon_name (module);
+  if (blxo_str_is_empty (icon_name))
+    return NULL;
+
+  /* the cache is only valid for the theme it was loaded from */
+  theme = gtk_icon_theme_get_for_screen (screen);
+  if (G_UNLIKELY (theme != factory->icons_theme))
+    {
+      if (factory->icons_theme != NULL)
+        {
+          g_signal_handlers_disconnect_by_func (G_OBJECT (factory->icons_theme),
+              G_CALLBACK (bar_module_factory_icon_theme_changed), factory);
+          g_object_unref (G_OBJECT (factory->icons_theme));
+        }
+
+      g_hash_table_remove_all (factory->icons);
+      factory->icons_theme = g_object_ref (G_OBJECT (theme));
+      g_signal_connect_swapped (G_OBJECT (theme), "changed",
+          G_CALLBACK (bar_module_factory_icon_theme_changed), factory);
+    }
+
+  if (g_hash_table_lookup_extended (factory->icons, icon_name, NULL, &icon))
+    return icon;
+
+  icon = NULL;
+  if (gtk_icon_size_lookup (GTK_ICON_SIZE_DND, &size, NULL))
+    icon = gtk_icon_theme_load_icon (theme, icon_name, size, 0, NULL);
+
+  /* also remember misses, so they are not looked up on every redraw */
+  g_hash_table_insert (factory->icons, g_strdup (icon_name), icon);
+
+  return icon;
 }
 
 
@@ -381,34 +653,41 @@ GSList *
 bar_module_factory_get_plugins (BarModuleFactory *factory,
                                   const gchar        *plugin_name)
 {
-  GSList *li, *plugins = NULL;
-  gchar  *unique_name;
+  GSList      *plugins;
+  const gchar *dash;
+  gchar       *end;
+  gint64       unique_id;
+  gpointer     provider;
 
   bar_return_val_if_fail (BAR_IS_MODULE_FACTORY (factory), NULL);
   bar_return_val_if_fail (plugin_name != NULL, NULL);
 
   /* first assume a global plugin name is provided (ie. no name with id) */
-  for (li = factory->plugins; li != NULL; li = li->next)
-    {
-      bar_return_val_if_fail (BLADE_IS_BAR_PLUGIN_PROVIDER (li->data), NULL);
-      if (strcmp (blade_bar_plugin_provider_get_name (li->data), plugin_name) == 0)
-        plugins = g_slist_prepend (plugins, li->data);
-    }
-
-  /* try the unique plugin name (with id) if nothing is found */
-  for (li = factory->plugins; plugins == NULL && li != NULL; li = li->next)
-    {
-      bar_return_val_if_fail (BLADE_IS_BAR_PLUGIN_PROVIDER (li->data), NULL);
-      unique_name = g_strdup_printf ("%s-%d", blade_bar_plugin_provider_get_name (li->data),
-                                     blade_bar_plugin_provider_get_unique_id (li->data));
-
-      if (strcmp (unique_name, plugin_name) == 0)
-        plugins = g_slist_prepend (plugins, li->data);
-
-      g_free (unique_name);
-    }
-
-  return plugins;
+  plugins = g_hash_table_lookup (factory->plugins_by_name, plugin_name);
+  if (plugins != NULL)
+    return g_slist_copy (plugins);
+
+  /* try the unique plugin name (name-id) if nothing is found */
+  dash = strrchr (plugin_name, '-');
+  if (dash == NULL || !g_ascii_isdigit (dash[1]))
+    return NULL;
+
+  unique_id = g_ascii_strtoll (dash + 1, &end, 10);
+  if (*end != '\0' || unique_id > G_MAXINT)
+    return NULL;
+
+  provider = g_hash_table_lookup (factory->plugins_by_id, GINT_TO_POINTER (unique_id));
+  if (provider == NULL)
+    return NULL;
+
+  /* check the name part of the unique name */
+  bar_return_val_if_fail (BLADE_IS_BAR_PLUGIN_PROVIDER (provider), NULL);
+  if (strncmp (blade_bar_plugin_provider_get_name (provider), plugin_name,
+               dash - plugin_name) != 0
+      || strlen (blade_bar_plugin_provider_get_name (provider)) != (gsize) (dash - plugin_name))
+    return NULL;
+
+  return g_slist_prepend (NULL, provider);
 }
 
 
@@ -421,9 +700,11 @@ bar_module_factory_new_plugin (BarModuleFactory  *factory,
                                  gchar              **arguments,
                                  gint                *return_unique_id)
 {
-  BarModule *module;
-  GtkWidget   *provider;
-  static gint  unique_id_counter = 0;
+  BarModule     *module;
+  GtkWidget     *provider;
+  static gint    unique_id_counter = 0;
+  FactoryPlugin *fp;
+  GSList        *plugins;
 
   bar_return_val_if_fail (BAR_IS_MODULE_FACTORY (factory), NULL);
   bar_return_val_if_fail (GDK_IS_SCREEN (screen), NULL);
@@ -449,11 +730,23 @@ bar_module_factory_new_plugin (BarModuleFactory  *factory,
   /* create the new module */
   provider = bar_module_new_plugin (module, screen, unique_id, arguments);
 
-  /* insert plugin in the list */
+  /* insert plugin in the indexes */
   if (G_LIKELY (provider))
     {
-      factory->plugins = g_slist_prepend (factory->plugins, provider);
-      g_object_weak_ref (G_OBJECT (provider), bar_module_factory_remove_plugin, factory);
+      g_hash_table_insert (factory->plugins_by_id, GINT_TO_POINTER (unique_id), provider);
+
+      plugins = g_hash_table_lookup (factory->plugins_by_name, name);
+      if (plugins == NULL)
+        g_hash_table_insert (factory->plugins_by_name, g_strdup (name),
+                             g_slist_prepend (NULL, provider));
+      else
+        plugins = g_slist_append (plugins, provider);
+
+      fp = g_slice_new (FactoryPlugin);
+      fp->factory = factory;
+      fp->name = g_strdup (name);
+      fp->unique_id = unique_id;
+      g_object_weak_ref (G_OBJECT (provider), bar_module_factory_remove_plugin, fp);
     }
 
   /* emit unique-changed if the plugin is unique */
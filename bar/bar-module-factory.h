@@ -38,17 +38,30 @@ typedef struct _BarModuleFactory      BarModuleFactory;
 
 #define LAUNCHER_PLUGIN_NAME "launcher"
 
+/* columns in the store of bar_module_factory_get_store() */
+enum
+{
+  BAR_MODULE_FACTORY_COLUMN_MODULE, /* NULL for the separator after the launcher */
+  BAR_MODULE_FACTORY_N_COLUMNS
+};
+
 GType               bar_module_factory_get_type            (void) G_GNUC_CONST;
 
 BarModuleFactory *bar_module_factory_get                 (void);
 
 void                bar_module_factory_force_all_external  (void);
 
+void                bar_module_factory_share_wrappers      (void);
+
 gboolean            bar_module_factory_has_launcher        (BarModuleFactory  *factory);
 
 void                bar_module_factory_emit_unique_changed (BarModule         *module);
 
-GList              *bar_module_factory_get_modules         (BarModuleFactory  *factory);
+GtkTreeModel       *bar_module_factory_get_store           (BarModuleFactory  *factory);
+
+GdkPixbuf          *bar_module_factory_lookup_icon         (BarModuleFactory  *factory,
+                                                              BarModule         *module,
+                                                              GdkScreen           *screen);
 
 gboolean            bar_module_factory_has_module          (BarModuleFactory  *factory,
                                                               const gchar         *name);
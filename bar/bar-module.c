@@ -50,6 +50,7 @@ static gboolean  bar_module_load             (GTypeModule      *type_module);
 static void      bar_module_unload           (GTypeModule      *type_module);
 static void      bar_module_plugin_destroyed (gpointer          user_data,
                                                 GObject          *where_the_plugin_was);
+static gboolean  bar_module_has_preinit      (const gchar      *filename);
 
 
 
@@ -80,6 +81,9 @@ struct _BarModule
   /* module type */
   BarModuleRunMode   mode;
 
+  /* wrapper plugins can share a host process */
+  guint                shared_wrapper : 1;
+
   /* filename to the library or executable
    * for an old 4.6 plugin */
   gchar               *filename;
@@ -298,10 +302,30 @@ bar_module_plugin_destroyed (gpointer  user_data,
 
 
 
+static gboolean
+bar_module_has_preinit (const gchar *filename)
+{
+  GModule  *library;
+  gpointer  foo;
+  gboolean  has_preinit;
+
+  library = g_module_open (filename, G_MODULE_BIND_LAZY | G_MODULE_BIND_LOCAL);
+  if (G_UNLIKELY (library == NULL))
+    return TRUE;
+
+  has_preinit = g_module_symbol (library, "blade_bar_module_preinit", &foo);
+  g_module_close (library);
+
+  return has_preinit;
+}
+
+
+
 BarModule *
 bar_module_new_from_desktop_file (const gchar *filename,
                                     const gchar *name,
-                                    gboolean     force_external)
+                                    gboolean     force_external,
+                                    gboolean     share_wrapper)
 {
   BarModule *module = NULL;
   XfceRc      *rc;
@@ -371,6 +395,24 @@ bar_module_new_from_desktop_file (const gchar *filename,
               module->mode = WRAPPER;
               g_free (module->api);
               module->api = g_strdup (xfce_rc_read_entry (rc, "X-XFCE-API", LIBBLADEBAR_VERSION_API));
+
+              /* only modules that are known to behave, they take
+               * down all other plugins in the host when they crash */
+              module->shared_wrapper = share_wrapper
+                  && xfce_rc_read_bool_entry (rc, "X-XFCE-Shared-Wrapper", FALSE);
+
+              /* a pre-init function has to run before gtk_init(), which
+               * is not possible in a host that already runs plugins; the
+               * library can only be checked if it uses our gtk version */
+              if (module->shared_wrapper
+                  && (g_strcmp0 (module->api, LIBBLADEBAR_VERSION_API) != 0
+                      || bar_module_has_preinit (path)))
+                {
+                  g_message ("Plugin %s: The module has a pre-init function or "
+                             "uses another API, it will not run in a shared "
+                             "wrapper.", name);
+                  module->shared_wrapper = FALSE;
+                }
             }
           else
             module->mode = INTERNAL;
@@ -629,6 +671,16 @@ bar_module_is_unique (BarModule *module)
 
 
 
+gboolean
+bar_module_use_shared_wrapper (BarModule *module)
+{
+  bar_return_val_if_fail (BAR_IS_MODULE (module), FALSE);
+
+  return module->shared_wrapper;
+}
+
+
+
 gboolean
 bar_module_is_usable (BarModule *module,
                         GdkScreen   *screen)
@@ -41,7 +41,8 @@ GType        bar_module_get_type                 (void) G_GNUC_CONST;
 
 BarModule *bar_module_new_from_desktop_file    (const gchar             *filename,
                                                     const gchar             *name,
-                                                    gboolean                 force_external) G_GNUC_MALLOC;
+                                                    gboolean                 force_external,
+                                                    gboolean                 share_wrapper) G_GNUC_MALLOC;
 
 GtkWidget   *bar_module_new_plugin               (BarModule             *module,
                                                     GdkScreen               *screen,
@@ -66,6 +67,8 @@ gboolean     bar_module_is_valid                 (BarModule             *module)
 
 gboolean     bar_module_is_unique                (BarModule             *module) G_GNUC_PURE;
 
+gboolean     bar_module_use_shared_wrapper       (BarModule             *module) G_GNUC_PURE;
+
 gboolean     bar_module_is_usable                (BarModule             *module,
                                                     GdkScreen               *screen);
 
@@ -287,6 +287,10 @@ bar_plugin_external_46_set_properties (BarPluginExternal *external,
           event.data.s[1] = 0;
           break;
 
+        case PROVIDER_PROP_TYPE_SET_HEARTBEAT_INTERVAL:
+          /* 4.6 plugins don't send heartbeats */
+          continue;
+
         default:
           g_critical ("Received unknown plugin property %u for %s-%d",
                       property->type, bar_module_get_name (external->module),
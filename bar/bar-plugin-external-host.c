@@ -0,0 +1,631 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * A wrapper host is a single wrapper process that runs several external
+ * plugins of modules that opted in with X-XFCE-Shared-Wrapper. There is
+ * one host per wrapper binary (plugin API) and display. Each plugin in the
+ * host keeps its own plug and D-Bus proxy, like in a normal wrapper; the
+ * pipes of the host are only used to add and remove plugins.
+ *
+ * For the BarPluginExternal the host behaves like a child process: the
+ * exit function of a plugin is called when the host reports the plugin
+ * left, or for all plugins when the host process died.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+
+#include <gtk/gtk.h>
+#include <libbladebar/blade-bar-plugin-provider.h>
+
+#include <common/bar-private.h>
+#include <common/bar-debug.h>
+
+#include <bar/bar-plugin-external-host.h>
+
+
+
+/* seconds an empty host is kept alive, so a restarting
+ * plugin does not spawn a new process */
+#define HOST_LINGER_TIME (5)
+
+
+
+typedef struct _BarPluginExternalHost BarPluginExternalHost;
+typedef struct _HostClient            HostClient;
+
+struct _BarPluginExternalHost
+{
+  /* wrapper binary and display name */
+  gchar   *key;
+
+  GPid     pid;
+  guint    child_watch_id;
+
+  /* commands to the host, the bytes the pipe did
+   * not accept yet are queued until it is writable */
+  gint     in_fd;
+  guint    in_watch_id;
+  GString *queue;
+
+  /* replies from the host */
+  gint     out_fd;
+  guint    out_watch_id;
+  GString *buffer;
+
+  /* plugins in this host */
+  GSList  *clients;
+
+  guint    linger_timeout_id;
+};
+
+struct _HostClient
+{
+  gint            unique_id;
+  GChildWatchFunc exited_func;
+  gpointer        user_data;
+};
+
+
+
+static GHashTable *hosts = NULL;
+
+
+
+static void
+bar_plugin_external_host_free (BarPluginExternalHost *host)
+{
+  bar_return_if_fail (host->clients == NULL);
+
+  if (host->linger_timeout_id != 0)
+    g_source_remove (host->linger_timeout_id);
+
+  if (host->in_watch_id != 0)
+    g_source_remove (host->in_watch_id);
+
+  if (host->out_watch_id != 0)
+    g_source_remove (host->out_watch_id);
+
+  if (host->child_watch_id != 0)
+    {
+      /* the host quits when its stdin is closed, don't leave zombies */
+      g_source_remove (host->child_watch_id);
+      g_child_watch_add (host->pid, (GChildWatchFunc) g_spawn_close_pid, NULL);
+    }
+
+  close (host->in_fd);
+  close (host->out_fd);
+
+  g_string_free (host->queue, TRUE);
+  g_string_free (host->buffer, TRUE);
+  g_free (host->key);
+  g_slice_free (BarPluginExternalHost, host);
+}
+
+
+
+static gboolean
+bar_plugin_external_host_linger (gpointer data)
+{
+  BarPluginExternalHost *host = data;
+
+  host->linger_timeout_id = 0;
+
+  if (host->clients == NULL)
+    {
+      bar_debug (BAR_DEBUG_EXTERNAL, "closing unused wrapper host %s; pid=%d",
+                 host->key, host->pid);
+
+      g_hash_table_remove (hosts, host->key);
+      bar_plugin_external_host_free (host);
+    }
+
+  return FALSE;
+}
+
+
+
+static void
+bar_plugin_external_host_linger_schedule (BarPluginExternalHost *host)
+{
+  if (host->clients == NULL && host->linger_timeout_id == 0)
+    host->linger_timeout_id = g_timeout_add_seconds (HOST_LINGER_TIME,
+        bar_plugin_external_host_linger, host);
+}
+
+
+
+static gboolean
+bar_plugin_external_host_flush (BarPluginExternalHost *host)
+{
+  gssize n;
+
+  /* libdbus already ignores SIGPIPE in the bar, so a dead
+   * host results in an error here and the child watch
+   * handles the rest */
+  while (host->queue->len > 0)
+    {
+      n = write (host->in_fd, host->queue->str, host->queue->len);
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            continue;
+
+          /* pipe is full, wait until the host read from it */
+          if (errno == EAGAIN)
+            return FALSE;
+
+          bar_debug (BAR_DEBUG_EXTERNAL, "failed to send %" G_GSIZE_FORMAT
+                     " bytes to wrapper host %s: %s", host->queue->len,
+                     host->key, g_strerror (errno));
+
+          g_string_truncate (host->queue, 0);
+          break;
+        }
+
+      g_string_erase (host->queue, 0, n);
+    }
+
+  return TRUE;
+}
+
+
+
+static gboolean
+bar_plugin_external_host_write (GIOChannel   *source,
+                                GIOCondition  condition,
+                                gpointer      data)
+{
+  BarPluginExternalHost *host = data;
+
+  if ((condition & (G_IO_HUP | G_IO_ERR)) != 0)
+    g_string_truncate (host->queue, 0);
+
+  if (!bar_plugin_external_host_flush (host))
+    return TRUE;
+
+  host->in_watch_id = 0;
+
+  return FALSE;
+}
+
+
+
+static void
+bar_plugin_external_host_send (BarPluginExternalHost  *host,
+                               const gchar           **strv)
+{
+  guint       i;
+  GIOChannel *channel;
+
+  g_string_append_printf (host->queue, "%u", g_strv_length ((gchar **) strv));
+  g_string_append_c (host->queue, '\0');
+
+  for (i = 0; strv[i] != NULL; i++)
+    g_string_append_len (host->queue, strv[i], strlen (strv[i]) + 1);
+
+  /* keep the message order if older messages are still queued */
+  if (host->in_watch_id != 0
+      || bar_plugin_external_host_flush (host))
+    return;
+
+  bar_debug (BAR_DEBUG_EXTERNAL, "wrapper host %s is busy, queued %" G_GSIZE_FORMAT
+             " bytes", host->key, host->queue->len);
+
+  channel = g_io_channel_unix_new (host->in_fd);
+  host->in_watch_id = g_io_add_watch (channel, G_IO_OUT | G_IO_HUP | G_IO_ERR,
+                                      bar_plugin_external_host_write, host);
+  g_io_channel_unref (channel);
+}
+
+
+
+static gboolean
+bar_plugin_external_host_parse (GString   *buffer,
+                                gchar   ***strv_return)
+{
+  const gchar *p = buffer->str;
+  const gchar *end = buffer->str + buffer->len;
+  const gchar *nul;
+  gchar      **strv;
+  guint        i, n;
+
+  /* number of strings in the message */
+  nul = memchr (p, '\0', end - p);
+  if (nul == NULL)
+    return FALSE;
+
+  n = strtoul (p, NULL, 10);
+  p = nul + 1;
+
+  strv = g_new0 (gchar *, n + 1);
+  for (i = 0; i < n; i++)
+    {
+      nul = memchr (p, '\0', end - p);
+      if (nul == NULL)
+        {
+          /* incomplete message */
+          g_strfreev (strv);
+          return FALSE;
+        }
+
+      strv[i] = g_strndup (p, nul - p);
+      p = nul + 1;
+    }
+
+  g_string_erase (buffer, 0, p - buffer->str);
+  *strv_return = strv;
+
+  return TRUE;
+}
+
+
+
+static void
+bar_plugin_external_host_exited (BarPluginExternalHost *host,
+                                 gint                   unique_id,
+                                 gint                   exit_code)
+{
+  GSList     *li;
+  HostClient *client;
+
+  for (li = host->clients; li != NULL; li = li->next)
+    {
+      client = li->data;
+      if (client->unique_id == unique_id)
+        break;
+    }
+
+  /* already removed by the bar */
+  if (li == NULL)
+    return;
+
+  host->clients = g_slist_delete_link (host->clients, li);
+
+  bar_debug (BAR_DEBUG_EXTERNAL, "plugin %d left wrapper host %s with status %d",
+             unique_id, host->key, exit_code);
+
+  /* fake a wait status, so the plugin handles this like a normal exit */
+  (*client->exited_func) (host->pid, (exit_code & 0xff) << 8, client->user_data);
+  g_slice_free (HostClient, client);
+
+  bar_plugin_external_host_linger_schedule (host);
+}
+
+
+
+static gboolean
+bar_plugin_external_host_read (GIOChannel   *source,
+                               GIOCondition  condition,
+                               gpointer      data)
+{
+  BarPluginExternalHost  *host = data;
+  gchar                   buf[256];
+  gssize                  n;
+  gchar                 **strv;
+
+  n = read (host->out_fd, buf, sizeof (buf));
+  if (n < 0 && (errno == EINTR || errno == EAGAIN))
+    return TRUE;
+
+  if (n <= 0)
+    {
+      /* host closed the pipe, the child watch will follow */
+      host->out_watch_id = 0;
+      return FALSE;
+    }
+
+  g_string_append_len (host->buffer, buf, n);
+
+  while (bar_plugin_external_host_parse (host->buffer, &strv))
+    {
+      if (g_strv_length (strv) == 3
+          && strcmp (strv[0], BAR_WRAPPER_HOST_EXITED) == 0)
+        bar_plugin_external_host_exited (host, strtol (strv[1], NULL, 10),
+                                         strtol (strv[2], NULL, 10));
+
+      g_strfreev (strv);
+    }
+
+  return TRUE;
+}
+
+
+
+static void
+bar_plugin_external_host_child_watch (GPid     pid,
+                                      gint     status,
+                                      gpointer data)
+{
+  BarPluginExternalHost *host = data;
+  GSList                *clients, *li;
+  HostClient            *client;
+
+  bar_debug (BAR_DEBUG_EXTERNAL, "wrapper host %s exited with status %d",
+             host->key, status);
+
+  /* forget the host before the plugins respawn */
+  host->child_watch_id = 0;
+  g_hash_table_remove (hosts, host->key);
+
+  clients = host->clients;
+  host->clients = NULL;
+
+  /* every plugin in the host exited with the same status */
+  for (li = clients; li != NULL; li = li->next)
+    {
+      client = li->data;
+      (*client->exited_func) (pid, status, client->user_data);
+      g_slice_free (HostClient, client);
+    }
+
+  g_slist_free (clients);
+
+  bar_plugin_external_host_free (host);
+  g_spawn_close_pid (pid);
+}
+
+
+
+static void
+bar_plugin_external_host_child_setup (gpointer data)
+{
+  /* this is what gdk_spawn_on_screen does */
+  g_setenv ("DISPLAY", data, TRUE);
+}
+
+
+
+static BarPluginExternalHost *
+bar_plugin_external_host_get (const gchar  *wrapper,
+                              GdkScreen    *screen,
+                              GError      **error)
+{
+  BarPluginExternalHost *host;
+  gchar                 *display_name;
+  gchar                 *key;
+  gchar                 *argv[3];
+  GPid                   pid;
+  gint                   in_fd, out_fd;
+  GIOChannel            *channel;
+
+  display_name = gdk_screen_make_display_name (screen);
+  key = g_strconcat (wrapper, " ", display_name, NULL);
+
+  if (G_UNLIKELY (hosts == NULL))
+    hosts = g_hash_table_new (g_str_hash, g_str_equal);
+
+  host = g_hash_table_lookup (hosts, key);
+  if (host != NULL)
+    {
+      g_free (display_name);
+      g_free (key);
+
+      return host;
+    }
+
+  argv[0] = (gchar *) wrapper;
+  argv[1] = BAR_WRAPPER_HOST_ARGUMENT;
+  argv[2] = NULL;
+
+  if (!g_spawn_async_with_pipes (NULL, argv, NULL, G_SPAWN_DO_NOT_REAP_CHILD,
+                                 bar_plugin_external_host_child_setup, display_name,
+                                 &pid, &in_fd, &out_fd, NULL, error))
+    {
+      g_free (display_name);
+      g_free (key);
+
+      return NULL;
+    }
+
+  g_free (display_name);
+
+  host = g_slice_new0 (BarPluginExternalHost);
+  host->key = key;
+  host->pid = pid;
+  host->in_fd = in_fd;
+  host->out_fd = out_fd;
+  host->queue = g_string_sized_new (256);
+  host->buffer = g_string_new (NULL);
+
+  /* never block the bar on a busy host */
+  fcntl (in_fd, F_SETFL, fcntl (in_fd, F_GETFL) | O_NONBLOCK);
+
+  channel = g_io_channel_unix_new (out_fd);
+  host->out_watch_id = g_io_add_watch (channel, G_IO_IN | G_IO_HUP | G_IO_ERR,
+                                       bar_plugin_external_host_read, host);
+  g_io_channel_unref (channel);
+
+  host->child_watch_id = g_child_watch_add_full (G_PRIORITY_LOW, pid,
+                                                 bar_plugin_external_host_child_watch,
+                                                 host, NULL);
+
+  g_hash_table_insert (hosts, host->key, host);
+
+  bar_debug (BAR_DEBUG_EXTERNAL, "spawned wrapper host %s; pid=%d", key, pid);
+
+  return host;
+}
+
+
+
+static gboolean
+bar_plugin_external_host_find_pid (gpointer key,
+                                   gpointer value,
+                                   gpointer data)
+{
+  return ((BarPluginExternalHost *) value)->pid == GPOINTER_TO_INT (data);
+}
+
+
+
+static BarPluginExternalHost *
+bar_plugin_external_host_lookup (GPid pid)
+{
+  if (G_UNLIKELY (hosts == NULL))
+    return NULL;
+
+  return g_hash_table_find (hosts, bar_plugin_external_host_find_pid,
+                            GINT_TO_POINTER (pid));
+}
+
+
+
+/**
+ * bar_plugin_external_host_add_plugin:
+ * @screen      : screen of the plugin.
+ * @argv        : wrapper argv of the plugin.
+ * @exited_func : called with a wait status when the plugin left the host.
+ * @user_data   : data for @exited_func.
+ * @pid         : return location for the pid of the host.
+ * @error       : return location for errors.
+ *
+ * Starts the plugin in the wrapper host of the screen, spawning
+ * the host if needed.
+ *
+ * Returns: %TRUE if the plugin was sent to the host.
+ **/
+gboolean
+bar_plugin_external_host_add_plugin (GdkScreen        *screen,
+                                     gchar           **argv,
+                                     GChildWatchFunc   exited_func,
+                                     gpointer          user_data,
+                                     GPid             *pid,
+                                     GError          **error)
+{
+  BarPluginExternalHost  *host;
+  HostClient             *client;
+  const gchar           **command;
+  guint                   i, argc;
+
+  bar_return_val_if_fail (GDK_IS_SCREEN (screen), FALSE);
+  bar_return_val_if_fail (argv != NULL, FALSE);
+  bar_return_val_if_fail (exited_func != NULL, FALSE);
+
+  argc = g_strv_length (argv);
+  bar_return_val_if_fail (argc >= PLUGIN_ARGV_ARGUMENTS, FALSE);
+
+  host = bar_plugin_external_host_get (argv[PLUGIN_ARGV_0], screen, error);
+  if (G_UNLIKELY (host == NULL))
+    return FALSE;
+
+  if (host->linger_timeout_id != 0)
+    {
+      g_source_remove (host->linger_timeout_id);
+      host->linger_timeout_id = 0;
+    }
+
+  client = g_slice_new0 (HostClient);
+  client->unique_id = strtol (argv[PLUGIN_ARGV_UNIQUE_ID], NULL, 10);
+  client->exited_func = exited_func;
+  client->user_data = user_data;
+  host->clients = g_slist_prepend (host->clients, client);
+
+  /* the host reads the plugin argv with the command instead of the binary */
+  command = g_new (const gchar *, argc + 1);
+  command[0] = BAR_WRAPPER_HOST_ADD;
+  for (i = 1; i <= argc; i++)
+    command[i] = argv[i];
+
+  bar_plugin_external_host_send (host, command);
+  g_free (command);
+
+  *pid = host->pid;
+
+  return TRUE;
+}
+
+
+
+void
+bar_plugin_external_host_quit_plugin (GPid     pid,
+                                      gint     unique_id,
+                                      gboolean restart)
+{
+  BarPluginExternalHost *host;
+  const gchar           *command[4];
+  gchar                  id[16];
+
+  host = bar_plugin_external_host_lookup (pid);
+  if (G_UNLIKELY (host == NULL))
+    return;
+
+  g_snprintf (id, sizeof (id), "%d", unique_id);
+
+  command[0] = BAR_WRAPPER_HOST_QUIT;
+  command[1] = id;
+  command[2] = restart ? "1" : "0";
+  command[3] = NULL;
+
+  bar_plugin_external_host_send (host, command);
+}
+
+
+
+/**
+ * bar_plugin_external_host_remove_plugin:
+ * @pid       : pid of the host.
+ * @unique_id : unique id of the plugin.
+ *
+ * Stops the plugin in the host without calling its exit function,
+ * used when the plugin is destroyed in the bar.
+ **/
+void
+bar_plugin_external_host_remove_plugin (GPid pid,
+                                        gint unique_id)
+{
+  BarPluginExternalHost *host;
+  GSList                *li;
+  HostClient            *client;
+
+  host = bar_plugin_external_host_lookup (pid);
+  if (G_UNLIKELY (host == NULL))
+    return;
+
+  for (li = host->clients; li != NULL; li = li->next)
+    {
+      client = li->data;
+      if (client->unique_id == unique_id)
+        {
+          host->clients = g_slist_delete_link (host->clients, li);
+          g_slice_free (HostClient, client);
+          break;
+        }
+    }
+
+  bar_plugin_external_host_quit_plugin (pid, unique_id, FALSE);
+  bar_plugin_external_host_linger_schedule (host);
+}
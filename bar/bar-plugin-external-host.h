@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __BAR_PLUGIN_EXTERNAL_HOST_H__
+#define __BAR_PLUGIN_EXTERNAL_HOST_H__
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+gboolean bar_plugin_external_host_add_plugin    (GdkScreen        *screen,
+                                                 gchar           **argv,
+                                                 GChildWatchFunc   exited_func,
+                                                 gpointer          user_data,
+                                                 GPid             *pid,
+                                                 GError          **error);
+
+void     bar_plugin_external_host_quit_plugin   (GPid              pid,
+                                                 gint              unique_id,
+                                                 gboolean          restart);
+
+void     bar_plugin_external_host_remove_plugin (GPid              pid,
+                                                 gint              unique_id);
+
+G_END_DECLS
+
+#endif /* !__BAR_PLUGIN_EXTERNAL_HOST_H__ */
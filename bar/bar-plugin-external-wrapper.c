@@ -72,6 +72,8 @@ static gboolean   bar_plugin_external_wrapper_dbus_remote_event_result (BarPlugi
                                                                           guint                           handle,
                                                                           gboolean                        result,
                                                                           GError                        **error);
+static gboolean   bar_plugin_external_wrapper_dbus_heartbeat           (BarPluginExternalWrapper     *external,
+                                                                          GError                        **error);
 
 
 
@@ -362,6 +364,19 @@ bar_plugin_external_wrapper_dbus_remote_event_result (BarPluginExternalWrapper
 
 
 
+static gboolean
+bar_plugin_external_wrapper_dbus_heartbeat (BarPluginExternalWrapper  *external,
+                                              GError                     **error)
+{
+  bar_return_val_if_fail (BAR_IS_PLUGIN_EXTERNAL (external), FALSE);
+
+  bar_plugin_external_heartbeat (BAR_PLUGIN_EXTERNAL (external));
+
+  return TRUE;
+}
+
+
+
 GtkWidget *
 bar_plugin_external_wrapper_new (BarModule  *module,
                                    gint          unique_id,
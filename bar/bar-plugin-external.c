@@ -29,6 +29,15 @@
 #ifdef HAVE_SYS_WAIT_H
 #include <sys/wait.h>
 #endif
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 #include <blxo/blxo.h>
 #include <gdk/gdk.h>
@@ -40,6 +49,7 @@
 #include <common/bar-private.h>
 #include <common/bar-dbus.h>
 #include <common/bar-debug.h>
+#include <common/bar-trace.h>
 
 #include <libbladebar/libbladebar.h>
 #include <libbladebar/blade-bar-plugin-provider.h>
@@ -47,11 +57,21 @@
 #include <bar/bar-module.h>
 #include <bar/bar-plugin-external.h>
 #include <bar/bar-plugin-external-46.h>
+#include <bar/bar-plugin-external-host.h>
 #include <bar/bar-window.h>
 #include <bar/bar-dialogs.h>
 
 
 
+/* seconds between two resource samples of the child */
+#define MONITOR_INTERVAL (10)
+
+/* number of samples in a row the cpu or memory limit of the
+ * watchdog has to be exceeded before the child is restarted */
+#define WATCHDOG_STRIKES (3)
+
+
+
 static void         bar_plugin_external_provider_init           (BladeBarPluginProviderInterface *iface);
 static void         bar_plugin_external_finalize                (GObject                          *object);
 static void         bar_plugin_external_get_property            (GObject                          *object,
@@ -73,6 +93,8 @@ static void         bar_plugin_external_child_watch             (GPid
                                                                    gint                              status,
                                                                    gpointer                          user_data);
 static void         bar_plugin_external_child_watch_destroyed   (gpointer                          user_data);
+static void         bar_plugin_external_monitor_start           (BarPluginExternal              *external);
+static void         bar_plugin_external_monitor_stop            (BarPluginExternal              *external);
 static void         bar_plugin_external_queue_free              (BarPluginExternal              *external);
 static void         bar_plugin_external_queue_send_to_child     (BarPluginExternal              *external);
 static void         bar_plugin_external_queue_add               (BarPluginExternal              *external,
@@ -114,6 +136,9 @@ struct _BarPluginExternalPrivate
 
   guint       embedded : 1;
 
+  /* running in a shared wrapper host */
+  guint       shared_host : 1;
+
   /* dbus message queue */
   GSList     *queue;
 
@@ -126,6 +151,17 @@ struct _BarPluginExternalPrivate
 
   /* delayed spawning */
   guint       spawn_timeout_id;
+
+  /* resource accounting of the child */
+  guint       monitor_timeout_id;
+  GTimer     *cpu_timer;
+  guint64     cpu_ticks;
+  guint       cpu_permille;
+  guint       rss_kb;
+  guint       watchdog_strikes;
+
+  /* time since the last heartbeat of the wrapper */
+  GTimer     *heartbeat_timer;
 };
 
 enum
@@ -138,6 +174,13 @@ enum
 
 
 
+/* watchdog limits, zero disables a check */
+static guint watchdog_cpu_percent = 0;
+static guint watchdog_rss_kb = 0;
+static guint watchdog_stall_seconds = 0;
+
+
+
 G_DEFINE_ABSTRACT_TYPE_WITH_CODE (BarPluginExternal, bar_plugin_external, GTK_TYPE_SOCKET,
   G_IMPLEMENT_INTERFACE (XFCE_TYPE_BAR_PLUGIN_PROVIDER, bar_plugin_external_provider_init))
 
@@ -208,6 +251,9 @@ bar_plugin_external_init (BarPluginExternal *external)
   external->priv->embedded = FALSE;
   external->priv->pid = 0;
   external->priv->spawn_timeout_id = 0;
+  external->priv->monitor_timeout_id = 0;
+  external->priv->cpu_timer = NULL;
+  external->priv->heartbeat_timer = NULL;
 
   /* signal to pass gtk_widget_set_sensitive() changes to the remote window */
   g_signal_connect (G_OBJECT (external), "notify::sensitive",
@@ -246,7 +292,16 @@ bar_plugin_external_finalize (GObject *object)
   if (external->priv->spawn_timeout_id != 0)
     g_source_remove (external->priv->spawn_timeout_id);
 
-  if (external->priv->watch_id != 0)
+  bar_plugin_external_monitor_stop (external);
+
+  if (external->priv->shared_host)
+    {
+      /* stop the plugin in the host, the host is not ours to reap */
+      if (external->priv->pid != 0)
+        bar_plugin_external_host_remove_plugin (external->priv->pid,
+                                                external->unique_id);
+    }
+  else if (external->priv->watch_id != 0)
     {
       /* remove the child watch and don't leave zombies */
       g_source_remove (external->priv->watch_id);
@@ -363,6 +418,8 @@ bar_plugin_external_unrealize (GtkWidget *widget)
     {
       if (external->priv->embedded)
         bar_plugin_external_queue_add_action (external, PROVIDER_PROP_TYPE_ACTION_QUIT);
+      else if (external->priv->shared_host)
+        bar_plugin_external_host_quit_plugin (external->priv->pid, external->unique_id, FALSE);
       else
         kill (external->priv->pid, SIGTERM);
     }
@@ -384,6 +441,10 @@ bar_plugin_external_plug_added (GtkSocket *socket)
 
   external->priv->embedded = TRUE;
 
+  bar_trace_async_end (external->unique_id, "embed %s-%d",
+                       bar_module_get_name (external->module),
+                       external->unique_id);
+
   bar_debug (BAR_DEBUG_EXTERNAL,
                "%s-%d: child is embedded; %d properties in queue",
                bar_module_get_name (external->module),
@@ -519,6 +580,8 @@ bar_plugin_external_child_spawn (BarPluginExternal *external)
   guint          i;
   gint           tmp_argc;
   GTimeVal       timestamp;
+  gboolean       shared_host = FALSE;
+  GValue         value = { 0, };
 
   bar_return_if_fail (BAR_IS_PLUGIN_EXTERNAL (external));
   bar_return_if_fail (GTK_WIDGET_REALIZED (external));
@@ -600,11 +663,30 @@ bar_plugin_external_child_spawn (BarPluginExternal *external)
       g_free (program);
       g_free (cmd_line);
     }
+  else if (bar_module_use_shared_wrapper (external->module))
+    {
+      /* debugging always runs in a separate process */
+      shared_host = TRUE;
+    }
+
+  /* the embed span ends when the wrapper's plug is added to the socket */
+  bar_trace_async_begin (external->unique_id, "embed %s-%d",
+                         bar_module_get_name (external->module),
+                         external->unique_id);
 
   /* spawn the proccess */
-  succeed = g_spawn_async (NULL, argv, NULL, G_SPAWN_DO_NOT_REAP_CHILD,
-                           bar_plugin_external_child_spawn_child_setup,
-                           external, &pid, &error);
+  bar_trace_begin ("spawn %s-%d", bar_module_get_name (external->module),
+                   external->unique_id);
+  if (shared_host)
+    succeed = bar_plugin_external_host_add_plugin (gtk_widget_get_screen (GTK_WIDGET (external)),
+                                                   argv, bar_plugin_external_child_watch,
+                                                   external, &pid, &error);
+  else
+    succeed = g_spawn_async (NULL, argv, NULL, G_SPAWN_DO_NOT_REAP_CHILD,
+                             bar_plugin_external_child_spawn_child_setup,
+                             external, &pid, &error);
+  bar_trace_end ("spawn %s-%d", bar_module_get_name (external->module),
+                 external->unique_id);
 
   bar_debug (BAR_DEBUG_EXTERNAL,
                "%s-%d: child spawned; pid=%d, argc=%d",
@@ -613,16 +695,39 @@ bar_plugin_external_child_spawn (BarPluginExternal *external)
 
   if (G_LIKELY (succeed))
     {
-      /* watch the child */
       external->priv->pid = pid;
-      external->priv->watch_id = g_child_watch_add_full (G_PRIORITY_LOW, pid,
-                                                         bar_plugin_external_child_watch, external,
-                                                         bar_plugin_external_child_watch_destroyed);
+      external->priv->shared_host = shared_host;
+
+      /* the debuggers would only confuse the watchdog */
+      if (!bar_debug_has_domain (BAR_DEBUG_GDB)
+          && !bar_debug_has_domain (BAR_DEBUG_VALGRIND))
+        bar_plugin_external_monitor_start (external);
+
+      /* only ask for heartbeats if the watchdog checks for stalls */
+      if (external->priv->monitor_timeout_id != 0
+          && watchdog_stall_seconds > 0)
+        {
+          g_value_init (&value, G_TYPE_INT);
+          g_value_set_int (&value, BAR_PLUGIN_HEARTBEAT_INTERVAL);
+          bar_plugin_external_queue_add (external, PROVIDER_PROP_TYPE_SET_HEARTBEAT_INTERVAL,
+                                         &value);
+          g_value_unset (&value);
+        }
+
+      /* watch the child, the host calls the child watch itself */
+      if (!shared_host)
+        external->priv->watch_id = g_child_watch_add_full (G_PRIORITY_LOW, pid,
+                                                           bar_plugin_external_child_watch, external,
+                                                           bar_plugin_external_child_watch_destroyed);
     }
   else
     {
       g_critical ("Failed to spawn the blade-bar-wrapper: %s", error->message);
       g_error_free (error);
+
+      bar_trace_async_end (external->unique_id, "embed %s-%d",
+                           bar_module_get_name (external->module),
+                           external->unique_id);
     }
 
   g_strfreev (argv);
@@ -709,6 +814,8 @@ bar_plugin_external_child_watch (GPid     pid,
   external->priv->pid = 0;
   external->priv->embedded = FALSE;
 
+  bar_plugin_external_monitor_stop (external);
+
   bar_debug (BAR_DEBUG_EXTERNAL,
                "%s-%d: child exited with status %d",
                bar_module_get_name (external->module),
@@ -781,6 +888,244 @@ bar_plugin_external_child_watch_destroyed (gpointer user_data)
 
 
 
+static gboolean
+bar_plugin_external_monitor_read (GPid     pid,
+                                  guint64 *cpu_ticks,
+                                  guint   *rss_kb)
+{
+  gchar    path[64];
+  gchar   *contents;
+  gchar   *p;
+  gulong   utime, stime;
+  gulong   size, resident;
+  gboolean succeed = FALSE;
+
+  /* user and system time in clock ticks, the fields after the
+   * command name (which can contain spaces) start with the state */
+  g_snprintf (path, sizeof (path), "/proc/%d/stat", (gint) pid);
+  if (!g_file_get_contents (path, &contents, NULL, NULL))
+    return FALSE;
+
+  p = strrchr (contents, ')');
+  if (p != NULL
+      && sscanf (p + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+                 &utime, &stime) == 2)
+    {
+      *cpu_ticks = (guint64) utime + stime;
+      succeed = TRUE;
+    }
+
+  g_free (contents);
+
+  if (!succeed)
+    return FALSE;
+
+  /* resident set size in pages */
+  g_snprintf (path, sizeof (path), "/proc/%d/statm", (gint) pid);
+  if (!g_file_get_contents (path, &contents, NULL, NULL))
+    return FALSE;
+
+  succeed = sscanf (contents, "%lu %lu", &size, &resident) == 2;
+  if (succeed)
+    *rss_kb = resident * (sysconf (_SC_PAGESIZE) / 1024);
+
+  g_free (contents);
+
+  return succeed;
+}
+
+
+
+static guint
+bar_plugin_external_monitor_get_stall (BarPluginExternal *external)
+{
+  gdouble elapsed;
+
+  /* old wrappers and 4.6 plugins never send a heartbeat */
+  if (external->priv->heartbeat_timer == NULL)
+    return 0;
+
+  elapsed = g_timer_elapsed (external->priv->heartbeat_timer, NULL);
+  if (elapsed <= BAR_PLUGIN_HEARTBEAT_INTERVAL)
+    return 0;
+
+  return elapsed - BAR_PLUGIN_HEARTBEAT_INTERVAL;
+}
+
+
+
+static gboolean
+bar_plugin_external_monitor_sample (BarPluginExternal *external)
+{
+  guint64 cpu_ticks;
+  guint   rss_kb;
+  gdouble elapsed;
+
+  if (!bar_plugin_external_monitor_read (external->priv->pid, &cpu_ticks, &rss_kb))
+    return FALSE;
+
+  /* average cpu usage since the previous sample */
+  if (external->priv->cpu_timer != NULL)
+    {
+      elapsed = g_timer_elapsed (external->priv->cpu_timer, NULL);
+      if (elapsed > 0.0 && cpu_ticks >= external->priv->cpu_ticks)
+        external->priv->cpu_permille = (cpu_ticks - external->priv->cpu_ticks) * 1000
+                                       / (elapsed * sysconf (_SC_CLK_TCK));
+
+      g_timer_start (external->priv->cpu_timer);
+    }
+  else
+    {
+      external->priv->cpu_timer = g_timer_new ();
+    }
+
+  external->priv->cpu_ticks = cpu_ticks;
+  external->priv->rss_kb = rss_kb;
+
+  return TRUE;
+}
+
+
+
+static inline gboolean
+bar_plugin_external_monitor_has_limits (void)
+{
+  return watchdog_cpu_percent > 0 || watchdog_rss_kb > 0;
+}
+
+
+
+static gboolean
+bar_plugin_external_monitor (gpointer user_data)
+{
+  BarPluginExternal *external = BAR_PLUGIN_EXTERNAL (user_data);
+  guint              stall;
+  const gchar       *reason = NULL;
+
+  bar_return_val_if_fail (BAR_IS_PLUGIN_EXTERNAL (external), FALSE);
+  bar_return_val_if_fail (external->priv->pid != 0, FALSE);
+
+  /* reading /proc is only needed for the cpu and memory limits */
+  if (bar_plugin_external_monitor_has_limits ()
+      && !bar_plugin_external_monitor_sample (external))
+    return TRUE;
+
+  stall = bar_plugin_external_monitor_get_stall (external);
+
+  bar_debug (BAR_DEBUG_EXTERNAL,
+               "%s-%d: cpu=%u.%u%%, rss=%ukB, stall=%us",
+               bar_module_get_name (external->module),
+               external->unique_id,
+               external->priv->cpu_permille / 10,
+               external->priv->cpu_permille % 10,
+               external->priv->rss_kb, stall);
+
+  if (watchdog_stall_seconds > 0
+      && stall >= watchdog_stall_seconds)
+    {
+      g_message ("Plugin %s-%d stopped responding for %u seconds, restarting it.",
+                 bar_module_get_name (external->module),
+                 external->unique_id, stall);
+
+      /* a stalled child does not handle a quit request, SIGUSR1 is
+       * handled as a requested restart in the child watch; this
+       * kills all plugins in a shared host */
+      g_timer_destroy (external->priv->heartbeat_timer);
+      external->priv->heartbeat_timer = NULL;
+      kill (external->priv->pid, SIGUSR1);
+
+      return TRUE;
+    }
+
+  /* the cpu and memory usage of a shared host are not of this plugin */
+  if (external->priv->shared_host
+      || !bar_plugin_external_monitor_has_limits ())
+    return TRUE;
+
+  if (watchdog_cpu_percent > 0
+      && external->priv->cpu_permille >= watchdog_cpu_percent * 10)
+    reason = "used too much CPU time";
+  else if (watchdog_rss_kb > 0
+           && external->priv->rss_kb >= watchdog_rss_kb)
+    reason = "used too much memory";
+
+  if (reason == NULL)
+    {
+      external->priv->watchdog_strikes = 0;
+    }
+  else if (++external->priv->watchdog_strikes >= WATCHDOG_STRIKES)
+    {
+      g_message ("Plugin %s-%d %s (cpu %u.%u%%, %u kB), restarting it.",
+                 bar_module_get_name (external->module),
+                 external->unique_id, reason,
+                 external->priv->cpu_permille / 10,
+                 external->priv->cpu_permille % 10,
+                 external->priv->rss_kb);
+
+      external->priv->watchdog_strikes = 0;
+      bar_plugin_external_restart (external);
+    }
+
+  return TRUE;
+}
+
+
+
+static void
+bar_plugin_external_monitor_destroyed (gpointer user_data)
+{
+  BAR_PLUGIN_EXTERNAL (user_data)->priv->monitor_timeout_id = 0;
+}
+
+
+
+static void
+bar_plugin_external_monitor_start (BarPluginExternal *external)
+{
+  bar_return_if_fail (BAR_IS_PLUGIN_EXTERNAL (external));
+  bar_return_if_fail (external->priv->pid != 0);
+
+  bar_plugin_external_monitor_stop (external);
+
+  /* without watchdog limits GetPluginStats samples on demand */
+  if (!bar_plugin_external_monitor_has_limits ()
+      && watchdog_stall_seconds == 0)
+    return;
+
+  external->priv->monitor_timeout_id =
+      g_timeout_add_seconds_full (G_PRIORITY_LOW, MONITOR_INTERVAL,
+                                  bar_plugin_external_monitor, external,
+                                  bar_plugin_external_monitor_destroyed);
+}
+
+
+
+static void
+bar_plugin_external_monitor_stop (BarPluginExternal *external)
+{
+  if (external->priv->monitor_timeout_id != 0)
+    g_source_remove (external->priv->monitor_timeout_id);
+
+  if (external->priv->cpu_timer != NULL)
+    {
+      g_timer_destroy (external->priv->cpu_timer);
+      external->priv->cpu_timer = NULL;
+    }
+
+  if (external->priv->heartbeat_timer != NULL)
+    {
+      g_timer_destroy (external->priv->heartbeat_timer);
+      external->priv->heartbeat_timer = NULL;
+    }
+
+  external->priv->cpu_ticks = 0;
+  external->priv->cpu_permille = 0;
+  external->priv->rss_kb = 0;
+  external->priv->watchdog_strikes = 0;
+}
+
+
+
 static void
 bar_plugin_external_queue_free (BarPluginExternal *external)
 {
@@ -1108,6 +1453,8 @@ bar_plugin_external_restart (BarPluginExternal *external)
 
       if (external->priv->embedded)
         bar_plugin_external_queue_add_action (external, PROVIDER_PROP_TYPE_ACTION_QUIT_FOR_RESTART);
+      else if (external->priv->shared_host)
+        bar_plugin_external_host_quit_plugin (external->priv->pid, external->unique_id, TRUE);
       else
         kill (external->priv->pid, SIGUSR1);
     }
@@ -1203,3 +1550,68 @@ bar_plugin_external_get_pid (BarPluginExternal *external)
   bar_return_val_if_fail (BAR_IS_PLUGIN_EXTERNAL (external), 0);
   return external->priv->pid;
 }
+
+
+
+/**
+ * bar_plugin_external_heartbeat:
+ * @external : a #BarPluginExternal.
+ *
+ * Called when the wrapper sent a heartbeat, which it does every
+ * BAR_PLUGIN_HEARTBEAT_INTERVAL seconds from its main loop.
+ **/
+void
+bar_plugin_external_heartbeat (BarPluginExternal *external)
+{
+  bar_return_if_fail (BAR_IS_PLUGIN_EXTERNAL (external));
+
+  if (external->priv->pid == 0)
+    return;
+
+  if (external->priv->heartbeat_timer == NULL)
+    external->priv->heartbeat_timer = g_timer_new ();
+  else
+    g_timer_start (external->priv->heartbeat_timer);
+}
+
+
+
+void
+bar_plugin_external_get_stats (BarPluginExternal *external,
+                                 guint               *cpu_permille,
+                                 guint               *rss_kb,
+                                 guint               *stall_seconds)
+{
+  bar_return_if_fail (BAR_IS_PLUGIN_EXTERNAL (external));
+
+  /* sample now if the monitor does not read /proc, the cpu usage
+   * is the average since the previous call */
+  if (external->priv->pid != 0
+      && !bar_plugin_external_monitor_has_limits ()
+      && !bar_debug_has_domain (BAR_DEBUG_GDB)
+      && !bar_debug_has_domain (BAR_DEBUG_VALGRIND))
+    bar_plugin_external_monitor_sample (external);
+
+  if (cpu_permille != NULL)
+    *cpu_permille = external->priv->cpu_permille;
+  if (rss_kb != NULL)
+    *rss_kb = external->priv->rss_kb;
+  if (stall_seconds != NULL)
+    *stall_seconds = bar_plugin_external_monitor_get_stall (external);
+}
+
+
+
+void
+bar_plugin_external_set_watchdog (guint cpu_percent,
+                                    guint rss_kb,
+                                    guint stall_seconds)
+{
+  watchdog_cpu_percent = cpu_percent;
+  watchdog_rss_kb = rss_kb;
+  watchdog_stall_seconds = stall_seconds;
+
+  bar_debug (BAR_DEBUG_EXTERNAL,
+               "watchdog limits: cpu=%u%%, rss=%ukB, stall=%us",
+               cpu_percent, rss_kb, stall_seconds);
+}
@@ -96,6 +96,17 @@ void         bar_plugin_external_set_background_image (BarPluginExternal  *exter
 
 GPid         bar_plugin_external_get_pid              (BarPluginExternal  *external);
 
+void         bar_plugin_external_heartbeat            (BarPluginExternal  *external);
+
+void         bar_plugin_external_get_stats            (BarPluginExternal  *external,
+                                                         guint               *cpu_permille,
+                                                         guint               *rss_kb,
+                                                         guint               *stall_seconds);
+
+void         bar_plugin_external_set_watchdog         (guint                cpu_percent,
+                                                         guint                rss_kb,
+                                                         guint                stall_seconds);
+
 G_END_DECLS
 
 #endif /* !__BAR_PLUGIN_EXTERNAL_H__ */
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/* for struct ucred */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+
+#include <sys/time.h>
+#include <common/bar-popup-socket.h>
+
+/* seconds to wait for the reply of the bar */
+#define REPLY_TIMEOUT (5)
+
+
+
+/*
+ * blade-bar-popup PLUGIN-NAME:NAME[:TYPE:VALUE]
+ *
+ * Small client for the popup scripts, it sends the plugin event over
+ * the popup socket of the bar and falls back to blade-bar
+ * --plugin-event (D-Bus) if nobody listens. It doesn't link glib or
+ * gtk, so it starts about as fast as the shell that runs it.
+ */
+int
+main (int    argc,
+      char **argv)
+{
+#ifdef BAR_POPUP_SOCKET
+  struct sockaddr_un  addr;
+  socklen_t           addr_len;
+  struct timeval      timeout = { REPLY_TIMEOUT, 0 };
+  struct ucred        cred;
+  socklen_t           cred_len = sizeof (cred);
+  const char         *display;
+  char                event[BAR_POPUP_SOCKET_MAX_EVENT];
+  char                reply;
+  int                 fd;
+  int                 n;
+#endif
+  char               *option;
+  size_t              len;
+
+  if (argc != 2 || *argv[1] == '\0')
+    {
+      fprintf (stderr, "Usage: %s PLUGIN-NAME:NAME[:TYPE:VALUE]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+
+#ifdef BAR_POPUP_SOCKET
+  display = getenv ("DISPLAY");
+  n = snprintf (event, sizeof (event), "%s\n", argv[1]);
+  if (display != NULL && n > 0 && n < (int) sizeof (event))
+    {
+      fd = socket (AF_UNIX, SOCK_STREAM, 0);
+      if (fd != -1)
+        {
+          addr_len = bar_popup_socket_address (&addr, display);
+          /* anyone can bind the abstract name first, only send
+           * the event to a bar of our own user */
+          if (connect (fd, (struct sockaddr *) &addr, addr_len) == 0
+              && getsockopt (fd, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) == 0
+              && cred.uid == getuid ()
+              && write (fd, event, n) == n)
+            {
+              /* the bar received the event, don't send it again over
+               * D-Bus if the reply doesn't come */
+              setsockopt (fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof (timeout));
+              if (read (fd, &reply, 1) != 1)
+                reply = BAR_POPUP_SOCKET_NOT_HANDLED;
+
+              close (fd);
+
+              return reply == BAR_POPUP_SOCKET_HANDLED ? EXIT_SUCCESS : EXIT_FAILURE;
+            }
+
+          close (fd);
+        }
+    }
+#endif
+
+  /* no bar on the socket, try the compatible path */
+  len = strlen (argv[1]) + sizeof ("--plugin-event=");
+  option = malloc (len);
+  if (option == NULL)
+    return EXIT_FAILURE;
+  snprintf (option, len, "--plugin-event=%s", argv[1]);
+
+  execl (BINDIR "/blade-bar", "blade-bar", option, (char *) NULL);
+
+  perror (BINDIR "/blade-bar");
+  free (option);
+
+  return EXIT_FAILURE;
+}
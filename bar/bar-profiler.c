@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Accounting of the time spent in the size request, size allocation and
+ * expose handlers of each plugin in the bar. The itembar reports the size
+ * negotiation and the expose of plugins without a window; exposes of
+ * plugins with their own window are measured in the gdk event handler.
+ * For external plugins this only covers the socket, the plugin itself
+ * draws in the wrapper.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gtk/gtk.h>
+#include <libbladebar/libbladebar.h>
+#include <libbladebar/blade-bar-plugin-provider.h>
+
+#include <common/bar-private.h>
+#include <common/bar-debug.h>
+
+#include <bar/bar-itembar.h>
+#include <bar/bar-profiler.h>
+
+
+
+/* seconds between two reports in the debug output */
+#define DUMP_INTERVAL (30)
+
+
+
+static GTimer *profiler_timer = NULL;
+static GSList *profiler_stats = NULL;
+static GQuark  profiler_quark = 0;
+
+
+
+static void
+bar_profiler_stats_free (gpointer data)
+{
+  BarProfilerStats *stats = data;
+
+  profiler_stats = g_slist_remove (profiler_stats, stats);
+  g_slice_free (BarProfilerStats, stats);
+}
+
+
+
+static GtkWidget *
+bar_profiler_find_plugin (GtkWidget *widget)
+{
+  /* walk up to the direct child of the itembar */
+  for (; widget != NULL; widget = widget->parent)
+    if (widget->parent != NULL && BAR_IS_ITEMBAR (widget->parent))
+      return widget;
+
+  return NULL;
+}
+
+
+
+static void
+bar_profiler_event_handler (GdkEvent *event,
+                            gpointer  data)
+{
+  gpointer   user_data = NULL;
+  GtkWidget *plugin = NULL;
+  gint64     start;
+
+  if (event->type == GDK_EXPOSE
+      && event->any.window != NULL)
+    {
+      gdk_window_get_user_data (event->any.window, &user_data);
+      if (GTK_IS_WIDGET (user_data))
+        plugin = bar_profiler_find_plugin (user_data);
+    }
+
+  if (plugin == NULL)
+    {
+      gtk_main_do_event (event);
+      return;
+    }
+
+  start = bar_profiler_now ();
+  gtk_main_do_event (event);
+  bar_profiler_add (plugin, BAR_PROFILER_EXPOSE, start);
+}
+
+
+
+static gboolean
+bar_profiler_dump (gpointer data)
+{
+  const GSList     *li;
+  BarProfilerStats *stats;
+  guint             i;
+  gdouble           msec[BAR_PROFILER_N_KINDS];
+
+  for (li = profiler_stats; li != NULL; li = li->next)
+    {
+      stats = li->data;
+
+      if (!BLADE_IS_BAR_PLUGIN_PROVIDER (stats->plugin))
+        continue;
+
+      for (i = 0; i < BAR_PROFILER_N_KINDS; i++)
+        msec[i] = stats->usec[i] / 1000.0;
+
+      bar_debug (BAR_DEBUG_PROFILER,
+                   "%s-%d: request %u (%.1f ms), allocate %u (%.1f ms), expose %u (%.1f ms)",
+                   blade_bar_plugin_provider_get_name (BLADE_BAR_PLUGIN_PROVIDER (stats->plugin)),
+                   blade_bar_plugin_provider_get_unique_id (BLADE_BAR_PLUGIN_PROVIDER (stats->plugin)),
+                   stats->calls[BAR_PROFILER_SIZE_REQUEST], msec[BAR_PROFILER_SIZE_REQUEST],
+                   stats->calls[BAR_PROFILER_SIZE_ALLOCATE], msec[BAR_PROFILER_SIZE_ALLOCATE],
+                   stats->calls[BAR_PROFILER_EXPOSE], msec[BAR_PROFILER_EXPOSE]);
+    }
+
+  return TRUE;
+}
+
+
+
+/**
+ * bar_profiler_init:
+ *
+ * Starts the profiler, this is done on startup with BAR_DEBUG=profiler
+ * or when the profile is requested over D-Bus for the first time.
+ * Nothing is measured before this.
+ **/
+void
+bar_profiler_init (void)
+{
+  if (profiler_timer != NULL)
+    return;
+
+  profiler_timer = g_timer_new ();
+  profiler_quark = g_quark_from_static_string ("bar-profiler-stats");
+
+  /* gtk_init() installed gtk_main_do_event, we chain up to it */
+  gdk_event_handler_set (bar_profiler_event_handler, NULL, NULL);
+
+  if (bar_debug_has_domain (BAR_DEBUG_PROFILER))
+    g_timeout_add_seconds (DUMP_INTERVAL, bar_profiler_dump, NULL);
+}
+
+
+
+gboolean
+bar_profiler_is_enabled (void)
+{
+  return profiler_timer != NULL;
+}
+
+
+
+gint64
+bar_profiler_now (void)
+{
+  if (G_UNLIKELY (profiler_timer == NULL))
+    return 0;
+
+  return g_timer_elapsed (profiler_timer, NULL) * G_USEC_PER_SEC;
+}
+
+
+
+/**
+ * bar_profiler_add:
+ * @plugin : the plugin provider, a child of the itembar.
+ * @kind   : what was measured.
+ * @start  : value of bar_profiler_now() before the call.
+ *
+ * Adds a call and the time since @start to the stats of @plugin.
+ **/
+void
+bar_profiler_add (GtkWidget       *plugin,
+                  BarProfilerKind  kind,
+                  gint64           start)
+{
+  BarProfilerStats *stats;
+  gint64            now;
+
+  bar_return_if_fail (GTK_IS_WIDGET (plugin));
+  bar_return_if_fail (kind < BAR_PROFILER_N_KINDS);
+
+  if (G_UNLIKELY (profiler_timer == NULL))
+    return;
+
+  now = bar_profiler_now ();
+
+  stats = g_object_get_qdata (G_OBJECT (plugin), profiler_quark);
+  if (G_UNLIKELY (stats == NULL))
+    {
+      stats = g_slice_new0 (BarProfilerStats);
+      stats->plugin = plugin;
+      g_object_set_qdata_full (G_OBJECT (plugin), profiler_quark, stats,
+                               bar_profiler_stats_free);
+      profiler_stats = g_slist_prepend (profiler_stats, stats);
+    }
+
+  stats->calls[kind]++;
+  if (G_LIKELY (now > start))
+    stats->usec[kind] += now - start;
+}
+
+
+
+/**
+ * bar_profiler_get_stats:
+ *
+ * Returns: list of #BarProfilerStats of all plugins that were measured,
+ *          owned by the profiler.
+ **/
+const GSList *
+bar_profiler_get_stats (void)
+{
+  return profiler_stats;
+}
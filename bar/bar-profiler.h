@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __BAR_PROFILER_H__
+#define __BAR_PROFILER_H__
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+typedef struct _BarProfilerStats BarProfilerStats;
+
+typedef enum
+{
+  BAR_PROFILER_SIZE_REQUEST,
+  BAR_PROFILER_SIZE_ALLOCATE,
+  BAR_PROFILER_EXPOSE,
+  BAR_PROFILER_N_KINDS
+}
+BarProfilerKind;
+
+struct _BarProfilerStats
+{
+  /* the plugin provider */
+  GtkWidget *plugin;
+
+  guint      calls[BAR_PROFILER_N_KINDS];
+  guint64    usec[BAR_PROFILER_N_KINDS];
+};
+
+void          bar_profiler_init       (void);
+
+gboolean      bar_profiler_is_enabled (void);
+
+gint64        bar_profiler_now        (void);
+
+void          bar_profiler_add        (GtkWidget       *plugin,
+                                       BarProfilerKind  kind,
+                                       gint64           start);
+
+const GSList *bar_profiler_get_stats  (void);
+
+G_END_DECLS
+
+#endif /* !__BAR_PROFILER_H__ */
@@ -44,11 +44,13 @@
 
 #include <common/bar-private.h>
 #include <common/bar-debug.h>
+#include <common/bar-trace.h>
 #include <libbladebar/libbladebar.h>
 #include <bar/bar-application.h>
 #include <bar/bar-dbus-service.h>
 #include <bar/bar-dbus-client.h>
 #include <bar/bar-preferences-dialog.h>
+#include <bar/bar-profiler.h>
 
 
 
@@ -143,6 +145,16 @@ bar_signal_handler (gint signum)
 
 
 
+static gboolean
+bar_trace_rss_timeout (gpointer user_data)
+{
+  bar_trace_counter_rss ();
+
+  return TRUE;
+}
+
+
+
 static void
 bar_sm_client_quit (XfceSMClient *sm_client)
 {
@@ -223,6 +235,9 @@ main (gint argc, gchar **argv)
   /* inform the user about usage of gdb/valgrind */
   bar_debug_notify_proxy ();
 
+  /* dump the debug ring on SIGUSR2 or a crash */
+  bar_debug_install_dump_handlers ();
+
   /* set translation domain */
   xfce_textdomain (GETTEXT_PACKAGE, PACKAGE_LOCALE_DIR, "UTF-8");
 
@@ -322,7 +337,12 @@ main (gint argc, gchar **argv)
       goto dbus_return;
     }
 
+  /* start a new startup trace if requested */
+  bar_trace_open (PACKAGE_NAME, TRUE);
+  bar_trace_instant ("launch");
+
   /* start session management */
+  bar_trace_begin ("session-management");
   sm_client = xfce_sm_client_get ();
   xfce_sm_client_set_restart_style (sm_client, XFCE_SM_CLIENT_RESTART_IMMEDIATELY);
   xfce_sm_client_set_priority (sm_client, XFCE_SM_CLIENT_PRIORITY_CORE);
@@ -334,6 +354,7 @@ main (gint argc, gchar **argv)
                   G_LOG_DOMAIN, error->message);
       g_clear_error (&error);
     }
+  bar_trace_end ("session-management");
 
   /* setup signal handlers to properly quit the main loop */
   for (i = 0; i < G_N_ELEMENTS (signums); i++)
@@ -342,13 +363,30 @@ main (gint argc, gchar **argv)
   /* set EWMH source indication */
   wnck_set_client_type (WNCK_CLIENT_TYPE_PAGER);
 
+  /* measure the time spent in the plugins, otherwise this starts
+   * with the first GetPluginProfile call */
+  if (bar_debug_has_domain (BAR_DEBUG_PROFILER))
+    bar_profiler_init ();
+
+  bar_trace_begin ("application-get");
   application = bar_application_get ();
+  bar_trace_end ("application-get");
+
   bar_application_load (application, opt_disable_wm_check);
 
   /* open dialog if we started from launch_bar */
   if (opt_preferences >= 0)
     bar_preferences_dialog_show_from_id (opt_preferences, opt_socket_id);
 
+  bar_trace_instant ("main-loop");
+
+  /* sample the memory usage of the bar in the trace */
+  if (bar_trace_enabled ())
+    {
+      bar_trace_counter_rss ();
+      g_timeout_add_seconds (1, bar_trace_rss_timeout, NULL);
+    }
+
   gtk_main ();
 
   /* make sure there are no incomming events when we close */
@@ -20,6 +20,10 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
 #include <dbus/dbus-glib.h>
 
 #include <common/bar-private.h>
@@ -28,58 +32,330 @@
 
 
 
-static void
-bar_properties_store_value (BlconfChannel *channel,
-                              const gchar   *blconf_property,
-                              GType          blconf_property_type,
-                              GObject       *object,
-                              const gchar   *object_property)
-{
-  GValue      value = { 0, };
-  GdkColor   *color;
-  guint16     alpha = 0xffff;
-#ifndef NDEBUG
+/* changes of a bound object are written after this delay (ms), so a
+ * burst of changes, like dragging a slider, results in one write */
+#define BINDING_FLUSH_DELAY (100)
+
+
+
+/*
+ * The bindings don't use blconf_g_property_bind(), that reads each
+ * property from the channel when it is bound. Instead all properties
+ * below the base are fetched in one request, the object is updated from
+ * the property-changed signal of the channel and object changes are
+ * written back in batches.
+ */
+typedef struct _BarPropertyBinding BarPropertyBinding;
+typedef struct _BarPropertyEntry   BarPropertyEntry;
+
+struct _BarPropertyEntry
+{
+  gchar      *property;
+  GType       type;
   GParamSpec *pspec;
-#endif
 
-  bar_return_if_fail (G_IS_OBJECT (object));
-  bar_return_if_fail (BLCONF_IS_CHANNEL (channel));
+  /* last value known in the channel, in the type of the object */
+  GValue      stored;
 
-#ifndef NDEBUG
-  /* check if the types match */
-  pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (object), object_property);
-  bar_assert (pspec != NULL);
-  if (G_PARAM_SPEC_VALUE_TYPE (pspec) != blconf_property_type)
+  /* value of the object waiting to be written */
+  GValue      pending;
+};
+
+struct _BarPropertyBinding
+{
+  BlconfChannel    *channel;
+  GObject          *object;
+  gchar            *property_base;
+  gsize             base_len;
+
+  BarPropertyEntry *entries;
+  guint             n_entries;
+
+  gulong            changed_id;
+  gulong            notify_id;
+  guint             flush_id;
+
+  /* setting a value of the channel on the object */
+  guint             updating : 1;
+};
+
+
+
+static GQuark bindings_quark = 0;
+
+
+
+static gboolean
+bar_properties_value_from_channel (BarPropertyEntry *entry,
+                                   const GValue     *src,
+                                   GValue           *dest)
+{
+  GPtrArray *array;
+  GdkColor   color = { 0, };
+
+  g_value_init (dest, entry->type);
+
+  if (G_LIKELY (entry->type != GDK_TYPE_COLOR))
     {
-      g_critical ("Object and Blconf properties don't match! %s::%s. %s != %s",
-                  G_OBJECT_TYPE_NAME (object), blconf_property,
-                  g_type_name (blconf_property_type),
-                  g_type_name (G_PARAM_SPEC_VALUE_TYPE (pspec)));
+      if (G_VALUE_TYPE (src) == entry->type)
+        {
+          g_value_copy (src, dest);
+          return TRUE;
+        }
+
+      if (g_value_type_transformable (G_VALUE_TYPE (src), entry->type)
+          && g_value_transform (src, dest))
+        return TRUE;
+    }
+  else if (G_VALUE_HOLDS (src, BAR_PROPERTIES_TYPE_VALUE_ARRAY))
+    {
+      /* colors are stored as an array of 4 uint16 values, like
+       * blconf_g_property_bind_gdkcolor() does */
+      array = g_value_get_boxed (src);
+      if (array != NULL && array->len >= 3
+          && G_VALUE_TYPE (g_ptr_array_index (array, 0)) == BLCONF_TYPE_UINT16
+          && G_VALUE_TYPE (g_ptr_array_index (array, 1)) == BLCONF_TYPE_UINT16
+          && G_VALUE_TYPE (g_ptr_array_index (array, 2)) == BLCONF_TYPE_UINT16)
+        {
+          color.red = blconf_g_value_get_uint16 (g_ptr_array_index (array, 0));
+          color.green = blconf_g_value_get_uint16 (g_ptr_array_index (array, 1));
+          color.blue = blconf_g_value_get_uint16 (g_ptr_array_index (array, 2));
+          g_value_set_boxed (dest, &color);
+          return TRUE;
+        }
     }
-#endif
 
-  /* write the property to the blconf channel */
-  g_value_init (&value, blconf_property_type);
-  g_object_get_property (G_OBJECT (object), object_property, &value);
+  g_warning ("Unable to convert Blconf property %s of type %s to %s",
+             entry->property, G_VALUE_TYPE_NAME (src), g_type_name (entry->type));
+  g_value_unset (dest);
+
+  return FALSE;
+}
 
-  if (G_LIKELY (blconf_property_type != GDK_TYPE_COLOR))
+
+
+static gboolean
+bar_properties_values_equal (BarPropertyEntry *entry,
+                             const GValue     *a,
+                             const GValue     *b)
+{
+  if (!G_IS_VALUE (a) || !G_IS_VALUE (b))
+    return FALSE;
+
+  if (entry->type == GDK_TYPE_COLOR)
+    return g_value_get_boxed (a) != NULL && g_value_get_boxed (b) != NULL
+           && gdk_color_equal (g_value_get_boxed (a), g_value_get_boxed (b));
+
+  return G_PARAM_SPEC_VALUE_TYPE (entry->pspec) == entry->type
+         && g_param_values_cmp (entry->pspec, a, b) == 0;
+}
+
+
+
+static void
+bar_properties_store_value (BarPropertyBinding *binding,
+                            BarPropertyEntry   *entry,
+                            const GValue       *value)
+{
+  gchar    *blconf_property;
+  GdkColor *color;
+  guint16   alpha = 0xffff;
+
+  /* remember the value first, so the change notification
+   * of the channel doesn't set it on the object again */
+  if (G_IS_VALUE (&entry->stored))
+    g_value_unset (&entry->stored);
+  g_value_init (&entry->stored, entry->type);
+  g_value_copy (value, &entry->stored);
+
+  blconf_property = g_strconcat (binding->property_base, "/", entry->property, NULL);
+
+  /* write the property to the blconf channel */
+  if (G_LIKELY (entry->type != GDK_TYPE_COLOR))
     {
-      blconf_channel_set_property (channel, blconf_property, &value);
+      blconf_channel_set_property (binding->channel, blconf_property, value);
     }
   else
     {
       /* work around blconf's lack of storing colors (bug #7117) and
        * do the same as blconf_g_property_bind_gdkcolor() does */
-      color = g_value_get_boxed (&value);
-      blconf_channel_set_array (channel, blconf_property,
-                                BLCONF_TYPE_UINT16, &color->red,
-                                BLCONF_TYPE_UINT16, &color->green,
-                                BLCONF_TYPE_UINT16, &color->blue,
-                                BLCONF_TYPE_UINT16, &alpha,
-                                G_TYPE_INVALID);
+      color = g_value_get_boxed (value);
+      if (G_LIKELY (color != NULL))
+        blconf_channel_set_array (binding->channel, blconf_property,
+                                  BLCONF_TYPE_UINT16, &color->red,
+                                  BLCONF_TYPE_UINT16, &color->green,
+                                  BLCONF_TYPE_UINT16, &color->blue,
+                                  BLCONF_TYPE_UINT16, &alpha,
+                                  G_TYPE_INVALID);
+    }
+
+  g_free (blconf_property);
+}
+
+
+
+static void
+bar_properties_binding_flush (BarPropertyBinding *binding)
+{
+  BarPropertyEntry *entry;
+  guint             i;
+
+  for (i = 0; i < binding->n_entries; i++)
+    {
+      entry = &binding->entries[i];
+      if (!G_IS_VALUE (&entry->pending))
+        continue;
+
+      /* don't write values the channel already has */
+      if (!bar_properties_values_equal (entry, &entry->stored, &entry->pending))
+        bar_properties_store_value (binding, entry, &entry->pending);
+
+      g_value_unset (&entry->pending);
     }
+}
+
+
 
-  g_value_unset (&value);
+static gboolean
+bar_properties_binding_flush_timeout (gpointer data)
+{
+  bar_properties_binding_flush (data);
+
+  return FALSE;
+}
+
+
+
+static void
+bar_properties_binding_flush_destroyed (gpointer data)
+{
+  ((BarPropertyBinding *) data)->flush_id = 0;
+}
+
+
+
+static void
+bar_properties_binding_free (BarPropertyBinding *binding)
+{
+  BarPropertyEntry *entry;
+  guint             i;
+
+  if (binding->flush_id != 0)
+    g_source_remove (binding->flush_id);
+
+  g_signal_handler_disconnect (G_OBJECT (binding->channel), binding->changed_id);
+
+  for (i = 0; i < binding->n_entries; i++)
+    {
+      entry = &binding->entries[i];
+      if (G_IS_VALUE (&entry->stored))
+        g_value_unset (&entry->stored);
+      if (G_IS_VALUE (&entry->pending))
+        g_value_unset (&entry->pending);
+      g_free (entry->property);
+    }
+
+  g_free (binding->entries);
+  g_free (binding->property_base);
+  g_object_unref (G_OBJECT (binding->channel));
+  g_slice_free (BarPropertyBinding, binding);
+}
+
+
+
+static void
+bar_properties_binding_weak_notify (gpointer  data,
+                                    GObject  *where_the_object_was)
+{
+  BarPropertyBinding *binding = data;
+
+  /* the pending values are copies, so they can still be written */
+  bar_properties_binding_flush (binding);
+  bar_properties_binding_free (binding);
+}
+
+
+
+static void
+bar_properties_channel_changed (BlconfChannel      *channel,
+                                const gchar        *property,
+                                const GValue       *value,
+                                BarPropertyBinding *binding)
+{
+  BarPropertyEntry *entry = NULL;
+  GValue            converted = { 0, };
+  guint             i;
+
+  if (strncmp (property, binding->property_base, binding->base_len) != 0
+      || property[binding->base_len] != '/')
+    return;
+
+  for (i = 0; i < binding->n_entries; i++)
+    if (strcmp (binding->entries[i].property, property + binding->base_len + 1) == 0)
+      {
+        entry = &binding->entries[i];
+        break;
+      }
+
+  /* the object keeps its value if the property is reset */
+  if (entry == NULL
+      || value == NULL
+      || !G_IS_VALUE (value)
+      || !bar_properties_value_from_channel (entry, value, &converted))
+    return;
+
+  if (bar_properties_values_equal (entry, &entry->stored, &converted))
+    {
+      g_value_unset (&converted);
+      return;
+    }
+
+  if (G_IS_VALUE (&entry->stored))
+    g_value_unset (&entry->stored);
+  entry->stored = converted;
+
+  /* the channel wins over a change that was not written yet */
+  if (G_IS_VALUE (&entry->pending))
+    g_value_unset (&entry->pending);
+
+  binding->updating = TRUE;
+  g_object_set_property (binding->object, entry->property, &entry->stored);
+  binding->updating = FALSE;
+}
+
+
+
+static void
+bar_properties_object_notify (GObject            *object,
+                              GParamSpec         *pspec,
+                              BarPropertyBinding *binding)
+{
+  BarPropertyEntry *entry = NULL;
+  guint             i;
+
+  if (binding->updating)
+    return;
+
+  for (i = 0; i < binding->n_entries; i++)
+    if (strcmp (binding->entries[i].property, pspec->name) == 0)
+      {
+        entry = &binding->entries[i];
+        break;
+      }
+
+  if (entry == NULL)
+    return;
+
+  /* take a copy now, so the write doesn't need the object */
+  if (G_IS_VALUE (&entry->pending))
+    g_value_unset (&entry->pending);
+  g_value_init (&entry->pending, entry->type);
+  g_object_get_property (object, entry->property, &entry->pending);
+
+  if (binding->flush_id == 0)
+    binding->flush_id = g_timeout_add_full (G_PRIORITY_DEFAULT, BINDING_FLUSH_DELAY,
+                                            bar_properties_binding_flush_timeout, binding,
+                                            bar_properties_binding_flush_destroyed);
 }
 
 
@@ -114,33 +390,122 @@ bar_properties_bind (BlconfChannel       *channel,
                        const BarProperty *properties,
                        gboolean             save_properties)
 {
-  const BarProperty *prop;
-  gchar               *property;
+  const BarProperty  *prop;
+  BarPropertyBinding *binding;
+  BarPropertyEntry   *entry;
+  GString            *property;
+  GHashTable         *stored;
+  const GValue       *value;
+  GValue              current = { 0, };
+  GSList             *bindings;
+  guint               n;
 
   bar_return_if_fail (channel == NULL || BLCONF_IS_CHANNEL (channel));
   bar_return_if_fail (G_IS_OBJECT (object));
   bar_return_if_fail (property_base != NULL && *property_base == '/');
   bar_return_if_fail (properties != NULL);
 
+  binding = g_slice_new0 (BarPropertyBinding);
+  binding->object = object;
+
+  /* before the channel is taken, so pending changes are written
+   * before blconf shuts down when the object is destroyed */
+  g_object_weak_ref (object, bar_properties_binding_weak_notify, binding);
+
   if (G_LIKELY (channel == NULL))
     channel = bar_properties_get_channel (object);
-  bar_return_if_fail (BLCONF_IS_CHANNEL (channel));
+  if (G_UNLIKELY (channel == NULL))
+    {
+      g_object_weak_unref (object, bar_properties_binding_weak_notify, binding);
+      g_slice_free (BarPropertyBinding, binding);
+      return;
+    }
+
+  binding->channel = g_object_ref (G_OBJECT (channel));
+  binding->property_base = g_strdup (property_base);
+  binding->base_len = strlen (property_base);
+
+  for (prop = properties, n = 0; prop->property != NULL; prop++)
+    n++;
+  binding->entries = g_new0 (BarPropertyEntry, n);
+
+  /* get the stored values in one request, instead of one for each
+   * property when binding it */
+  stored = blconf_channel_get_properties (channel, property_base);
+
+  /* all property names share the base */
+  property = g_string_sized_new (64);
+  g_string_append (property, property_base);
+  g_string_append_c (property, '/');
 
   /* walk the properties array */
   for (prop = properties; prop->property != NULL; prop++)
     {
-      property = g_strconcat (property_base, "/", prop->property, NULL);
+      g_string_truncate (property, binding->base_len + 1);
+      g_string_append (property, prop->property);
+
+      entry = &binding->entries[binding->n_entries];
+      entry->pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (object), prop->property);
+      if (G_UNLIKELY (entry->pspec == NULL))
+        {
+          g_critical ("Object %s has no property %s",
+                      G_OBJECT_TYPE_NAME (object), prop->property);
+          continue;
+        }
 
-      if (save_properties)
-        bar_properties_store_value (channel, property, prop->type, object, prop->property);
+#ifndef NDEBUG
+      /* check if the types match */
+      if (G_PARAM_SPEC_VALUE_TYPE (entry->pspec) != prop->type)
+        {
+          g_critical ("Object and Blconf properties don't match! %s::%s. %s != %s",
+                      G_OBJECT_TYPE_NAME (object), property->str,
+                      g_type_name (prop->type),
+                      g_type_name (G_PARAM_SPEC_VALUE_TYPE (entry->pspec)));
+        }
+#endif
 
-      if (G_LIKELY (prop->type != GDK_TYPE_COLOR))
-        blconf_g_property_bind (channel, property, prop->type, object, prop->property);
-      else
-        blconf_g_property_bind_gdkcolor (channel, property, object, prop->property);
+      entry->property = g_strdup (prop->property);
+      entry->type = prop->type;
+      binding->n_entries++;
 
-      g_free (property);
+      value = stored != NULL ? g_hash_table_lookup (stored, property->str) : NULL;
+      if (value != NULL)
+        bar_properties_value_from_channel (entry, value, &entry->stored);
+
+      if (save_properties)
+        {
+          /* write the values of the object, only the ones that
+           * are different from the channel */
+          g_value_init (&current, entry->type);
+          g_object_get_property (object, entry->property, &current);
+          if (!bar_properties_values_equal (entry, &entry->stored, &current))
+            bar_properties_store_value (binding, entry, &current);
+          g_value_unset (&current);
+        }
+      else if (G_IS_VALUE (&entry->stored))
+        {
+          g_object_set_property (object, entry->property, &entry->stored);
+        }
     }
+
+  g_string_free (property, TRUE);
+
+  if (stored != NULL)
+    g_hash_table_destroy (stored);
+
+  binding->changed_id = g_signal_connect (G_OBJECT (channel), "property-changed",
+      G_CALLBACK (bar_properties_channel_changed), binding);
+  binding->notify_id = g_signal_connect (G_OBJECT (object), "notify",
+      G_CALLBACK (bar_properties_object_notify), binding);
+
+  if (G_UNLIKELY (bindings_quark == 0))
+    bindings_quark = g_quark_from_static_string ("bar-properties-bindings");
+
+  /* remember the binding for bar_properties_unbind() */
+  bindings = g_object_steal_qdata (object, bindings_quark);
+  bindings = g_slist_prepend (bindings, binding);
+  g_object_set_qdata_full (object, bindings_quark, bindings,
+                           (GDestroyNotify) g_slist_free);
 }
 
 
@@ -148,7 +513,27 @@ bar_properties_bind (BlconfChannel       *channel,
 void
 bar_properties_unbind (GObject *object)
 {
-  blconf_g_property_unbind_all (object);
+  GSList             *bindings, *li;
+  BarPropertyBinding *binding;
+
+  bar_return_if_fail (G_IS_OBJECT (object));
+
+  if (G_UNLIKELY (bindings_quark == 0))
+    return;
+
+  bindings = g_object_steal_qdata (object, bindings_quark);
+  for (li = bindings; li != NULL; li = li->next)
+    {
+      binding = li->data;
+
+      g_signal_handler_disconnect (object, binding->notify_id);
+      g_object_weak_unref (object, bar_properties_binding_weak_notify, binding);
+
+      bar_properties_binding_flush (binding);
+      bar_properties_binding_free (binding);
+    }
+
+  g_slist_free (bindings);
 }
 
 
@@ -43,4 +43,52 @@ enum
   DBUS_SET_VALUE
 };
 
+#define BAR_TYPE_DBUS_PLUGIN_STATS \
+  dbus_g_type_get_struct ("GValueArray", \
+                          G_TYPE_INT, \
+                          G_TYPE_STRING, \
+                          G_TYPE_INT, \
+                          G_TYPE_UINT, \
+                          G_TYPE_UINT, \
+                          G_TYPE_UINT, \
+                          G_TYPE_INVALID)
+
+#define BAR_TYPE_DBUS_PLUGIN_STATS_LIST \
+  dbus_g_type_get_collection ("GPtrArray", \
+                              BAR_TYPE_DBUS_PLUGIN_STATS)
+
+#define BAR_TYPE_DBUS_PLUGIN_PROFILE \
+  dbus_g_type_get_struct ("GValueArray", \
+                          G_TYPE_INT, \
+                          G_TYPE_STRING, \
+                          G_TYPE_UINT, \
+                          G_TYPE_UINT64, \
+                          G_TYPE_UINT, \
+                          G_TYPE_UINT64, \
+                          G_TYPE_UINT, \
+                          G_TYPE_UINT64, \
+                          G_TYPE_INVALID)
+
+enum
+{
+  DBUS_PROFILE_UNIQUE_ID,
+  DBUS_PROFILE_NAME,
+  DBUS_PROFILE_REQUEST_CALLS,
+  DBUS_PROFILE_REQUEST_USEC,
+  DBUS_PROFILE_ALLOCATE_CALLS,
+  DBUS_PROFILE_ALLOCATE_USEC,
+  DBUS_PROFILE_EXPOSE_CALLS,
+  DBUS_PROFILE_EXPOSE_USEC
+};
+
+enum
+{
+  DBUS_STATS_UNIQUE_ID,
+  DBUS_STATS_NAME,
+  DBUS_STATS_PID,
+  DBUS_STATS_CPU,
+  DBUS_STATS_RSS,
+  DBUS_STATS_STALL
+};
+
 #endif /* !__BAR_DBUS_H__ */
@@ -23,14 +23,70 @@
 #ifdef HAVE_STRING_H
 #include <string.h>
 #endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SIGNAL_H
+#include <signal.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
 
 #include <glib.h>
 #include <common/bar-debug.h>
 #include <common/bar-private.h>
+#include <common/bar-trace.h>
+
+/* number of records in the ring, a power of 2 */
+#define RING_SIZE    (1024)
+#define RING_MESSAGE (200)
+
+/* seconds between two reports of the event counters */
+#define COUNTERS_INTERVAL (5)
+
+
+
+/*
+ * With BAR_DEBUG=ring,... messages are not printed, but recorded in a
+ * ring buffer that is written to stderr on SIGUSR2, on a crash or when
+ * the bar is asked over D-Bus. The bar and every plugin module link
+ * their own copy of this file, so the ring is looked up with a process
+ * wide key, so all of them record in the same buffer. Each line in the
+ * dump starts with a monotonic timestamp and the pid, the dumps of the
+ * bar and its wrappers can be merged with sort -n.
+ *
+ * Writers claim a record with an atomic increment and don't take a
+ * lock; a dump during a write can show that record half written.
+ */
+typedef struct
+{
+  gint64        timestamp;
+  BarDebugFlag  domain;
+  gchar         message[RING_MESSAGE];
+}
+BarDebugRecord;
+
+typedef struct
+{
+  volatile gint  next;
+  BarDebugRecord records[RING_SIZE];
+}
+BarDebugRing;
+
+typedef struct
+{
+  BarDebugFlag     domain;
+  BarDebugCounter *counters;
+  guint            n_counters;
+}
+BarDebugCounters;
 
 
 
-static BarDebugFlag bar_debug_flags = 0;
+static BarDebugFlag  bar_debug_flags = 0;
+static const gchar  *bar_debug_names[32];
+static BarDebugRing *bar_debug_ring = NULL;
 
 
 
@@ -52,9 +108,12 @@ static const GDebugKey bar_debug_keys[] =
   { "module-factory", BAR_DEBUG_MODULE_FACTORY },
   { "module", BAR_DEBUG_MODULE },
   { "positioning", BAR_DEBUG_POSITIONING },
+  { "profiler", BAR_DEBUG_PROFILER },
+  { "ring", BAR_DEBUG_RING },
   { "struts", BAR_DEBUG_STRUTS },
   { "systray", BAR_DEBUG_SYSTRAY },
-  { "tasklist", BAR_DEBUG_TASKLIST }
+  { "tasklist", BAR_DEBUG_TASKLIST },
+  { "windowmenu", BAR_DEBUG_WINDOWMENU }
 };
 
 
@@ -64,6 +123,8 @@ bar_debug_init (void)
 {
   static volatile gsize  inited__volatile = 0;
   const gchar           *value;
+  guint                  i;
+  const gchar           *key;
 
   if (g_once_init_enter (&inited__volatile))
     {
@@ -76,9 +137,27 @@ bar_debug_init (void)
           /* always enable (unfiltered) debugging messages */
           BAR_SET_FLAG (bar_debug_flags, BAR_DEBUG_YES);
 
-          /* unset gdb and valgrind in 'all' mode */
+          /* unset gdb, valgrind and ring in 'all' mode */
           if (g_ascii_strcasecmp (value, "all") == 0)
-            BAR_UNSET_FLAG (bar_debug_flags, BAR_DEBUG_GDB | BAR_DEBUG_VALGRIND);
+            BAR_UNSET_FLAG (bar_debug_flags, BAR_DEBUG_GDB | BAR_DEBUG_VALGRIND
+                                             | BAR_DEBUG_RING);
+
+          /* domain names by flag bit, so we don't search the keys */
+          bar_debug_names[0] = "debug";
+          for (i = 0; i < G_N_ELEMENTS (bar_debug_keys); i++)
+            bar_debug_names[g_bit_nth_lsf (bar_debug_keys[i].value, -1)] = bar_debug_keys[i].key;
+
+          if (BAR_HAS_FLAG (bar_debug_flags, BAR_DEBUG_RING))
+            {
+              /* share the ring with the other copies of this code */
+              key = g_intern_string ("bar-debug-ring");
+              bar_debug_ring = g_dataset_get_data (key, "ring");
+              if (bar_debug_ring == NULL)
+                {
+                  bar_debug_ring = g_new0 (BarDebugRing, 1);
+                  g_dataset_set_data (key, "ring", bar_debug_ring);
+                }
+            }
         }
 
       g_once_init_leave (&inited__volatile, 1);
@@ -89,25 +168,50 @@ bar_debug_init (void)
 
 
 
+static gint64
+bar_debug_timestamp (void)
+{
+#if GLIB_CHECK_VERSION (2, 28, 0)
+  return g_get_monotonic_time ();
+#else
+  GTimeVal now;
+
+  g_get_current_time (&now);
+
+  return (gint64) now.tv_sec * G_USEC_PER_SEC + now.tv_usec;
+#endif
+}
+
+
+
 static void
 bar_debug_print (BarDebugFlag  domain,
                    const gchar    *message,
                    va_list         args)
 {
-  gchar       *string;
-  const gchar *domain_name = NULL;
-  guint        i;
+  gchar          *string;
+  const gchar    *domain_name;
+  BarDebugRecord *record;
+  guint           n;
 
-  /* lookup domain name */
-  for (i = 0; i < G_N_ELEMENTS (bar_debug_keys); i++)
+  if (bar_debug_ring != NULL)
     {
-      if (bar_debug_keys[i].value == domain)
-        {
-          domain_name = bar_debug_keys[i].key;
-          break;
-        }
+      /* claim the next record */
+#if GLIB_CHECK_VERSION (2, 30, 0)
+      n = g_atomic_int_add (&bar_debug_ring->next, 1);
+#else
+      n = g_atomic_int_exchange_and_add (&bar_debug_ring->next, 1);
+#endif
+      record = &bar_debug_ring->records[n % RING_SIZE];
+
+      record->timestamp = bar_debug_timestamp ();
+      record->domain = domain;
+      g_vsnprintf (record->message, sizeof (record->message), message, args);
+
+      return;
     }
 
+  domain_name = bar_debug_names[g_bit_nth_lsf (domain, -1)];
   bar_assert (domain_name != NULL);
 
   string = g_strdup_vprintf (message, args);
@@ -117,6 +221,63 @@ bar_debug_print (BarDebugFlag  domain,
 
 
 
+#ifdef HAVE_SIGNAL_H
+/* SIGUSR2 only writes to this pipe, the main loop dumps the ring */
+static gint bar_debug_dump_pipe[2] = { -1, -1 };
+
+
+
+static gboolean
+bar_debug_dump_pipe_watch (GIOChannel   *source,
+                           GIOCondition  condition,
+                           gpointer      user_data)
+{
+  gchar buffer[16];
+
+  /* drain the pipe, several signals result in one dump */
+  while (read (bar_debug_dump_pipe[0], buffer, sizeof (buffer)) > 0);
+
+  bar_debug_dump ();
+
+  return TRUE;
+}
+
+
+
+static void
+bar_debug_dump_handler (gint signum)
+{
+  static volatile sig_atomic_t dumping = FALSE;
+
+  if (signum == SIGUSR2
+      && bar_debug_dump_pipe[1] != -1)
+    {
+      if (write (bar_debug_dump_pipe[1], "", 1) < 0)
+        {
+          /* the pipe is full, a dump is pending */
+        }
+
+      return;
+    }
+
+  if (!dumping)
+    {
+      dumping = TRUE;
+      bar_debug_dump ();
+      dumping = FALSE;
+    }
+
+  if (signum != SIGUSR2)
+    {
+      /* crashed, let the default handler finish the job */
+      signal (signum, SIG_DFL);
+      raise (signum);
+    }
+}
+#endif
+
+
+
 gboolean
 bar_debug_has_domain (BarDebugFlag domain)
 {
@@ -164,3 +325,207 @@ bar_debug_filtered (BarDebugFlag  domain,
   bar_debug_print (domain, message, args);
   va_end (args);
 }
+
+
+
+/* snprintf() is not async-signal-safe, so the dump
+ * formats its lines with these two */
+static gchar *
+bar_debug_dump_append (gchar       *p,
+                       const gchar *end,
+                       const gchar *str,
+                       gsize        max_len)
+{
+  for (; p < end && max_len > 0 && *str != '\0'; max_len--)
+    *p++ = *str++;
+
+  return p;
+}
+
+
+
+static gchar *
+bar_debug_dump_append_int (gchar       *p,
+                           const gchar *end,
+                           gint64       value)
+{
+  gchar   digits[24];
+  guint   n = 0;
+  guint64 v;
+
+  if (value < 0)
+    {
+      if (p < end)
+        *p++ = '-';
+      v = -(guint64) value;
+    }
+  else
+    {
+      v = value;
+    }
+
+  do
+    digits[n++] = '0' + v % 10;
+  while ((v /= 10) != 0);
+
+  while (n > 0 && p < end)
+    *p++ = digits[--n];
+
+  return p;
+}
+
+
+
+/**
+ * bar_debug_dump:
+ *
+ * Writes the records in the ring to stderr, oldest first. The lines
+ * are formatted by hand on the stack and written with write(), so this
+ * is async-signal-safe and is also used in the crash handlers.
+ **/
+void
+bar_debug_dump (void)
+{
+  BarDebugRecord *record;
+  guint           n, i;
+  const gchar    *domain_name;
+  gchar           line[RING_MESSAGE + 100];
+  gchar          *p, *end;
+  gint            pid;
+
+  if (bar_debug_ring == NULL)
+    return;
+
+  n = (guint) g_atomic_int_get (&bar_debug_ring->next);
+  pid = getpid ();
+
+  /* room for the newline */
+  end = line + sizeof (line) - 1;
+
+  for (i = n > RING_SIZE ? n - RING_SIZE : 0; i != n; i++)
+    {
+      record = &bar_debug_ring->records[i % RING_SIZE];
+
+      domain_name = bar_debug_names[g_bit_nth_lsf (record->domain, -1)];
+      if (domain_name == NULL)
+        domain_name = "?";
+
+      /* "<timestamp> <pid> PACKAGE_NAME(<domain>): <message>\n" */
+      p = bar_debug_dump_append_int (line, end, record->timestamp);
+      p = bar_debug_dump_append (p, end, " ", 1);
+      p = bar_debug_dump_append_int (p, end, pid);
+      p = bar_debug_dump_append (p, end, " " PACKAGE_NAME "(", G_MAXSIZE);
+      p = bar_debug_dump_append (p, end, domain_name, G_MAXSIZE);
+      p = bar_debug_dump_append (p, end, "): ", G_MAXSIZE);
+
+      /* a record that is written right now might not be terminated */
+      p = bar_debug_dump_append (p, end, record->message, sizeof (record->message));
+      *p++ = '\n';
+
+      if (write (STDERR_FILENO, line, p - line) < 0)
+        break;
+    }
+}
+
+
+
+/**
+ * bar_debug_install_dump_handlers:
+ *
+ * Dump the ring on SIGUSR2 and before the process dies on a crash.
+ * On SIGUSR2 the dump is done from the default main loop. Only called
+ * from the executables, the handlers can't live in a plugin module
+ * that might be unloaded.
+ **/
+void
+bar_debug_install_dump_handlers (void)
+{
+#ifdef HAVE_SIGNAL_H
+  const gint  signums[] = { SIGUSR2, SIGSEGV, SIGBUS, SIGFPE, SIGILL };
+  guint       i;
+  GIOChannel *channel;
+
+  if (!BAR_HAS_FLAG (bar_debug_init (), BAR_DEBUG_RING))
+    return;
+
+  if (bar_debug_dump_pipe[0] == -1
+      && pipe (bar_debug_dump_pipe) == 0)
+    {
+      for (i = 0; i < G_N_ELEMENTS (bar_debug_dump_pipe); i++)
+        {
+          fcntl (bar_debug_dump_pipe[i], F_SETFL,
+                 fcntl (bar_debug_dump_pipe[i], F_GETFL) | O_NONBLOCK);
+          fcntl (bar_debug_dump_pipe[i], F_SETFD, FD_CLOEXEC);
+        }
+
+      channel = g_io_channel_unix_new (bar_debug_dump_pipe[0]);
+      g_io_add_watch (channel, G_IO_IN, bar_debug_dump_pipe_watch, NULL);
+      g_io_channel_unref (channel);
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (signums); i++)
+    signal (signums[i], bar_debug_dump_handler);
+#endif
+}
+
+
+
+static gboolean
+bar_debug_counters_report (gpointer user_data)
+{
+  BarDebugCounters *counters = user_data;
+  BarDebugCounter  *counter;
+  guint             i;
+
+  for (i = 0; i < counters->n_counters; i++)
+    {
+      counter = &counters->counters[i];
+      if (counter->count == counter->reported)
+        continue;
+
+      bar_debug_filtered (counters->domain, "%s: +%u (%u)", counter->name,
+                          counter->count - counter->reported, counter->count);
+      bar_trace_counter (counter->name, counter->count);
+
+      counter->reported = counter->count;
+    }
+
+  return TRUE;
+}
+
+
+
+/**
+ * bar_debug_counters_watch:
+ * @domain     : debug domain of the counters.
+ * @counters   : static array of counters.
+ * @n_counters : number of counters in the array.
+ *
+ * Reports the counters that changed every few seconds if @domain is
+ * enabled in BAR_DEBUG or the bar is traced. Meant to count handler
+ * invocations under load, a plugin simply increases the counts.
+ *
+ * Returns: the id of the report timeout or 0 if nothing is reported.
+ *          The caller removes the source before @counters is freed.
+ **/
+guint
+bar_debug_counters_watch (BarDebugFlag     domain,
+                          BarDebugCounter *counters,
+                          guint            n_counters)
+{
+  BarDebugCounters *data;
+
+  bar_return_val_if_fail (counters != NULL, 0);
+
+  if (!BAR_HAS_FLAG (bar_debug_init (), domain)
+      && !bar_trace_enabled ())
+    return 0;
+
+  data = g_new0 (BarDebugCounters, 1);
+  data->domain = domain;
+  data->counters = counters;
+  data->n_counters = n_counters;
+
+  return g_timeout_add_seconds_full (G_PRIORITY_LOW, COUNTERS_INTERVAL,
+                                     bar_debug_counters_report, data, g_free);
+}
@@ -42,10 +42,25 @@ typedef enum
   BAR_DEBUG_POSITIONING      = 1 << 12,
   BAR_DEBUG_STRUTS           = 1 << 13,
   BAR_DEBUG_SYSTRAY          = 1 << 14,
-  BAR_DEBUG_TASKLIST         = 1 << 15
+  BAR_DEBUG_TASKLIST         = 1 << 15,
+  BAR_DEBUG_PROFILER         = 1 << 16,
+
+  /* record messages in a ring buffer instead of printing them */
+  BAR_DEBUG_RING             = 1 << 17,
+
+  BAR_DEBUG_WINDOWMENU       = 1 << 18
 }
 BarDebugFlag;
 
+/* event counters of a module, see bar_debug_counters_watch() */
+typedef struct
+{
+  const gchar *name;
+  guint        count;
+  guint        reported;
+}
+BarDebugCounter;
+
 gboolean bar_debug_has_domain   (BarDebugFlag  domain);
 
 void     bar_debug              (BarDebugFlag  domain,
@@ -56,4 +71,12 @@ void     bar_debug_filtered     (BarDebugFlag  domain,
                                    const gchar    *message,
                                    ...) G_GNUC_PRINTF (2, 3);
 
+void     bar_debug_dump         (void);
+
+void     bar_debug_install_dump_handlers (void);
+
+guint    bar_debug_counters_watch (BarDebugFlag     domain,
+                                   BarDebugCounter *counters,
+                                   guint            n_counters);
+
 #endif /* !__BAR_DEBUG_H__ */
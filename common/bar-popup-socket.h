@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef __BAR_POPUP_SOCKET_H__
+#define __BAR_POPUP_SOCKET_H__
+
+/*
+ * Besides D-Bus, the bar listens on an abstract unix socket for plugin
+ * events, so the xfce4-popup-* scripts don't pay for a D-Bus round trip
+ * and the startup of a gtk program. The client writes one event in the
+ * --plugin-event syntax followed by a newline, the bar replies with
+ * one byte.
+ *
+ * This header is also used by blade-bar-popup, so it only depends on
+ * libc. The abstract namespace and SO_PEERCRED are linux only, other
+ * systems use D-Bus.
+ */
+#if defined (__linux__) && defined (HAVE_SYS_SOCKET_H) && defined (HAVE_SYS_UN_H)
+#define BAR_POPUP_SOCKET 1
+
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* reply of the bar */
+#define BAR_POPUP_SOCKET_HANDLED     '1'
+#define BAR_POPUP_SOCKET_NOT_HANDLED '0'
+
+/* maximum length of an event, including the newline */
+#define BAR_POPUP_SOCKET_MAX_EVENT   (256)
+
+/* the socket of the bar of this user on this display, without
+ * the screen number; returns the length of the address */
+static inline socklen_t
+bar_popup_socket_address (struct sockaddr_un *addr,
+                          const char         *display)
+{
+  const char *colon, *dot;
+  int         display_len;
+  int         n;
+
+  colon = strrchr (display, ':');
+  dot = colon != NULL ? strchr (colon, '.') : NULL;
+  display_len = dot != NULL ? (int) (dot - display) : (int) strlen (display);
+
+  memset (addr, 0, sizeof (*addr));
+  addr->sun_family = AF_UNIX;
+
+  /* sun_path[0] stays nul for the abstract namespace */
+  n = snprintf (addr->sun_path + 1, sizeof (addr->sun_path) - 1,
+                "blade-bar-popup-%u-%.*s", (unsigned int) getuid (),
+                display_len, display);
+  if (n < 0 || n >= (int) sizeof (addr->sun_path) - 1)
+    n = sizeof (addr->sun_path) - 2;
+
+  return offsetof (struct sockaddr_un, sun_path) + 1 + n;
+}
+
+#endif
+
+#endif /* !__BAR_POPUP_SOCKET_H__ */
@@ -64,6 +64,17 @@
  * without asking the user what to do */
 #define BAR_PLUGIN_AUTO_RESTART (60)
 
+/* seconds between the heartbeats a wrapper sends to the bar */
+#define BAR_PLUGIN_HEARTBEAT_INTERVAL (5)
+
+/* shared wrapper host: argument to start the wrapper as a host and
+ * the commands on its pipes. A message is the number of strings
+ * followed by the nul-terminated strings, the first being the command */
+#define BAR_WRAPPER_HOST_ARGUMENT "--host"
+#define BAR_WRAPPER_HOST_ADD      "add"    /* plugin argv[1..] */
+#define BAR_WRAPPER_HOST_QUIT     "quit"   /* unique-id, restart */
+#define BAR_WRAPPER_HOST_EXITED   "exited" /* unique-id, exit code */
+
 /* integer swap functions */
 #define SWAP_INTEGER(a,b) G_STMT_START { gint swp = a; a = b; b = swp; } G_STMT_END
 #define TRANSPOSE_AREA(area) G_STMT_START { SWAP_INTEGER (area.width, area.height); \
@@ -0,0 +1,400 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Startup tracing: when BAR_TRACE is set to a filename, the bar and the
+ * plugin wrappers append events in the Chrome trace-event format to that
+ * file. The bar truncates the file and opens the JSON array; every event is
+ * written as a single line with one write() on an O_APPEND descriptor, so
+ * the wrapper processes can safely share the file. The array is never
+ * closed, which the trace viewers (chrome://tracing, Perfetto) accept.
+ *
+ * Timestamps come from the monotonic clock, so events of the bar and its
+ * wrappers end up on the same time line.
+ *
+ * Plugin modules link their own copy of this file; they find the
+ * descriptor the executable opened through an interned key, so their
+ * events end up in the same trace. Counter events (rss, number of
+ * tasklist buttons, ...) together with the spans around relayouts make
+ * the trace usable as the output of an automated benchmark run, for
+ * example of a bar started under Xvfb with a private configuration.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_STDIO_H
+#include <stdio.h>
+#endif
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <common/bar-private.h>
+#include <common/bar-trace.h>
+
+
+
+static gint      bar_trace_fd = -1;
+static gint      bar_trace_pid = 0;
+static gboolean  bar_trace_looked_up = FALSE;
+
+
+
+static gboolean
+bar_trace_lookup (void)
+{
+  gpointer data;
+
+  if (G_LIKELY (bar_trace_fd != -1))
+    return TRUE;
+
+  if (G_LIKELY (bar_trace_looked_up))
+    return FALSE;
+  bar_trace_looked_up = TRUE;
+
+  /* get the descriptor opened by the executable */
+  data = g_dataset_get_data (g_intern_string ("bar-trace"), "fd");
+  if (data == NULL)
+    return FALSE;
+
+  bar_trace_fd = GPOINTER_TO_INT (data) - 1;
+  bar_trace_pid = getpid ();
+
+  return TRUE;
+}
+
+
+
+static gint64
+bar_trace_timestamp (void)
+{
+#if GLIB_CHECK_VERSION (2, 28, 0)
+  return g_get_monotonic_time ();
+#else
+  GTimeVal now;
+
+  g_get_current_time (&now);
+
+  return (gint64) now.tv_sec * G_USEC_PER_SEC + now.tv_usec;
+#endif
+}
+
+
+
+static void
+bar_trace_append_escaped (GString     *line,
+                          const gchar *string)
+{
+  const gchar *p;
+
+  g_string_append_c (line, '"');
+
+  for (p = string; *p != '\0'; p++)
+    {
+      if (*p == '"' || *p == '\\')
+        {
+          g_string_append_c (line, '\\');
+          g_string_append_c (line, *p);
+        }
+      else if ((guchar) *p < 0x20)
+        {
+          g_string_append_printf (line, "\\u%04x", (guint) *p);
+        }
+      else
+        {
+          g_string_append_c (line, *p);
+        }
+    }
+
+  g_string_append_c (line, '"');
+}
+
+
+
+static void
+bar_trace_write (GString *line)
+{
+  /* a failed or short write only costs us an event, tracing
+   * should never interfere with the startup it is measuring */
+  if (write (bar_trace_fd, line->str, line->len) != (gssize) line->len)
+    return;
+}
+
+
+
+static void
+bar_trace_event (gchar        phase,
+                 gint         id,
+                 const gchar *name,
+                 va_list      args)
+{
+  GString *line;
+  gchar   *formatted;
+
+  formatted = g_strdup_vprintf (name, args);
+
+  line = g_string_sized_new (128);
+  g_string_append_printf (line,
+                          "{\"ph\":\"%c\",\"ts\":%" G_GINT64_FORMAT ","
+                          "\"pid\":%d,\"tid\":%d,\"cat\":\"bar\",\"name\":",
+                          phase, bar_trace_timestamp (),
+                          bar_trace_pid, bar_trace_pid);
+  bar_trace_append_escaped (line, formatted);
+
+  if (phase == 'b' || phase == 'e')
+    g_string_append_printf (line, ",\"id\":%d", id);
+  else if (phase == 'i')
+    g_string_append (line, ",\"s\":\"p\"");
+
+  g_string_append (line, "},\n");
+
+  bar_trace_write (line);
+
+  g_string_free (line, TRUE);
+  g_free (formatted);
+}
+
+
+
+/**
+ * bar_trace_open:
+ * @process_name : name of this process in the trace viewer.
+ * @truncate     : %TRUE to start a new trace file, only used by the bar.
+ *
+ * Opens the trace file if BAR_TRACE is set. Events emitted before
+ * this call or without BAR_TRACE in the environment are dropped.
+ **/
+void
+bar_trace_open (const gchar *process_name,
+                gboolean     truncate)
+{
+  const gchar *filename;
+  gint         flags = O_WRONLY | O_CREAT | O_APPEND;
+  GString     *line;
+
+  bar_return_if_fail (process_name != NULL);
+  bar_return_if_fail (bar_trace_fd == -1);
+
+  filename = g_getenv ("BAR_TRACE");
+  if (G_LIKELY (filename == NULL || *filename == '\0'))
+    return;
+
+  if (truncate)
+    flags |= O_TRUNC;
+
+  bar_trace_fd = g_open (filename, flags, 0644);
+  if (G_UNLIKELY (bar_trace_fd == -1))
+    {
+      g_warning ("Failed to open trace file \"%s\": %s",
+                 filename, g_strerror (errno));
+      return;
+    }
+
+  /* the wrappers open the file themselves */
+  fcntl (bar_trace_fd, F_SETFD, FD_CLOEXEC);
+
+  bar_trace_pid = getpid ();
+
+  /* share the descriptor with the plugin modules */
+  g_dataset_set_data (g_intern_string ("bar-trace"), "fd",
+                      GINT_TO_POINTER (bar_trace_fd + 1));
+
+  line = g_string_sized_new (128);
+
+  if (truncate)
+    g_string_append (line, "[\n");
+
+  /* metadata event to label the process */
+  g_string_append_printf (line, "{\"ph\":\"M\",\"pid\":%d,"
+                          "\"name\":\"process_name\",\"args\":{\"name\":",
+                          bar_trace_pid);
+  bar_trace_append_escaped (line, process_name);
+  g_string_append (line, "}},\n");
+
+  bar_trace_write (line);
+  g_string_free (line, TRUE);
+}
+
+
+
+gboolean
+bar_trace_enabled (void)
+{
+  return bar_trace_lookup ();
+}
+
+
+
+void
+bar_trace_begin (const gchar *name,
+                 ...)
+{
+  va_list args;
+
+  if (G_LIKELY (!bar_trace_lookup ()))
+    return;
+
+  va_start (args, name);
+  bar_trace_event ('B', 0, name, args);
+  va_end (args);
+}
+
+
+
+void
+bar_trace_end (const gchar *name,
+               ...)
+{
+  va_list args;
+
+  if (G_LIKELY (!bar_trace_lookup ()))
+    return;
+
+  va_start (args, name);
+  bar_trace_event ('E', 0, name, args);
+  va_end (args);
+}
+
+
+
+void
+bar_trace_instant (const gchar *name,
+                   ...)
+{
+  va_list args;
+
+  if (G_LIKELY (!bar_trace_lookup ()))
+    return;
+
+  va_start (args, name);
+  bar_trace_event ('i', 0, name, args);
+  va_end (args);
+}
+
+
+
+/**
+ * bar_trace_async_begin:
+ * @id   : identifier to match the end event, for example the
+ *         unique id of a plugin.
+ * @name : printf-style name of the span.
+ *
+ * Starts a span that ends in another main loop iteration,
+ * these can overlap with other spans.
+ **/
+void
+bar_trace_async_begin (gint         id,
+                       const gchar *name,
+                       ...)
+{
+  va_list args;
+
+  if (G_LIKELY (!bar_trace_lookup ()))
+    return;
+
+  va_start (args, name);
+  bar_trace_event ('b', id, name, args);
+  va_end (args);
+}
+
+
+
+void
+bar_trace_async_end (gint         id,
+                     const gchar *name,
+                     ...)
+{
+  va_list args;
+
+  if (G_LIKELY (!bar_trace_lookup ()))
+    return;
+
+  va_start (args, name);
+  bar_trace_event ('e', id, name, args);
+  va_end (args);
+}
+
+
+
+/**
+ * bar_trace_counter:
+ * @name  : name of the counter.
+ * @value : the current value.
+ *
+ * Records the value of a counter, shown as a graph in the viewers.
+ **/
+void
+bar_trace_counter (const gchar *name,
+                   gint64       value)
+{
+  GString *line;
+
+  if (G_LIKELY (!bar_trace_lookup ()))
+    return;
+
+  line = g_string_sized_new (128);
+  g_string_append_printf (line,
+                          "{\"ph\":\"C\",\"ts\":%" G_GINT64_FORMAT ","
+                          "\"pid\":%d,\"cat\":\"bar\",\"name\":",
+                          bar_trace_timestamp (), bar_trace_pid);
+  bar_trace_append_escaped (line, name);
+  g_string_append_printf (line, ",\"args\":{\"value\":%" G_GINT64_FORMAT "}},\n",
+                          value);
+
+  bar_trace_write (line);
+  g_string_free (line, TRUE);
+}
+
+
+
+/**
+ * bar_trace_counter_rss:
+ *
+ * Records the resident memory of this process in kB as the
+ * rss-kb counter, for example from a timeout.
+ **/
+void
+bar_trace_counter_rss (void)
+{
+  gchar  *contents;
+  gulong  size, resident;
+
+  if (G_LIKELY (!bar_trace_lookup ()))
+    return;
+
+  if (!g_file_get_contents ("/proc/self/statm", &contents, NULL, NULL))
+    return;
+
+  if (sscanf (contents, "%lu %lu", &size, &resident) == 2)
+    bar_trace_counter ("rss-kb", (gint64) resident * (sysconf (_SC_PAGESIZE) / 1024));
+
+  g_free (contents);
+}
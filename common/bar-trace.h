@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef __BAR_TRACE_H__
+#define __BAR_TRACE_H__
+
+#include <glib.h>
+
+void     bar_trace_open        (const gchar *process_name,
+                                gboolean     truncate);
+
+gboolean bar_trace_enabled     (void);
+
+void     bar_trace_begin       (const gchar *name,
+                                ...) G_GNUC_PRINTF (1, 2);
+
+void     bar_trace_end         (const gchar *name,
+                                ...) G_GNUC_PRINTF (1, 2);
+
+void     bar_trace_instant     (const gchar *name,
+                                ...) G_GNUC_PRINTF (1, 2);
+
+void     bar_trace_async_begin (gint         id,
+                                const gchar *name,
+                                ...) G_GNUC_PRINTF (2, 3);
+
+void     bar_trace_async_end   (gint         id,
+                                const gchar *name,
+                                ...) G_GNUC_PRINTF (2, 3);
+
+void     bar_trace_counter     (const gchar *name,
+                                gint64       value);
+
+void     bar_trace_counter_rss (void);
+
+#endif /* !__BAR_TRACE_H__ */
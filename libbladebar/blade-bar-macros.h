@@ -243,6 +243,8 @@ typedef GTypeModule BladeBarTypeModule;
  * set X-XFCE-Interal=TRUE in the desktop file, the bar will force
  * the plugin to run inside a wrapper (this because the bar called
  * gtk_init() long before it starts to load the plugins).
+ * For the same reason a module with a pre-init function never runs in
+ * a shared wrapper host, even if X-XFCE-Shared-Wrapper=TRUE is set.
  *
  * Note that you can only use this once and it only works in
  * combination with the plugins register/define functions added
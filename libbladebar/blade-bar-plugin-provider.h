@@ -93,7 +93,8 @@ typedef enum /*< skip >*/
   PROVIDER_SIGNAL_SHOW_ABOUT,
   PROVIDER_SIGNAL_FOCUS_PLUGIN,
   PROVIDER_SIGNAL_SHRINK_PLUGIN,
-  PROVIDER_SIGNAL_UNSHRINK_PLUGIN
+  PROVIDER_SIGNAL_UNSHRINK_PLUGIN,
+  PROVIDER_SIGNAL_SAVE_NEEDED
 }
 BladeBarPluginProviderSignal;
 
@@ -116,7 +117,8 @@ typedef enum /*< skip >*/
   PROVIDER_PROP_TYPE_ACTION_BACKGROUND_UNSET, /* none */
   PROVIDER_PROP_TYPE_ACTION_SHOW_CONFIGURE,   /* none */
   PROVIDER_PROP_TYPE_ACTION_SHOW_ABOUT,       /* none */
-  PROVIDER_PROP_TYPE_ACTION_ASK_REMOVE        /* none */
+  PROVIDER_PROP_TYPE_ACTION_ASK_REMOVE,       /* none */
+  PROVIDER_PROP_TYPE_SET_HEARTBEAT_INTERVAL   /* gint, wrapper only */
 }
 BladeBarPluginProviderPropType;
 
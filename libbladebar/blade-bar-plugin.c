@@ -59,10 +59,34 @@
   BAR_HAS_FLAG (BLADE_BAR_PLUGIN (plugin)->priv->flags, \
                   PLUGIN_FLAG_CONSTRUCTED)
 
+/* how long a popup waits for an autohidden bar to show */
+#define POPUP_POSITION_TIMEOUT (500)
+
+/* how often an external plugin checks if the bar is shown */
+#define POPUP_POLL_INTERVAL    (20)
+
 
 
 typedef const gchar *(*ProviderToPluginChar) (BladeBarPluginProvider *provider);
 typedef gint         (*ProviderToPluginInt)  (BladeBarPluginProvider *provider);
+typedef void         (*PluginMenuFunc)       (BladeBarPlugin         *plugin);
+
+/* right-click menu shared by all the plugins in the process */
+typedef struct
+{
+  GtkWidget       *menu;
+
+  /* items updated for each plugin */
+  GtkWidget       *title;
+  GtkWidget       *properties;
+  GtkWidget       *about;
+  GtkWidget       *move;
+  GSList          *unlocked_items;
+
+  /* plugin the menu is filled in for */
+  BladeBarPlugin *plugin;
+}
+PluginMenu;
 
 
 
@@ -88,7 +112,17 @@ static void          blade_bar_plugin_menu_remove            (BladeBarPlugin
 static void          blade_bar_plugin_menu_add_items         (BladeBarPlugin                  *plugin);
 static void          blade_bar_plugin_menu_bar_preferences (BladeBarPlugin                  *plugin);
 static GtkMenu      *blade_bar_plugin_menu_get               (BladeBarPlugin                  *plugin);
+static void          blade_bar_plugin_menu_release           (BladeBarPlugin                  *plugin);
 static inline gchar *blade_bar_plugin_relative_filename      (BladeBarPlugin                  *plugin);
+static gboolean      blade_bar_plugin_position_widget_real   (BladeBarPlugin                  *plugin,
+                                                               GtkWidget                        *menu_widget,
+                                                               GtkWidget                        *attach_widget,
+                                                               gint                             *x,
+                                                               gint                             *y);
+static void          blade_bar_plugin_popup_cancel           (BladeBarPlugin                  *plugin);
+static gboolean      blade_bar_plugin_popup_configure_event  (GtkWidget                        *toplevel,
+                                                               GdkEventConfigure                *event,
+                                                               BladeBarPlugin                  *plugin);
 static void          blade_bar_plugin_unregister_menu        (GtkMenu                          *menu,
                                                                BladeBarPlugin                  *plugin);
 static void          blade_bar_plugin_set_size               (BladeBarPluginProvider          *provider,
@@ -187,22 +221,25 @@ struct _BladeBarPluginPrivate
   /* flags for rembering states */
   PluginFlags          flags;
 
-  /* plugin right-click menu */
-  GtkMenu             *menu;
-
   /* menu block counter (configure insensitive) */
   gint                 menu_blocked;
 
   /* autohide block counter */
   gint                 bar_lock;
+
+  /* popup positioned before the bar was shown */
+  GtkWidget           *popup_widget;
+  GtkWidget           *popup_attach_widget;
+  GtkWidget           *popup_toplevel;
+  guint                popup_timeout_id;
+  guint                popup_poll_id;
 };
 
 
 
 static guint       plugin_signals[LAST_SIGNAL];
-static GQuark      item_properties = 0;
-static GQuark      item_about = 0;
 static GParamSpec *plugin_props[N_PROPERTIES] = { NULL, };
+static PluginMenu *plugin_menu = NULL;
 
 
 
@@ -675,9 +712,6 @@ blade_bar_plugin_class_init (BladeBarPluginClass *klass)
 
   /* install all properties */
   g_object_class_install_properties (gobject_class, N_PROPERTIES, plugin_props);
-
-  item_properties = g_quark_from_static_string ("item-properties");
-  item_about = g_quark_from_static_string ("item-about");
 }
 
 
@@ -699,9 +733,13 @@ blade_bar_plugin_init (BladeBarPlugin *plugin)
   plugin->priv->shrink = FALSE;
   plugin->priv->mode = BLADE_BAR_PLUGIN_MODE_HORIZONTAL;
   plugin->priv->screen_position = XFCE_SCREEN_POSITION_NONE;
-  plugin->priv->menu = NULL;
   plugin->priv->menu_blocked = 0;
   plugin->priv->bar_lock = 0;
+  plugin->priv->popup_widget = NULL;
+  plugin->priv->popup_attach_widget = NULL;
+  plugin->priv->popup_toplevel = NULL;
+  plugin->priv->popup_timeout_id = 0;
+  plugin->priv->popup_poll_id = 0;
   plugin->priv->flags = 0;
   plugin->priv->locked = TRUE;
   plugin->priv->menu_items = NULL;
@@ -905,6 +943,11 @@ blade_bar_plugin_dispose (GObject *object)
       BAR_SET_FLAG (plugin->priv->flags, PLUGIN_FLAG_DISPOSED);
     }
 
+  blade_bar_plugin_popup_cancel (plugin);
+
+  /* take our items out of the shared menu */
+  blade_bar_plugin_menu_release (plugin);
+
   (*G_OBJECT_CLASS (blade_bar_plugin_parent_class)->dispose) (object);
 }
 
@@ -916,23 +959,14 @@ blade_bar_plugin_finalize (GObject *object)
   BladeBarPlugin *plugin = BLADE_BAR_PLUGIN (object);
   GSList          *li;
 
-  /* destroy the menu */
-  if (plugin->priv->menu != NULL)
+  /* release custom menu items */
+  for (li = plugin->priv->menu_items; li != NULL; li = li->next)
     {
-      gtk_widget_destroy (GTK_WIDGET (plugin->priv->menu));
-      bar_assert (plugin->priv->menu_items == NULL);
-    }
-  else
-    {
-      /* release custom menu items */
-      for (li = plugin->priv->menu_items; li != NULL; li = li->next)
-        {
-          g_signal_handlers_disconnect_by_func (G_OBJECT (li->data),
-              G_CALLBACK (blade_bar_plugin_menu_item_destroy), plugin);
-          g_object_unref (G_OBJECT (li->data));
-        }
-      g_slist_free (plugin->priv->menu_items);
+      g_signal_handlers_disconnect_by_func (G_OBJECT (li->data),
+          G_CALLBACK (blade_bar_plugin_menu_item_destroy), plugin);
+      g_object_unref (G_OBJECT (li->data));
     }
+  g_slist_free (plugin->priv->menu_items);
 
   g_free (plugin->priv->name);
   g_free (plugin->priv->display_name);
@@ -976,7 +1010,6 @@ blade_bar_plugin_button_press_event (GtkWidget      *widget,
   BladeBarPlugin *plugin = BLADE_BAR_PLUGIN (widget);
   guint            modifiers;
   GtkMenu         *menu;
-  GtkWidget       *item;
 
   bar_return_val_if_fail (BLADE_IS_BAR_PLUGIN (widget), FALSE);
 
@@ -989,11 +1022,6 @@ blade_bar_plugin_button_press_event (GtkWidget      *widget,
       /* get the bar menu */
       menu = blade_bar_plugin_menu_get (plugin);
 
-      /* if the menu is block, some items are insensitive */
-      item = g_object_get_qdata (G_OBJECT (menu), item_properties);
-      if (item != NULL)
-        gtk_widget_set_sensitive (item, plugin->priv->menu_blocked == 0);
-
       /* popup the menu */
       gtk_menu_popup (menu, NULL, NULL, NULL, NULL, event->button, event->time);
 
@@ -1125,182 +1153,239 @@ blade_bar_plugin_menu_bar_help (BladeBarPlugin *plugin)
 
 
 static void
-blade_bar_plugin_menu_destroy (BladeBarPlugin *plugin)
+blade_bar_plugin_menu_activate (GtkWidget      *item,
+                                PluginMenuFunc  func)
 {
-  GSList *li;
+  /* run the action for the plugin the menu was opened for */
+  if (G_LIKELY (plugin_menu->plugin != NULL))
+    (*func) (plugin_menu->plugin);
+}
 
-  bar_return_if_fail (BLADE_IS_BAR_PLUGIN (plugin));
 
-  if (plugin->priv->menu != NULL)
-    {
-      /* remove custom items before they get destroyed */
-      for (li = plugin->priv->menu_items; li != NULL; li = li->next)
-        gtk_container_remove (GTK_CONTAINER (plugin->priv->menu), GTK_WIDGET (li->data));
 
-      gtk_widget_destroy (GTK_WIDGET (plugin->priv->menu));
-      plugin->priv->menu = NULL;
+static GtkWidget *
+blade_bar_plugin_menu_append (GtkWidget      *menu,
+                              GtkWidget      *item,
+                              PluginMenuFunc  func,
+                              const gchar    *stock_id,
+                              gboolean        unlocked_only)
+{
+  GtkWidget *image;
+
+  if (func != NULL)
+    g_signal_connect (G_OBJECT (item), "activate",
+        G_CALLBACK (blade_bar_plugin_menu_activate), (gpointer) func);
+
+  if (stock_id != NULL)
+    {
+      image = gtk_image_new_from_stock (stock_id, GTK_ICON_SIZE_MENU);
+      gtk_image_menu_item_set_image (GTK_IMAGE_MENU_ITEM (item), image);
+      gtk_widget_show (image);
     }
+
+  gtk_menu_shell_append (GTK_MENU_SHELL (menu), item);
+  gtk_widget_show (item);
+
+  /* items hidden when the plugin is locked */
+  if (unlocked_only)
+    plugin_menu->unlocked_items = g_slist_prepend (plugin_menu->unlocked_items, item);
+
+  return item;
 }
 
 
 
-static GtkMenu *
-blade_bar_plugin_menu_get (BladeBarPlugin *plugin)
+static void
+blade_bar_plugin_menu_create (void)
 {
   GtkWidget *menu, *submenu;
   GtkWidget *item;
   GtkWidget *image;
-  gboolean   locked;
-  GSList    *li;
+
+  bar_return_if_fail (plugin_menu == NULL);
+
+  plugin_menu = g_slice_new0 (PluginMenu);
+
+  menu = gtk_menu_new ();
+  plugin_menu->menu = g_object_ref_sink (menu);
+
+  /* item with plugin name */
+  item = gtk_menu_item_new_with_label ("");
+  plugin_menu->title = blade_bar_plugin_menu_append (menu, item, NULL, NULL, FALSE);
+  gtk_widget_set_sensitive (item, FALSE);
+
+  /* separator */
+  blade_bar_plugin_menu_append (menu, gtk_separator_menu_item_new (), NULL, NULL, FALSE);
+
+  /* properties item */
+  item = gtk_image_menu_item_new_from_stock (GTK_STOCK_PROPERTIES, NULL);
+  plugin_menu->properties = blade_bar_plugin_menu_append (menu, item,
+      (PluginMenuFunc) blade_bar_plugin_show_configure, NULL, TRUE);
+
+  /* about item */
+  item = gtk_image_menu_item_new_from_stock (GTK_STOCK_ABOUT, NULL);
+  plugin_menu->about = blade_bar_plugin_menu_append (menu, item,
+      (PluginMenuFunc) blade_bar_plugin_show_about, NULL, TRUE);
+
+  /* move item, the custom items of a plugin are inserted below it */
+  item = gtk_image_menu_item_new_with_mnemonic (_("_Move"));
+  plugin_menu->move = blade_bar_plugin_menu_append (menu, item,
+      blade_bar_plugin_menu_move, GTK_STOCK_GO_FORWARD, TRUE);
+
+  /* separator */
+  blade_bar_plugin_menu_append (menu, gtk_separator_menu_item_new (), NULL, NULL, TRUE);
+
+  /* remove */
+  item = gtk_image_menu_item_new_from_stock (GTK_STOCK_REMOVE, NULL);
+  blade_bar_plugin_menu_append (menu, item, blade_bar_plugin_menu_remove, NULL, TRUE);
+
+  /* separator */
+  blade_bar_plugin_menu_append (menu, gtk_separator_menu_item_new (), NULL, NULL, TRUE);
+
+  /* create a bar submenu item */
+  submenu = gtk_menu_new ();
+  item = gtk_menu_item_new_with_mnemonic (_("Pane_l"));
+  blade_bar_plugin_menu_append (menu, item, NULL, NULL, FALSE);
+  gtk_menu_item_set_submenu (GTK_MENU_ITEM (item), submenu);
+
+  /* add new items */
+  item = gtk_image_menu_item_new_with_mnemonic (_("Add _New Items..."));
+  blade_bar_plugin_menu_append (submenu, item,
+      blade_bar_plugin_menu_add_items, GTK_STOCK_ADD, TRUE);
+
+  /* customize bar */
+  item = gtk_image_menu_item_new_with_mnemonic (_("Bar Pr_eferences..."));
+  blade_bar_plugin_menu_append (submenu, item,
+      blade_bar_plugin_menu_bar_preferences, GTK_STOCK_PREFERENCES, TRUE);
+
+  /* separator */
+  blade_bar_plugin_menu_append (submenu, gtk_separator_menu_item_new (), NULL, NULL, TRUE);
+
+  /* logout item */
+  item = gtk_image_menu_item_new_with_mnemonic (_("Log _Out"));
+  blade_bar_plugin_menu_append (submenu, item,
+      blade_bar_plugin_menu_bar_logout, NULL, FALSE);
+
+  image = gtk_image_new_from_icon_name ("system-log-out", GTK_ICON_SIZE_MENU);
+  gtk_image_menu_item_set_image (GTK_IMAGE_MENU_ITEM (item), image);
+  gtk_widget_show (image);
+
+  /* separator */
+  blade_bar_plugin_menu_append (submenu, gtk_separator_menu_item_new (), NULL, NULL, FALSE);
+
+  /* help item */
+  item = gtk_image_menu_item_new_from_stock (GTK_STOCK_HELP, NULL);
+  blade_bar_plugin_menu_append (submenu, item, blade_bar_plugin_menu_bar_help, NULL, FALSE);
+
+  /* about item */
+  item = gtk_image_menu_item_new_from_stock (GTK_STOCK_ABOUT, NULL);
+  blade_bar_plugin_menu_append (submenu, item, blade_bar_plugin_menu_bar_about, NULL, FALSE);
+}
+
+
+
+static void
+blade_bar_plugin_menu_release (BladeBarPlugin *plugin)
+{
+  GSList *li;
+
+  bar_return_if_fail (BLADE_IS_BAR_PLUGIN (plugin));
+
+  if (plugin_menu == NULL
+      || plugin_menu->plugin != plugin)
+    return;
+
+  /* don't leave the menu open for a plugin that is gone */
+  gtk_menu_popdown (GTK_MENU (plugin_menu->menu));
+
+  /* remove custom items before they get destroyed */
+  for (li = plugin->priv->menu_items; li != NULL; li = li->next)
+    if (gtk_widget_get_parent (GTK_WIDGET (li->data)) == plugin_menu->menu)
+      gtk_container_remove (GTK_CONTAINER (plugin_menu->menu), GTK_WIDGET (li->data));
+
+  /* handlers from blade_bar_plugin_register_menu() */
+  g_signal_handlers_disconnect_matched (G_OBJECT (plugin_menu->menu),
+      G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, plugin);
+
+  if (gtk_menu_get_attach_widget (GTK_MENU (plugin_menu->menu)) != NULL)
+    gtk_menu_detach (GTK_MENU (plugin_menu->menu));
+
+  plugin_menu->plugin = NULL;
+}
+
+
+
+static GtkMenu *
+blade_bar_plugin_menu_get (BladeBarPlugin *plugin)
+{
+  gboolean  locked;
+  GSList   *li;
+  GList    *children;
+  gint      position;
 
   bar_return_val_if_fail (BLADE_IS_BAR_PLUGIN (plugin), NULL);
 
-  if (G_UNLIKELY (plugin->priv->menu == NULL))
+  /* the menu is created once and filled in for the plugin that
+   * pops it up, plugins don't keep their own copy */
+  if (G_UNLIKELY (plugin_menu == NULL))
+    blade_bar_plugin_menu_create ();
+
+  if (plugin_menu->plugin != plugin)
     {
-      locked = blade_bar_plugin_get_locked (plugin);
+      if (plugin_menu->plugin != NULL)
+        blade_bar_plugin_menu_release (plugin_menu->plugin);
 
-      menu = gtk_menu_new ();
-      gtk_menu_attach_to_widget (GTK_MENU (menu), GTK_WIDGET (plugin), NULL);
+      plugin_menu->plugin = plugin;
+      gtk_menu_attach_to_widget (GTK_MENU (plugin_menu->menu), GTK_WIDGET (plugin), NULL);
+    }
 
-      /* item with plugin name */
-      item = gtk_menu_item_new_with_label (blade_bar_plugin_get_display_name (plugin));
-      gtk_menu_shell_append (GTK_MENU_SHELL (menu), item);
-      gtk_widget_set_sensitive (item, FALSE);
-      gtk_widget_show (item);
+  locked = blade_bar_plugin_get_locked (plugin);
 
-      /* separator */
-      item = gtk_separator_menu_item_new ();
-      gtk_menu_shell_append (GTK_MENU_SHELL (menu), item);
-      gtk_widget_show (item);
+  gtk_menu_item_set_label (GTK_MENU_ITEM (plugin_menu->title),
+                           blade_bar_plugin_get_display_name (plugin));
 
-      if (!locked)
-        {
-          /* properties item */
-          item = gtk_image_menu_item_new_from_stock (GTK_STOCK_PROPERTIES, NULL);
-          g_signal_connect_swapped (G_OBJECT (item), "activate",
-              G_CALLBACK (blade_bar_plugin_show_configure), plugin);
-          g_object_set_qdata (G_OBJECT (menu), item_properties, item);
-          gtk_menu_shell_append (GTK_MENU_SHELL (menu), item);
-          if (BAR_HAS_FLAG (plugin->priv->flags, PLUGIN_FLAG_SHOW_CONFIGURE))
-            gtk_widget_show (item);
-
-          /* about item */
-          item = gtk_image_menu_item_new_from_stock (GTK_STOCK_ABOUT, NULL);
-          g_signal_connect_swapped (G_OBJECT (item), "activate",
-              G_CALLBACK (blade_bar_plugin_show_about), plugin);
-          g_object_set_qdata (G_OBJECT (menu), item_about, item);
-          gtk_menu_shell_append (GTK_MENU_SHELL (menu), item);
-          if (BAR_HAS_FLAG (plugin->priv->flags, PLUGIN_FLAG_SHOW_ABOUT))
-            gtk_widget_show (item);
-
-          /* move item */
-          item = gtk_image_menu_item_new_with_mnemonic (_("_Move"));
-          g_signal_connect_swapped (G_OBJECT (item), "activate",
-              G_CALLBACK (blade_bar_plugin_menu_move), plugin);
-          gtk_menu_shell_append (GTK_MENU_SHELL (menu), item);
-          gtk_widget_show (item);
-
-          image = gtk_image_new_from_stock (GTK_STOCK_GO_FORWARD, GTK_ICON_SIZE_MENU);
-          gtk_image_menu_item_set_image (GTK_IMAGE_MENU_ITEM (item), image);
-          gtk_widget_show (image);
-
-          /* add custom menu items */
-          for (li = plugin->priv->menu_items; li != NULL; li = li->next)
-            gtk_menu_shell_append (GTK_MENU_SHELL (menu), GTK_WIDGET (li->data));
-
-          /* separator */
-          item = gtk_separator_menu_item_new ();
-          gtk_menu_shell_append (GTK_MENU_SHELL (menu), item);
-          gtk_widget_show (item);
-
-          /* remove */
-          item = gtk_image_menu_item_new_from_stock (GTK_STOCK_REMOVE, NULL);
-          g_signal_connect_swapped (G_OBJECT (item), "activate",
-              G_CALLBACK (blade_bar_plugin_menu_remove), plugin);
-          gtk_menu_shell_append (GTK_MENU_SHELL (menu), item);
-          gtk_widget_show (item);
-
-          /* separator */
-          item = gtk_separator_menu_item_new ();
-          gtk_menu_shell_append (GTK_MENU_SHELL (menu), item);
-          gtk_widget_show (item);
-        }
+  for (li = plugin_menu->unlocked_items; li != NULL; li = li->next)
+    gtk_widget_set_visible (GTK_WIDGET (li->data), !locked);
 
-      /* create a bar submenu item */
-      submenu = gtk_menu_new ();
-      item = gtk_menu_item_new_with_mnemonic (_("Pane_l"));
-      gtk_menu_shell_append (GTK_MENU_SHELL (menu), item);
-      gtk_menu_item_set_submenu (GTK_MENU_ITEM (item), submenu);
-      gtk_widget_show (item);
+  /* add custom menu items, the lock state can change between popups */
+  if (plugin->priv->menu_items != NULL)
+    {
+      children = gtk_container_get_children (GTK_CONTAINER (plugin_menu->menu));
+      position = g_list_index (children, plugin_menu->move) + 1;
+      g_list_free (children);
 
-      if (!locked)
+      for (li = plugin->priv->menu_items; li != NULL; li = li->next)
         {
-          /* add new items */
-          item = gtk_image_menu_item_new_with_mnemonic (_("Add _New Items..."));
-          g_signal_connect_swapped (G_OBJECT (item), "activate",
-              G_CALLBACK (blade_bar_plugin_menu_add_items), plugin);
-          gtk_menu_shell_append (GTK_MENU_SHELL (submenu), item);
-          gtk_widget_show (item);
-
-          image = gtk_image_new_from_stock (GTK_STOCK_ADD, GTK_ICON_SIZE_MENU);
-          gtk_image_menu_item_set_image (GTK_IMAGE_MENU_ITEM (item), image);
-          gtk_widget_show (image);
-
-          /* customize bar */
-          item = gtk_image_menu_item_new_with_mnemonic (_("Bar Pr_eferences..."));
-          g_signal_connect_swapped (G_OBJECT (item), "activate",
-              G_CALLBACK (blade_bar_plugin_menu_bar_preferences), plugin);
-          gtk_menu_shell_append (GTK_MENU_SHELL (submenu), item);
-          gtk_widget_show (item);
-
-          image = gtk_image_new_from_stock (GTK_STOCK_PREFERENCES, GTK_ICON_SIZE_MENU);
-          gtk_image_menu_item_set_image (GTK_IMAGE_MENU_ITEM (item), image);
-          gtk_widget_show (image);
-
-          /* separator */
-          item = gtk_separator_menu_item_new ();
-          gtk_menu_shell_append (GTK_MENU_SHELL (submenu), item);
-          gtk_widget_show (item);
+          if (gtk_widget_get_parent (GTK_WIDGET (li->data)) == plugin_menu->menu)
+            {
+              if (!locked)
+                {
+                  position++;
+                  continue;
+                }
+
+              gtk_container_remove (GTK_CONTAINER (plugin_menu->menu), GTK_WIDGET (li->data));
+            }
+          else if (!locked)
+            {
+              gtk_menu_shell_insert (GTK_MENU_SHELL (plugin_menu->menu),
+                                     GTK_WIDGET (li->data), position++);
+            }
         }
+    }
 
-      /* logout item */
-      item = gtk_image_menu_item_new_with_mnemonic (_("Log _Out"));
-      g_signal_connect_swapped (G_OBJECT (item), "activate",
-          G_CALLBACK (blade_bar_plugin_menu_bar_logout), plugin);
-      gtk_menu_shell_append (GTK_MENU_SHELL (submenu), item);
-      gtk_widget_show (item);
-
-      image = gtk_image_new_from_icon_name ("system-log-out", GTK_ICON_SIZE_MENU);
-      gtk_image_menu_item_set_image (GTK_IMAGE_MENU_ITEM (item), image);
-      gtk_widget_show (image);
+  gtk_widget_set_visible (plugin_menu->properties, !locked
+      && BAR_HAS_FLAG (plugin->priv->flags, PLUGIN_FLAG_SHOW_CONFIGURE));
+  gtk_widget_set_visible (plugin_menu->about, !locked
+      && BAR_HAS_FLAG (plugin->priv->flags, PLUGIN_FLAG_SHOW_ABOUT));
 
-      /* separator */
-      item = gtk_separator_menu_item_new ();
-      gtk_menu_shell_append (GTK_MENU_SHELL (submenu), item);
-      gtk_widget_show (item);
-
-      /* help item */
-      item = gtk_image_menu_item_new_from_stock (GTK_STOCK_HELP, NULL);
-      g_signal_connect_swapped (G_OBJECT (item), "activate",
-          G_CALLBACK (blade_bar_plugin_menu_bar_help), plugin);
-      gtk_menu_shell_append (GTK_MENU_SHELL (submenu), item);
-      gtk_widget_show (item);
-
-      /* about item */
-      item = gtk_image_menu_item_new_from_stock (GTK_STOCK_ABOUT, NULL);
-      g_signal_connect_swapped (G_OBJECT (item), "activate",
-          G_CALLBACK (blade_bar_plugin_menu_bar_about), plugin);
-      gtk_menu_shell_append (GTK_MENU_SHELL (submenu), item);
-      gtk_widget_show (item);
-
-      /* set bar menu */
-      plugin->priv->menu = GTK_MENU (menu);
-    }
+  /* if the menu is block, some items are insensitive */
+  gtk_widget_set_sensitive (plugin_menu->properties, plugin->priv->menu_blocked == 0);
 
   /* block autohide when this menu is shown */
-  blade_bar_plugin_register_menu (plugin, GTK_MENU (plugin->priv->menu));
+  blade_bar_plugin_register_menu (plugin, GTK_MENU (plugin_menu->menu));
 
-  return plugin->priv->menu;
+  return GTK_MENU (plugin_menu->menu);
 }
 
 
@@ -1319,6 +1404,147 @@ blade_bar_plugin_relative_filename (BladeBarPlugin *plugin)
 
 
 
+static void
+blade_bar_plugin_popup_cancel (BladeBarPlugin *plugin)
+{
+  BladeBarPluginPrivate *priv = plugin->priv;
+
+  if (priv->popup_widget == NULL)
+    return;
+
+  if (priv->popup_timeout_id != 0)
+    g_source_remove (priv->popup_timeout_id);
+
+  if (priv->popup_poll_id != 0)
+    g_source_remove (priv->popup_poll_id);
+
+  /* only our handler, the plugin can connect to its toplevel too */
+  g_signal_handlers_disconnect_by_func (G_OBJECT (priv->popup_toplevel),
+      G_CALLBACK (blade_bar_plugin_popup_configure_event), plugin);
+
+  g_object_unref (G_OBJECT (priv->popup_widget));
+  g_object_unref (G_OBJECT (priv->popup_attach_widget));
+  g_object_unref (G_OBJECT (priv->popup_toplevel));
+
+  priv->popup_widget = NULL;
+  priv->popup_attach_widget = NULL;
+  priv->popup_toplevel = NULL;
+}
+
+
+
+static void
+blade_bar_plugin_popup_move (BladeBarPlugin *plugin,
+                             gboolean        force)
+{
+  BladeBarPluginPrivate *priv = plugin->priv;
+  GtkWidget             *window;
+  gint                   x, y;
+
+  /* the popup stays offscreen until the bar is shown */
+  if (!blade_bar_plugin_position_widget_real (plugin, priv->popup_widget,
+                                              priv->popup_attach_widget, &x, &y)
+      && !force)
+    return;
+
+  /* the window of a menu is its toplevel */
+  window = gtk_widget_get_toplevel (priv->popup_widget);
+  if (GTK_IS_WINDOW (window))
+    gtk_window_move (GTK_WINDOW (window), x, y);
+
+  blade_bar_plugin_popup_cancel (plugin);
+}
+
+
+
+static gboolean
+blade_bar_plugin_popup_configure_event (GtkWidget          *toplevel,
+                                        GdkEventConfigure  *event,
+                                        BladeBarPlugin    *plugin)
+{
+  blade_bar_plugin_popup_move (plugin, FALSE);
+
+  return FALSE;
+}
+
+
+
+static gboolean
+blade_bar_plugin_popup_poll (gpointer user_data)
+{
+  BladeBarPlugin *plugin = BLADE_BAR_PLUGIN (user_data);
+
+  /* the plug of an external plugin is not moved with the bar, so
+   * it never sees a configure-event; check the bar geometry */
+  blade_bar_plugin_popup_move (plugin, FALSE);
+
+  return plugin->priv->popup_widget != NULL;
+}
+
+
+
+static void
+blade_bar_plugin_popup_poll_destroyed (gpointer user_data)
+{
+  BLADE_BAR_PLUGIN (user_data)->priv->popup_poll_id = 0;
+}
+
+
+
+static gboolean
+blade_bar_plugin_popup_timeout (gpointer user_data)
+{
+  BladeBarPlugin *plugin = BLADE_BAR_PLUGIN (user_data);
+
+  /* give up waiting, use what we have now */
+  blade_bar_plugin_popup_move (plugin, TRUE);
+
+  return FALSE;
+}
+
+
+
+static void
+blade_bar_plugin_popup_timeout_destroyed (gpointer user_data)
+{
+  BLADE_BAR_PLUGIN (user_data)->priv->popup_timeout_id = 0;
+}
+
+
+
+static void
+blade_bar_plugin_popup_schedule (BladeBarPlugin *plugin,
+                                 GtkWidget      *menu_widget,
+                                 GtkWidget      *attach_widget)
+{
+  BladeBarPluginPrivate *priv = plugin->priv;
+
+  /* only the last popup is moved */
+  blade_bar_plugin_popup_cancel (plugin);
+
+  priv->popup_widget = g_object_ref (G_OBJECT (menu_widget));
+  priv->popup_attach_widget = g_object_ref (G_OBJECT (attach_widget));
+  priv->popup_toplevel = g_object_ref (G_OBJECT (gtk_widget_get_toplevel (attach_widget)));
+
+  if (GTK_IS_PLUG (priv->popup_toplevel))
+    {
+      priv->popup_poll_id = g_timeout_add_full (G_PRIORITY_DEFAULT, POPUP_POLL_INTERVAL,
+                                                blade_bar_plugin_popup_poll, plugin,
+                                                blade_bar_plugin_popup_poll_destroyed);
+    }
+  else
+    {
+      g_signal_connect (G_OBJECT (priv->popup_toplevel), "configure-event",
+          G_CALLBACK (blade_bar_plugin_popup_configure_event), plugin);
+    }
+
+  priv->popup_timeout_id = g_timeout_add_full (G_PRIORITY_DEFAULT, POPUP_POSITION_TIMEOUT,
+                                               blade_bar_plugin_popup_timeout, plugin,
+                                               blade_bar_plugin_popup_timeout_destroyed);
+}
+
+
+
 static void
 blade_bar_plugin_unregister_menu (GtkMenu         *menu,
                                    BladeBarPlugin *plugin)
@@ -1574,9 +1800,6 @@ blade_bar_plugin_set_locked (BladeBarPluginProvider *provider,
   if (G_LIKELY (plugin->priv->locked != locked))
     {
       plugin->priv->locked = locked;
-
-      /* destroy the menu if it exists */
-      blade_bar_plugin_menu_destroy (plugin);
     }
 }
 
@@ -2113,8 +2336,8 @@ blade_bar_plugin_menu_insert_item (BladeBarPlugin *plugin,
   g_signal_connect (G_OBJECT (item), "destroy",
       G_CALLBACK (blade_bar_plugin_menu_item_destroy), plugin);
 
-  /* destroy the menu */
-  blade_bar_plugin_menu_destroy (plugin);
+  /* the item is added when the menu is filled in again */
+  blade_bar_plugin_menu_release (plugin);
 }
 
 
@@ -2129,24 +2352,12 @@ blade_bar_plugin_menu_insert_item (BladeBarPlugin *plugin,
 void
 blade_bar_plugin_menu_show_configure (BladeBarPlugin *plugin)
 {
-  GtkMenu   *menu;
-  GtkWidget *item;
-
   g_return_if_fail (BLADE_IS_BAR_PLUGIN (plugin));
   g_return_if_fail (BLADE_BAR_PLUGIN_CONSTRUCTED (plugin));
 
+  /* the menu item is shown when the menu pops up */
   BAR_SET_FLAG (plugin->priv->flags, PLUGIN_FLAG_SHOW_CONFIGURE);
 
-  /* show the menu item if the menu is already generated */
-  if (G_UNLIKELY (plugin->priv->menu != NULL))
-    {
-       /* get and show the properties item */
-       menu = blade_bar_plugin_menu_get (plugin);
-       item = g_object_get_qdata (G_OBJECT (menu), item_properties);
-       if (G_LIKELY (item != NULL))
-         gtk_widget_show (item);
-    }
-
   /* emit signal, used by the external plugin */
   blade_bar_plugin_provider_emit_signal (BLADE_BAR_PLUGIN_PROVIDER (plugin),
                                           PROVIDER_SIGNAL_SHOW_CONFIGURE);
@@ -2164,24 +2375,12 @@ blade_bar_plugin_menu_show_configure (BladeBarPlugin *plugin)
 void
 blade_bar_plugin_menu_show_about (BladeBarPlugin *plugin)
 {
-  GtkMenu   *menu;
-  GtkWidget *item;
-
   g_return_if_fail (BLADE_IS_BAR_PLUGIN (plugin));
   g_return_if_fail (BLADE_BAR_PLUGIN_CONSTRUCTED (plugin));
 
+  /* the menu item is shown when the menu pops up */
   BAR_SET_FLAG (plugin->priv->flags, PLUGIN_FLAG_SHOW_ABOUT);
 
-  /* show the menu item if the menu is already generated */
-  if (G_UNLIKELY (plugin->priv->menu != NULL))
-    {
-       /* get and show the about item */
-       menu = blade_bar_plugin_menu_get (plugin);
-       item = g_object_get_qdata (G_OBJECT (menu), item_about);
-       if (G_LIKELY (item != NULL))
-         gtk_widget_show (item);
-    }
-
   /* emit signal, used by the external plugin */
   blade_bar_plugin_provider_emit_signal (BLADE_BAR_PLUGIN_PROVIDER (plugin),
                                           PROVIDER_SIGNAL_SHOW_ABOUT);
@@ -2380,48 +2579,21 @@ blade_bar_plugin_arrow_type (BladeBarPlugin *plugin)
 
 
 
-/**
- * blade_bar_plugin_position_widget:
- * @plugin        : an #BladeBarPlugin.
- * @menu_widget   : a #GtkWidget that will be used as popup menu.
- * @attach_widget : a #GtkWidget relative to which the menu should be positioned.
- * @x             : return location for the x coordinate.
- * @y             : return location for the x coordinate.
- *
- * The menu widget is positioned relative to @attach_widget.
- * If @attach_widget is NULL, the menu widget is instead positioned
- * relative to @bar_plugin.
- *
- * This function is intended for custom menu widgets.
- * For a regular #GtkMenu you should use blade_bar_plugin_position_menu()
- * instead (as callback argument to gtk_menu_popup()).
- *
- * See also: blade_bar_plugin_position_menu().
- **/
-void
-blade_bar_plugin_position_widget (BladeBarPlugin *plugin,
-                                   GtkWidget       *menu_widget,
-                                   GtkWidget       *attach_widget,
-                                   gint            *x,
-                                   gint            *y)
+static gboolean
+blade_bar_plugin_position_widget_real (BladeBarPlugin *plugin,
+                                       GtkWidget      *menu_widget,
+                                       GtkWidget      *attach_widget,
+                                       gint           *x,
+                                       gint           *y)
 {
   GtkRequisition  requisition;
   GdkScreen      *screen;
   GdkRectangle    monitor;
   gint            monitor_num;
-  GTimeVal        now_t, end_t;
   GtkWidget      *toplevel, *plug;
   gint            px, py;
   GtkAllocation   alloc;
-
-  g_return_if_fail (BLADE_IS_BAR_PLUGIN (plugin));
-  g_return_if_fail (GTK_IS_WIDGET (menu_widget));
-  g_return_if_fail (attach_widget == NULL || GTK_IS_WIDGET (attach_widget));
-  g_return_if_fail (BLADE_BAR_PLUGIN_CONSTRUCTED (plugin));
-
-  /* if the attach widget is null, use the bar plugin */
-  if (attach_widget == NULL)
-    attach_widget = GTK_WIDGET (plugin);
+  gboolean        bar_shown;
 
   /* make sure the menu is realized to get valid rectangle sizes */
   if (!gtk_widget_get_realized (menu_widget))
@@ -2458,29 +2630,8 @@ blade_bar_plugin_position_widget (BladeBarPlugin *plugin,
        *y += py;
     }
 
-  /* if the bar is hidden (auto hide is enabled) and we requested a
-   * bar lock, wait for gtk to position the bar before we actually
-   * use the coordinates */
-  if (plugin->priv->bar_lock > 0)
-    {
-      g_get_current_time (&end_t);
-      g_time_val_add (&end_t, G_USEC_PER_SEC / 2);
-
-      while (*x == -9999 && *y == -9999)
-        {
-          while (gtk_events_pending ())
-            gtk_main_iteration ();
-
-          gdk_window_get_position (gtk_widget_get_window (attach_widget), x, y);
-
-          /* don't try longer then 1/2 a second */
-          g_get_current_time (&now_t);
-          if (now_t.tv_sec > end_t.tv_sec
-              || (now_t.tv_sec == end_t.tv_sec
-                  && now_t.tv_usec > end_t.tv_usec))
-            break;
-        }
-    }
+  /* an autohidden bar is moved offscreen */
+  bar_shown = !(*x == -9999 && *y == -9999);
 
   /* add the widgets allocation */
   gtk_widget_get_allocation (attach_widget, &alloc);
@@ -2526,6 +2677,63 @@ blade_bar_plugin_position_widget (BladeBarPlugin *plugin,
     gtk_menu_set_screen (GTK_MENU (menu_widget), screen);
   else if (GTK_IS_WINDOW (menu_widget))
     gtk_window_set_screen (GTK_WINDOW (menu_widget), screen);
+
+  return bar_shown;
+}
+
+
+
+/**
+ * blade_bar_plugin_position_widget:
+ * @plugin        : an #BladeBarPlugin.
+ * @menu_widget   : a #GtkWidget that will be used as popup menu.
+ * @attach_widget : a #GtkWidget relative to which the menu should be positioned.
+ * @x             : return location for the x coordinate.
+ * @y             : return location for the x coordinate.
+ *
+ * The menu widget is positioned relative to @attach_widget.
+ * If @attach_widget is NULL, the menu widget is instead positioned
+ * relative to @bar_plugin.
+ *
+ * This function is intended for custom menu widgets.
+ * For a regular #GtkMenu you should use blade_bar_plugin_position_menu()
+ * instead (as callback argument to gtk_menu_popup()).
+ *
+ * If the bar is autohidden and not on the screen yet, the returned
+ * position is offscreen. The function does not wait for the bar, but
+ * moves the mapped popup to its position once the bar is shown, or
+ * after half a second.
+ *
+ * See also: blade_bar_plugin_position_menu().
+ **/
+void
+blade_bar_plugin_position_widget (BladeBarPlugin *plugin,
+                                   GtkWidget       *menu_widget,
+                                   GtkWidget       *attach_widget,
+                                   gint            *x,
+                                   gint            *y)
+{
+  g_return_if_fail (BLADE_IS_BAR_PLUGIN (plugin));
+  g_return_if_fail (GTK_IS_WIDGET (menu_widget));
+  g_return_if_fail (attach_widget == NULL || GTK_IS_WIDGET (attach_widget));
+  g_return_if_fail (BLADE_BAR_PLUGIN_CONSTRUCTED (plugin));
+
+  /* if the attach widget is null, use the bar plugin */
+  if (attach_widget == NULL)
+    attach_widget = GTK_WIDGET (plugin);
+
+  /* if the bar is hidden (auto hide is enabled) and we requested a
+   * bar lock, the bar is not on the screen yet; map the popup offscreen
+   * so it does not jump and move it when the bar shows up */
+  if (!blade_bar_plugin_position_widget_real (plugin, menu_widget,
+                                              attach_widget, x, y)
+      && plugin->priv->bar_lock > 0)
+    {
+      blade_bar_plugin_popup_schedule (plugin, menu_widget, attach_widget);
+
+      *x = -9999;
+      *y = -9999;
+    }
 }
 
 
@@ -2592,8 +2800,9 @@ blade_bar_plugin_position_menu (GtkMenu  *menu,
   /* Menus are "pushed in" anyway */
   *push_in = FALSE;
 #else
-  /* keep the menu inside screen */
-  *push_in = TRUE;
+  /* keep the menu inside screen, unless it waits offscreen
+   * for an autohidden bar */
+  *push_in = BLADE_BAR_PLUGIN (bar_plugin)->priv->popup_widget != GTK_WIDGET (menu);
 #endif
 }
 
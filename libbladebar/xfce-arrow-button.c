@@ -47,12 +47,17 @@
  * inverted when the button is toggled.
  * Since 4.8 it is also possible to make the button blink and pack additional
  * widgets in the button, using gtk_container_add().
+ *
+ * All blinking buttons in a process follow the same clock, so they are
+ * highlighted in the same frame. When animations are disabled in the
+ * #GtkSettings, a button blinks once and then stays highlighted.
  **/
 
 
 
 #define ARROW_WIDTH        (8)
 #define MAX_BLINKING_COUNT (G_MAXUINT)
+#define BLINKING_INTERVAL  (500)
 
 enum
 {
@@ -92,6 +97,7 @@ static void     xfce_arrow_button_size_request         (GtkWidget             *w
 #endif
 static void     xfce_arrow_button_size_allocate        (GtkWidget             *widget,
                                                         GtkAllocation         *allocation);
+static void     xfce_arrow_button_blinking_leave       (XfceArrowButton       *button);
 
 
 
@@ -100,8 +106,8 @@ struct _XfceArrowButtonPrivate
   /* arrow type of the button */
   GtkArrowType   arrow_type;
 
-  /* blinking timeout id */
-  guint          blinking_timeout_id;
+  /* whether the button blinks or stays highlighted */
+  gboolean       blinking;
 
   /* counter to make the blinking stop when
    * MAX_BLINKING_COUNT is reached */
@@ -115,6 +121,11 @@ struct _XfceArrowButtonPrivate
 
 static guint arrow_button_signals[LAST_SIGNAL];
 
+/* buttons following the blink clock and its highlight phase */
+static GSList   *blinking_buttons = NULL;
+static guint     blinking_timeout_id = 0;
+static gboolean  blinking_highlight = FALSE;
+
 
 
 G_DEFINE_TYPE (XfceArrowButton, xfce_arrow_button, GTK_TYPE_TOGGLE_BUTTON)
@@ -188,7 +199,7 @@ xfce_arrow_button_init (XfceArrowButton *button)
 
   /* initialize button values */
   button->priv->arrow_type = GTK_ARROW_UP;
-  button->priv->blinking_timeout_id = 0;
+  button->priv->blinking = FALSE;
   button->priv->blinking_counter = 0;
   button->priv->last_relief = GTK_RELIEF_NORMAL;
 
@@ -250,8 +261,8 @@ xfce_arrow_button_finalize (GObject *object)
 {
   XfceArrowButton *button = XFCE_ARROW_BUTTON (object);
 
-  if (button->priv->blinking_timeout_id != 0)
-    g_source_remove (button->priv->blinking_timeout_id);
+  if (button->priv->blinking)
+    xfce_arrow_button_blinking_leave (button);
 
   (*G_OBJECT_CLASS (xfce_arrow_button_parent_class)->finalize) (object);
 }
@@ -569,16 +580,15 @@ xfce_arrow_button_size_allocate (GtkWidget     *widget,
 
 
 
-static gboolean
-xfce_arrow_button_blinking_timeout (gpointer user_data)
+static void
+xfce_arrow_button_blinking_highlight (XfceArrowButton *button,
+                                      gboolean         highlight)
 {
-  XfceArrowButton *button = XFCE_ARROW_BUTTON (user_data);
-  GtkStyle        *style;
-  GtkRcStyle      *rc;
+  GtkStyle   *style;
+  GtkRcStyle *rc;
 
   rc = gtk_widget_get_modifier_style (GTK_WIDGET (button));
-  if(BAR_HAS_FLAG (rc->color_flags[GTK_STATE_NORMAL], GTK_RC_BG)
-     || button->priv->blinking_timeout_id == 0)
+  if (!highlight)
     {
       gtk_button_set_relief (GTK_BUTTON (button), button->priv->last_relief);
       BAR_UNSET_FLAG (rc->color_flags[GTK_STATE_NORMAL], GTK_RC_BG);
@@ -592,25 +602,83 @@ xfce_arrow_button_blinking_timeout (gpointer user_data)
       rc->bg[GTK_STATE_NORMAL] = style->bg[GTK_STATE_SELECTED];
       gtk_widget_modify_style(GTK_WIDGET (button), rc);
     }
+}
+
+
+
+static gboolean
+xfce_arrow_button_blinking_timeout (gpointer user_data)
+{
+  GSList          *li, *lnext;
+  XfceArrowButton *button;
+  gboolean         animations;
+
+  /* flip all the buttons in the same frame */
+  blinking_highlight = !blinking_highlight;
+
+  for (li = blinking_buttons; li != NULL; li = lnext)
+    {
+      lnext = li->next;
+      button = XFCE_ARROW_BUTTON (li->data);
+
+      xfce_arrow_button_blinking_highlight (button, blinking_highlight);
+
+      if (++button->priv->blinking_counter >= MAX_BLINKING_COUNT)
+        {
+          xfce_arrow_button_set_blinking (button, FALSE);
+          continue;
+        }
+
+      if (blinking_highlight && button->priv->blinking_counter >= 2)
+        {
+          /* with reduced motion, stop after the first cycle and leave
+           * the button highlighted until the blinking is unset */
+          g_object_get (gtk_widget_get_settings (GTK_WIDGET (button)),
+                        "gtk-enable-animations", &animations, NULL);
+          if (!animations)
+            xfce_arrow_button_blinking_leave (button);
+        }
+    }
 
-  return (button->priv->blinking_counter++ < MAX_BLINKING_COUNT);
+  return TRUE;
 }
 
 
 
 static void
-xfce_arrow_button_blinking_timeout_destroyed (gpointer user_data)
+xfce_arrow_button_blinking_join (XfceArrowButton *button)
 {
-  XfceArrowButton *button = XFCE_ARROW_BUTTON (user_data);
-  GtkRcStyle      *rc;
+  bar_return_if_fail (g_slist_find (blinking_buttons, button) == NULL);
 
-  rc = gtk_widget_get_modifier_style (GTK_WIDGET (button));
-  gtk_button_set_relief (GTK_BUTTON (button), button->priv->last_relief);
-  BAR_UNSET_FLAG (rc->color_flags[GTK_STATE_NORMAL], GTK_RC_BG);
-  gtk_widget_modify_style (GTK_WIDGET (button), rc);
+  if (blinking_timeout_id == 0)
+    {
+      /* start the clock with the highlight on */
+      blinking_highlight = TRUE;
+      blinking_timeout_id =
+          gdk_threads_add_timeout_full (G_PRIORITY_DEFAULT_IDLE, BLINKING_INTERVAL,
+                                        xfce_arrow_button_blinking_timeout, NULL, NULL);
+    }
 
-  button->priv->blinking_timeout_id = 0;
+  /* join in the current phase */
+  blinking_buttons = g_slist_prepend (blinking_buttons, button);
   button->priv->blinking_counter = 0;
+  xfce_arrow_button_blinking_highlight (button, blinking_highlight);
+}
+
+
+
+static void
+xfce_arrow_button_blinking_leave (XfceArrowButton *button)
+{
+  blinking_buttons = g_slist_remove (blinking_buttons, button);
+
+  /* stop the clock when nobody follows it */
+  if (blinking_buttons == NULL
+      && blinking_timeout_id != 0)
+    {
+      g_source_remove (blinking_timeout_id);
+      blinking_timeout_id = 0;
+    }
 }
 
 
@@ -689,6 +757,8 @@ xfce_arrow_button_set_arrow_type (XfceArrowButton *button,
  *
  * Whether the button is blinking. If the blink timeout is finished
  * and the button is still highlighted, this functions returns %FALSE.
+ * A button that stopped blinking because animations are disabled
+ * is still considered blinking.
  *
  * Returns: %TRUE when @button is blinking.
  *
@@ -698,7 +768,7 @@ gboolean
 xfce_arrow_button_get_blinking (XfceArrowButton *button)
 {
   g_return_val_if_fail (XFCE_IS_ARROW_BUTTON (button), FALSE);
-  return !!(button->priv->blinking_timeout_id != 0);
+  return button->priv->blinking;
 }
 
 
@@ -724,20 +794,20 @@ xfce_arrow_button_set_blinking (XfceArrowButton *button,
       /* store the relief of the button */
       button->priv->last_relief = gtk_button_get_relief (GTK_BUTTON (button));
 
-      if (button->priv->blinking_timeout_id == 0)
+      if (!button->priv->blinking)
         {
-          /* start blinking timeout */
-          button->priv->blinking_timeout_id =
-              gdk_threads_add_timeout_full (G_PRIORITY_DEFAULT_IDLE, 500,
-                                            xfce_arrow_button_blinking_timeout, button,
-                                            xfce_arrow_button_blinking_timeout_destroyed);
-          xfce_arrow_button_blinking_timeout (button);
+          /* follow the shared blink clock */
+          button->priv->blinking = TRUE;
+          xfce_arrow_button_blinking_join (button);
         }
     }
-  else if (button->priv->blinking_timeout_id != 0)
+  else if (button->priv->blinking)
     {
-      /* stop the blinking timeout */
-      g_source_remove (button->priv->blinking_timeout_id);
+      /* stop following the clock and restore the button */
+      button->priv->blinking = FALSE;
+      xfce_arrow_button_blinking_leave (button);
+      xfce_arrow_button_blinking_highlight (button, FALSE);
+      button->priv->blinking_counter = 0;
     }
 }
 
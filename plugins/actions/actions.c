@@ -39,6 +39,8 @@
 
 #define DEFAULT_ICON_SIZE (16)
 #define DEFAULT_TIMEOUT   (30)
+#define PROBE_CACHE_TIME  (60) /* seconds */
+#define N_PROBES          (4)
 
 
 
@@ -103,6 +105,12 @@ struct _ActionsPlugin
   guint           invert_orientation : 1;
   guint           ask_confirmation : 1;
   guint           pack_idle_id;
+
+  /* cached result of the capability probes */
+  gint            allowed_types;
+  glong           probe_time;
+  DBusGProxy     *probe_proxy;
+  DBusGProxyCall *probe_calls[N_PROBES];
 };
 
 typedef enum
@@ -131,6 +139,13 @@ typedef struct
 }
 ActionEntry;
 
+typedef struct
+{
+  const gchar *method;
+  ActionType   type;
+}
+ActionProbe;
+
 typedef struct
 {
   ActionEntry *entry;
@@ -209,6 +224,14 @@ static ActionEntry action_entries[] =
   }
 };
 
+static const ActionProbe action_probes[N_PROBES] =
+{
+  { "CanShutdown", ACTION_TYPE_SHUTDOWN },
+  { "CanRestart", ACTION_TYPE_RESTART },
+  { "CanSuspend", ACTION_TYPE_SUSPEND },
+  { "CanHibernate", ACTION_TYPE_HIBERNATE }
+};
+
 
 
 /* define the plugin */
@@ -285,6 +308,7 @@ actions_plugin_init (ActionsPlugin *plugin)
   plugin->type = APPEARANCE_TYPE_MENU;
   plugin->invert_orientation = FALSE;
   plugin->ask_confirmation = TRUE;
+  plugin->allowed_types = ACTION_TYPE_SEPARATOR;
 }
 
 
@@ -396,10 +420,20 @@ static void
 actions_plugin_free_data (BladeBarPlugin *bar_plugin)
 {
   ActionsPlugin *plugin = XFCE_ACTIONS_PLUGIN (bar_plugin);
+  guint          i;
 
   if (plugin->pack_idle_id != 0)
     g_source_remove (plugin->pack_idle_id);
 
+  if (plugin->probe_proxy != NULL)
+    {
+      for (i = 0; i < N_PROBES; i++)
+        if (plugin->probe_calls[i] != NULL)
+          dbus_g_proxy_cancel_call (plugin->probe_proxy, plugin->probe_calls[i]);
+
+      g_object_unref (G_OBJECT (plugin->probe_proxy));
+    }
+
   if (plugin->items != NULL)
     blconf_array_free (plugin->items);
 
@@ -833,76 +867,136 @@ actions_plugin_action_dbus_xfsm (const gchar  *method,
 
 
 
-static gboolean
-actions_plugin_action_dbus_can (DBusGProxy  *proxy,
-                                const gchar *method)
+static void
+actions_plugin_update_sensitive_child (GtkWidget *widget,
+                                       gpointer   data)
 {
-  gboolean allowed = FALSE;
+  ActionsPlugin *plugin = XFCE_ACTIONS_PLUGIN (data);
+  ActionEntry   *entry;
+
+  entry = g_object_get_qdata (G_OBJECT (widget), action_quark);
+  if (entry != NULL)
+    gtk_widget_set_sensitive (widget, BAR_HAS_FLAG (plugin->allowed_types, entry->type));
+}
 
-  if (dbus_g_proxy_call (proxy, method, NULL,
-                         G_TYPE_INVALID,
-                         G_TYPE_BOOLEAN, &allowed,
-                         G_TYPE_INVALID))
-    return allowed;
 
-  return FALSE;
+
+static void
+actions_plugin_update_sensitive (ActionsPlugin *plugin)
+{
+  GtkWidget *child;
+
+  /* apply the cached capabilities on the buttons and menu items */
+  child = gtk_bin_get_child (GTK_BIN (plugin));
+  if (child != NULL && plugin->type == APPEARANCE_TYPE_BUTTONS)
+    gtk_container_foreach (GTK_CONTAINER (child),
+        actions_plugin_update_sensitive_child, plugin);
+
+  if (plugin->menu != NULL)
+    gtk_container_foreach (GTK_CONTAINER (plugin->menu),
+        actions_plugin_update_sensitive_child, plugin);
 }
 
 
 
-static ActionType
-actions_plugin_actions_allowed (void)
+static void
+actions_plugin_probe_reply (DBusGProxy     *proxy,
+                            DBusGProxyCall *call,
+                            gpointer        user_data)
+{
+  ActionsPlugin *plugin = XFCE_ACTIONS_PLUGIN (user_data);
+  gboolean       allowed = FALSE;
+  guint          i;
+
+  for (i = 0; i < N_PROBES; i++)
+    if (plugin->probe_calls[i] == call)
+      break;
+
+  bar_return_if_fail (i < N_PROBES);
+  plugin->probe_calls[i] = NULL;
+
+  /* a failed call disables the action, like a negative answer */
+  if (!dbus_g_proxy_end_call (proxy, call, NULL,
+                              G_TYPE_BOOLEAN, &allowed,
+                              G_TYPE_INVALID))
+    allowed = FALSE;
+
+  if (allowed)
+    BAR_SET_FLAG (plugin->allowed_types, action_probes[i].type);
+  else
+    BAR_UNSET_FLAG (plugin->allowed_types, action_probes[i].type);
+
+  actions_plugin_update_sensitive (plugin);
+}
+
+
+
+static void
+actions_plugin_probe (ActionsPlugin *plugin)
 {
   DBusGConnection *conn;
-  ActionType       allow_mask = ACTION_TYPE_SEPARATOR;
   gchar           *path;
-  DBusGProxy      *proxy;
   GError          *error = NULL;
+  GTimeVal         now;
+  guint            i;
+
+  /* use the cached answers if they are recent enough */
+  g_get_current_time (&now);
+  if (plugin->probe_time != 0
+      && now.tv_sec - plugin->probe_time < PROBE_CACHE_TIME)
+    return;
+  plugin->probe_time = now.tv_sec;
 
   /* check for commands we use */
   path = g_find_program_in_path ("gdmflexiserver");
   if (path != NULL)
-    BAR_SET_FLAG (allow_mask, ACTION_TYPE_SWITCH_USER);
+    BAR_SET_FLAG (plugin->allowed_types, ACTION_TYPE_SWITCH_USER);
+  else
+    BAR_UNSET_FLAG (plugin->allowed_types, ACTION_TYPE_SWITCH_USER);
   g_free (path);
 
   path = g_find_program_in_path ("xflock4");
   if (path != NULL)
-    BAR_SET_FLAG (allow_mask, ACTION_TYPE_LOCK_SCREEN);
+    BAR_SET_FLAG (plugin->allowed_types, ACTION_TYPE_LOCK_SCREEN);
+  else
+    BAR_UNSET_FLAG (plugin->allowed_types, ACTION_TYPE_LOCK_SCREEN);
   g_free (path);
 
-  /* session bus for querying the managers */
-  conn = dbus_g_bus_get (DBUS_BUS_SESSION, &error);
-  if (conn != NULL)
+  if (plugin->probe_proxy == NULL)
     {
-      /* xfce4-session */
-      proxy = actions_plugin_action_dbus_proxy_session (conn);
-      if (G_LIKELY (proxy != NULL))
+      /* session bus for querying the managers */
+      conn = dbus_g_bus_get (DBUS_BUS_SESSION, &error);
+      if (conn == NULL)
         {
-          /* when xfce4-session is connected, we can logout */
-          BAR_SET_FLAG (allow_mask, ACTION_TYPE_LOGOUT | ACTION_TYPE_LOGOUT_DIALOG);
-
-          if (actions_plugin_action_dbus_can (proxy, "CanShutdown"))
-            BAR_SET_FLAG (allow_mask, ACTION_TYPE_SHUTDOWN);
-
-          if (actions_plugin_action_dbus_can (proxy, "CanRestart"))
-            BAR_SET_FLAG (allow_mask, ACTION_TYPE_RESTART);
-        
-          if (actions_plugin_action_dbus_can (proxy, "CanSuspend"))
-            BAR_SET_FLAG (allow_mask, ACTION_TYPE_SUSPEND);
-          
-          if (actions_plugin_action_dbus_can (proxy, "CanHibernate"))
-            BAR_SET_FLAG (allow_mask, ACTION_TYPE_HIBERNATE);
-
-          g_object_unref (G_OBJECT (proxy));
+          g_critical ("Unable to open DBus session bus: %s", error->message);
+          g_error_free (error);
+
+          return;
         }
+
+      /* xfce4-session */
+      plugin->probe_proxy = actions_plugin_action_dbus_proxy_session (conn);
+      if (G_UNLIKELY (plugin->probe_proxy == NULL))
+        return;
     }
-  else
+
+  /* when xfce4-session is connected, we can logout */
+  BAR_SET_FLAG (plugin->allowed_types, ACTION_TYPE_LOGOUT | ACTION_TYPE_LOGOUT_DIALOG);
+
+  /* ask the session manager in parallel, the actions keep their
+   * previous state (disabled on the first run) until the replies
+   * arrive in actions_plugin_probe_reply */
+  for (i = 0; i < N_PROBES; i++)
     {
-      g_critical ("Unable to open DBus session bus: %s", error->message);
-      g_error_free (error);
-    }
+      /* the previous call is still pending */
+      if (plugin->probe_calls[i] != NULL)
+        continue;
 
-  return allow_mask;
+      plugin->probe_calls[i] =
+          dbus_g_proxy_begin_call (plugin->probe_proxy, action_probes[i].method,
+                                   actions_plugin_probe_reply, plugin, NULL,
+                                   G_TYPE_INVALID);
+    }
 }
 
 
@@ -1086,7 +1180,6 @@ actions_plugin_pack_idle (gpointer data)
   const GValue        *val;
   const gchar         *name;
   GtkOrientation       orientation;
-  ActionType           allowed_types;
   ActionType           type;
   BladeBarPluginMode  mode;
 
@@ -1100,7 +1193,7 @@ actions_plugin_pack_idle (gpointer data)
   if (plugin->items == NULL)
     plugin->items = actions_plugin_default_array ();
 
-  allowed_types = actions_plugin_actions_allowed ();
+  actions_plugin_probe (plugin);
 
   if (plugin->type == APPEARANCE_TYPE_BUTTONS)
     {
@@ -1133,7 +1226,7 @@ actions_plugin_pack_idle (gpointer data)
           if (widget != NULL)
             {
               gtk_box_pack_start (GTK_BOX (box), widget, FALSE, FALSE, 0);
-              gtk_widget_set_sensitive (widget, BAR_HAS_FLAG (allowed_types, type));
+              gtk_widget_set_sensitive (widget, BAR_HAS_FLAG (plugin->allowed_types, type));
               gtk_widget_show (widget);
             }
         }
@@ -1256,7 +1349,6 @@ actions_plugin_menu (GtkWidget     *button,
   GtkWidget    *mi;
   gint          w, h, size;
   ActionType    type;
-  ActionType    allowed_types;
 
   bar_return_if_fail (XFCE_IS_ACTIONS_PLUGIN (plugin));
   bar_return_if_fail (button != NULL);
@@ -1265,6 +1357,10 @@ actions_plugin_menu (GtkWidget     *button,
   if (!gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (button)))
     return;
 
+  /* refresh the capabilities if the cache expired, the replies
+   * update the sensitivity of the menu items */
+  actions_plugin_probe (plugin);
+
   if (plugin->menu == NULL)
     {
       plugin->menu = gtk_menu_new ();
@@ -1276,8 +1372,6 @@ actions_plugin_menu (GtkWidget     *button,
       if (gtk_icon_size_lookup (menu_icon_size, &w, &h))
         size = MIN (w, h);
 
-      allowed_types = actions_plugin_actions_allowed ();
-
       for (i = 0; i < plugin->items->len; i++)
         {
           val = g_ptr_array_index (plugin->items, i);
@@ -1289,7 +1383,7 @@ actions_plugin_menu (GtkWidget     *button,
           if (mi != NULL)
             {
               gtk_menu_shell_append (GTK_MENU_SHELL (plugin->menu), mi);
-              gtk_widget_set_sensitive (mi, BAR_HAS_FLAG (allowed_types, type));
+              gtk_widget_set_sensitive (mi, BAR_HAS_FLAG (plugin->allowed_types, type));
               gtk_widget_show (mi);
             }
         }
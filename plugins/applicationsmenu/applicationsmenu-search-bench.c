@@ -0,0 +1,334 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+#include <pojk/pojk.h>
+
+#include "applicationsmenu-search.h"
+
+/* number of desktop entries if not given on the command line */
+#define DEFAULT_N_ENTRIES (5000)
+
+/* number of times every query is typed */
+#define N_RUNS            (10)
+
+/* same as in applicationsmenu.c */
+#define MAX_RESULTS       (15)
+
+/* latency of a keystroke the search should stay below */
+#define TARGET_MS         (5.0)
+
+
+
+/*
+ * applicationsmenu-search-bench [N-ENTRIES]
+ *
+ * Writes a menu with N-ENTRIES synthetic desktop entries in a few
+ * category submenus, builds the search index from it and types the
+ * queries below one character at a time, like the user does in the
+ * menu. Every keystroke is timed separately. The queries cover prefix
+ * matches, multiple terms, matches inside words, which fall back to a
+ * scan of all entries, and queries without results. The results are
+ * printed as key=value lines.
+ */
+
+
+
+static const gchar *bench_words[] =
+{
+  "text", "image", "audio", "video", "office", "terminal", "system",
+  "network", "mail", "browser", "editor", "viewer", "player", "manager",
+  "monitor", "calendar", "archive", "printer", "scanner", "disk",
+  "photo", "music", "chat", "game", "font", "color", "clock", "notes"
+};
+
+static const gchar *bench_categories[] =
+{
+  "AudioVideo", "Development", "Education", "Game", "Graphics",
+  "Network", "Office", "Settings", "System", "Utility"
+};
+
+typedef struct
+{
+  const gchar *name;
+  const gchar *text;
+}
+BenchQuery;
+
+static const BenchQuery bench_queries[] =
+{
+  { "prefix",        "terminal" },
+  { "prefix-name",   "photo viewer" },
+  { "prefix-number", "music 42" },
+  { "category",      "graphics" },
+  { "substring",     "ditor" },
+  { "substring-few", "anner 7" },
+  { "no-match",      "xylophone" }
+};
+
+
+
+static gchar *
+bench_menu_new (const gchar *directory,
+                gint         n_entries)
+{
+  GString *menu;
+  gchar   *contents;
+  gchar   *filename;
+  gchar   *appdir;
+  guint    n_words = G_N_ELEMENTS (bench_words);
+  guint    n_categories = G_N_ELEMENTS (bench_categories);
+  guint    i;
+
+  appdir = g_build_filename (directory, "applications", NULL);
+  if (g_mkdir_with_parents (appdir, 0700) != 0)
+    g_error ("Failed to create \"%s\"", appdir);
+
+  for (i = 0; i < (guint) n_entries; i++)
+    {
+      contents = g_strdup_printf ("[Desktop Entry]\n"
+                                  "Type=Application\n"
+                                  "Name=%c%s %s %u\n"
+                                  "GenericName=%s %s\n"
+                                  "Comment=Open the %s with the %s tool\n"
+                                  "Categories=%s;\n"
+                                  "Exec=bench-%s-%s-%u %%F\n",
+                                  g_ascii_toupper (*bench_words[i % n_words]),
+                                  bench_words[i % n_words] + 1,
+                                  bench_words[(i / n_words) % n_words], i,
+                                  bench_words[(i * 7) % n_words],
+                                  bench_words[(i * 3) % n_words],
+                                  bench_words[(i * 5) % n_words],
+                                  bench_words[(i * 11) % n_words],
+                                  bench_categories[i % n_categories],
+                                  bench_words[i % n_words],
+                                  bench_words[(i / n_words) % n_words], i);
+
+      filename = g_strdup_printf ("%s/bench-%u.desktop", appdir, i);
+      if (!g_file_set_contents (filename, contents, -1, NULL))
+        g_error ("Failed to write \"%s\"", filename);
+      g_free (filename);
+      g_free (contents);
+    }
+
+  menu = g_string_new ("<!DOCTYPE Menu PUBLIC \"-//freedesktop//DTD Menu 1.0//EN\"\n"
+                       "  \"http://www.freedesktop.org/standards/menu-spec/1.0/menu.dtd\">\n"
+                       "<Menu>\n"
+                       "  <Name>Bench</Name>\n");
+  g_string_append_printf (menu, "  <AppDir>%s</AppDir>\n", appdir);
+  for (i = 0; i < n_categories; i++)
+    g_string_append_printf (menu, "  <Menu>\n"
+                            "    <Name>%s</Name>\n"
+                            "    <Include><Category>%s</Category></Include>\n"
+                            "  </Menu>\n",
+                            bench_categories[i], bench_categories[i]);
+  g_string_append (menu, "</Menu>\n");
+
+  filename = g_build_filename (directory, "bench.menu", NULL);
+  if (!g_file_set_contents (filename, menu->str, menu->len, NULL))
+    g_error ("Failed to write \"%s\"", filename);
+
+  g_string_free (menu, TRUE);
+  g_free (appdir);
+
+  return filename;
+}
+
+
+
+static void
+bench_remove (const gchar *directory,
+              gint         n_entries)
+{
+  gchar *filename;
+  gint   i;
+
+  for (i = 0; i < n_entries; i++)
+    {
+      filename = g_strdup_printf ("%s/applications/bench-%d.desktop", directory, i);
+      g_unlink (filename);
+      g_free (filename);
+    }
+
+  filename = g_build_filename (directory, "applications", NULL);
+  g_rmdir (filename);
+  g_free (filename);
+
+  filename = g_build_filename (directory, "bench.menu", NULL);
+  g_unlink (filename);
+  g_free (filename);
+
+  g_rmdir (directory);
+}
+
+
+
+static gint
+bench_compare_doubles (gconstpointer a,
+                       gconstpointer b)
+{
+  gdouble da = *(const gdouble *) a;
+  gdouble db = *(const gdouble *) b;
+
+  return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+
+
+static void
+bench_query (ApplicationsMenuSearch *search,
+             const BenchQuery       *query,
+             GArray                 *all_times)
+{
+  GArray  *times;
+  GTimer  *timer;
+  GSList  *result;
+  gchar   *typed;
+  gdouble  elapsed, total = 0.0;
+  guint    n_results = 0;
+  guint    n_over = 0;
+  gsize    len, n;
+  guint    run;
+
+  times = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  timer = g_timer_new ();
+  len = strlen (query->text);
+
+  for (run = 0; run < N_RUNS; run++)
+    {
+      for (n = 1; n <= len; n++)
+        {
+          typed = g_strndup (query->text, n);
+
+          g_timer_start (timer);
+          result = applications_menu_search_query (search, typed, MAX_RESULTS);
+          elapsed = g_timer_elapsed (timer, NULL) * 1000.0;
+
+          n_results = g_slist_length (result);
+          g_slist_free (result);
+          g_free (typed);
+
+          g_array_append_val (times, elapsed);
+          g_array_append_val (all_times, elapsed);
+          total += elapsed;
+          if (elapsed > TARGET_MS)
+            n_over++;
+        }
+    }
+
+  g_array_sort (times, bench_compare_doubles);
+
+  g_print ("query.%s.keystrokes=%u\n", query->name, times->len);
+  g_print ("query.%s.results=%u\n", query->name, n_results);
+  g_print ("query.%s.avg-ms=%.3f\n", query->name, total / times->len);
+  g_print ("query.%s.p95-ms=%.3f\n", query->name,
+           g_array_index (times, gdouble, times->len * 95 / 100));
+  g_print ("query.%s.max-ms=%.3f\n", query->name,
+           g_array_index (times, gdouble, times->len - 1));
+  g_print ("query.%s.over-target=%u\n", query->name, n_over);
+
+  g_timer_destroy (timer);
+  g_array_free (times, TRUE);
+}
+
+
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  ApplicationsMenuSearch *search;
+  PojkMenu               *menu;
+  GError                 *error = NULL;
+  GTimer                 *timer;
+  GArray                 *all_times;
+  gchar                  *directory;
+  gchar                  *filename;
+  gint                    n_entries = DEFAULT_N_ENTRIES;
+  guint                   i, n_over = 0;
+
+  if (argc > 1)
+    n_entries = MAX (atoi (argv[1]), 1);
+
+#if !GLIB_CHECK_VERSION (2, 36, 0)
+  g_type_init ();
+#endif
+
+  directory = g_strdup_printf ("%s/applicationsmenu-search-bench-%d",
+                               g_get_tmp_dir (), (gint) getpid ());
+  filename = bench_menu_new (directory, n_entries);
+
+  timer = g_timer_new ();
+
+  menu = pojk_menu_new_for_path (filename);
+  if (!pojk_menu_load (menu, NULL, &error))
+    g_error ("Failed to load \"%s\": %s", filename, error->message);
+  g_print ("menu.entries=%d\n", n_entries);
+  g_print ("menu.load-ms=%.1f\n", g_timer_elapsed (timer, NULL) * 1000.0);
+
+  /* the plugin builds the index in idle chunks, all at once is
+   * the total amount of work */
+  g_timer_start (timer);
+  search = applications_menu_search_new (menu);
+  applications_menu_search_build (search, 0);
+  g_print ("index.build-ms=%.1f\n", g_timer_elapsed (timer, NULL) * 1000.0);
+
+  g_print ("query.target-ms=%.1f\n", TARGET_MS);
+
+  all_times = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  for (i = 0; i < G_N_ELEMENTS (bench_queries); i++)
+    bench_query (search, &bench_queries[i], all_times);
+
+  g_array_sort (all_times, bench_compare_doubles);
+  for (i = 0; i < all_times->len; i++)
+    if (g_array_index (all_times, gdouble, i) > TARGET_MS)
+      n_over++;
+
+  g_print ("query.all.keystrokes=%u\n", all_times->len);
+  g_print ("query.all.p95-ms=%.3f\n",
+           g_array_index (all_times, gdouble, all_times->len * 95 / 100));
+  g_print ("query.all.max-ms=%.3f\n",
+           g_array_index (all_times, gdouble, all_times->len - 1));
+  g_print ("query.all.over-target=%u\n", n_over);
+
+  g_array_free (all_times, TRUE);
+  g_timer_destroy (timer);
+  applications_menu_search_free (search);
+  g_object_unref (G_OBJECT (menu));
+
+  bench_remove (directory, n_entries);
+  g_free (filename);
+  g_free (directory);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,527 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <blxo/blxo.h>
+#include <pojk/pojk.h>
+#include <common/bar-private.h>
+#include <common/bar-debug.h>
+
+#include "applicationsmenu-search.h"
+
+
+
+/* rank of entries that do not match the query */
+#define RANK_NO_MATCH  (G_MAXUINT8)
+
+/* rank of entries where the query only matched inside a word */
+#define RANK_SUBSTRING (N_FIELDS + 1)
+
+
+
+typedef enum
+{
+  FIELD_NAME,
+  FIELD_GENERIC_NAME,
+  FIELD_CATEGORIES,
+  FIELD_COMMENT,
+  FIELD_COMMAND,
+  N_FIELDS
+}
+SearchField;
+
+typedef struct
+{
+  PojkMenuItem *item;
+
+  /* key to sort matches with the same rank on name */
+  gchar        *collate_key;
+
+  /* normalized and casefolded fields, separated by newlines */
+  gchar        *haystack;
+
+  /* copy of the haystack with all non-alphanumeric characters
+   * replaced by nul bytes, the words in the index point in here */
+  gchar        *words;
+}
+SearchEntry;
+
+typedef struct
+{
+  const gchar *word;
+  guint        entry;
+  guint        rank;
+}
+SearchWord;
+
+struct _ApplicationsMenuSearch
+{
+  /* menu items waiting to be indexed */
+  GPtrArray  *pending;
+  guint       n_indexed;
+  GHashTable *desktop_ids;
+
+  /* indexed items and the index of word prefixes, sorted
+   * once all pending items are indexed */
+  GArray     *entries;
+  GArray     *words;
+
+  guint       is_ready : 1;
+
+  /* scratch data reused by all queries */
+  guint8     *ranks;
+  GArray     *matches;
+  GTimer     *timer;
+};
+
+
+
+static void
+applications_menu_search_collect (ApplicationsMenuSearch *search,
+                                  PojkMenu               *menu)
+{
+  GList        *li, *items;
+  GList        *menus;
+  PojkMenuItem *item;
+  const gchar  *desktop_id;
+
+  bar_return_if_fail (POJK_IS_MENU (menu));
+
+  items = pojk_menu_get_items (menu);
+  for (li = items; li != NULL; li = li->next)
+    {
+      item = POJK_MENU_ITEM (li->data);
+      bar_assert (POJK_IS_MENU_ITEM (item));
+
+      /* skip invisible items */
+      if (!pojk_menu_element_get_visible (POJK_MENU_ELEMENT (item)))
+        continue;
+
+      /* skip items that appear in multiple menus */
+      desktop_id = pojk_menu_item_get_desktop_id (item);
+      if (desktop_id == NULL
+          || g_hash_table_lookup (search->desktop_ids, desktop_id) != NULL)
+        continue;
+
+      g_hash_table_insert (search->desktop_ids, (gpointer) desktop_id, item);
+      g_ptr_array_add (search->pending, g_object_ref (G_OBJECT (item)));
+    }
+  g_list_free (items);
+
+  menus = pojk_menu_get_menus (menu);
+  for (li = menus; li != NULL; li = li->next)
+    if (pojk_menu_element_get_visible (POJK_MENU_ELEMENT (li->data)))
+      applications_menu_search_collect (search, li->data);
+  g_list_free (menus);
+}
+
+
+
+static void
+applications_menu_search_append (GString     *haystack,
+                                 const gchar *text)
+{
+  gchar *normalized;
+  gchar *casefolded;
+
+  if (blxo_str_is_empty (text))
+    return;
+
+  normalized = g_utf8_normalize (text, -1, G_NORMALIZE_ALL);
+  if (G_LIKELY (normalized != NULL))
+    {
+      casefolded = g_utf8_casefold (normalized, -1);
+      g_string_append (haystack, casefolded);
+      g_free (casefolded);
+      g_free (normalized);
+    }
+}
+
+
+
+static void
+applications_menu_search_index_item (ApplicationsMenuSearch *search,
+                                     PojkMenuItem           *item)
+{
+  GString     *haystack;
+  gsize        field_end[N_FIELDS];
+  GList       *li;
+  SearchEntry  entry;
+  SearchWord   word;
+  const gchar *name;
+  gchar       *p, *next, *end;
+  gsize        offset, len;
+  guint        field;
+  gboolean     first_name_word = TRUE;
+
+  haystack = g_string_sized_new (256);
+
+  name = pojk_menu_item_get_name (item);
+  applications_menu_search_append (haystack, name);
+  field_end[FIELD_NAME] = haystack->len;
+  g_string_append_c (haystack, '\n');
+
+  applications_menu_search_append (haystack, pojk_menu_item_get_generic_name (item));
+  field_end[FIELD_GENERIC_NAME] = haystack->len;
+  g_string_append_c (haystack, '\n');
+
+  for (li = pojk_menu_item_get_categories (item); li != NULL; li = li->next)
+    {
+      applications_menu_search_append (haystack, li->data);
+      g_string_append_c (haystack, ' ');
+    }
+  field_end[FIELD_CATEGORIES] = haystack->len;
+  g_string_append_c (haystack, '\n');
+
+  applications_menu_search_append (haystack, pojk_menu_item_get_comment (item));
+  field_end[FIELD_COMMENT] = haystack->len;
+  g_string_append_c (haystack, '\n');
+
+  applications_menu_search_append (haystack, pojk_menu_item_get_command (item));
+  field_end[FIELD_COMMAND] = haystack->len;
+
+  /* the item reference is taken over from the pending array */
+  entry.item = item;
+  entry.collate_key = g_utf8_collate_key (name != NULL ? name : "", -1);
+  len = haystack->len;
+  entry.words = g_strndup (haystack->str, len);
+  entry.haystack = g_string_free (haystack, FALSE);
+
+  /* split the words, this only replaces characters so
+   * the offsets of the fields in the words stay the same */
+  end = entry.words + len;
+  for (p = entry.words; p < end; p = next)
+    {
+      next = g_utf8_next_char (p);
+      if (!g_unichar_isalnum (g_utf8_get_char (p)))
+        memset (p, '\0', next - p);
+    }
+
+  /* add the start of each word to the prefix index */
+  word.entry = search->entries->len;
+  for (offset = 0, field = FIELD_NAME; offset < len; offset++)
+    {
+      while (offset >= field_end[field] && field < FIELD_COMMAND)
+        field++;
+
+      if (entry.words[offset] == '\0'
+          || (offset > 0 && entry.words[offset - 1] != '\0'))
+        continue;
+
+      word.word = entry.words + offset;
+
+      /* the first word of the name ranks best, after that
+       * the rank of a word is based on the field it is in */
+      if (field == FIELD_NAME)
+        {
+          word.rank = first_name_word ? 0 : 1;
+          first_name_word = FALSE;
+        }
+      else
+        {
+          word.rank = field + 1;
+        }
+
+      g_array_append_val (search->words, word);
+    }
+
+  g_array_append_val (search->entries, entry);
+}
+
+
+
+static gint
+applications_menu_search_compare_words (gconstpointer a,
+                                        gconstpointer b)
+{
+  const SearchWord *word_a = a;
+  const SearchWord *word_b = b;
+  gint              result;
+
+  result = strcmp (word_a->word, word_b->word);
+  if (result == 0)
+    result = (gint) word_a->rank - (gint) word_b->rank;
+
+  return result;
+}
+
+
+
+static gint
+applications_menu_search_compare_matches (gconstpointer a,
+                                          gconstpointer b,
+                                          gpointer      user_data)
+{
+  ApplicationsMenuSearch *search = user_data;
+  guint                   entry_a = *(const guint *) a;
+  guint                   entry_b = *(const guint *) b;
+
+  if (search->ranks[entry_a] != search->ranks[entry_b])
+    return (gint) search->ranks[entry_a] - (gint) search->ranks[entry_b];
+
+  return strcmp (g_array_index (search->entries, SearchEntry, entry_a).collate_key,
+                 g_array_index (search->entries, SearchEntry, entry_b).collate_key);
+}
+
+
+
+ApplicationsMenuSearch *
+applications_menu_search_new (PojkMenu *menu)
+{
+  ApplicationsMenuSearch *search;
+
+  bar_return_val_if_fail (POJK_IS_MENU (menu), NULL);
+
+  search = g_slice_new0 (ApplicationsMenuSearch);
+  search->pending = g_ptr_array_new ();
+  search->desktop_ids = g_hash_table_new (g_str_hash, g_str_equal);
+  search->entries = g_array_new (FALSE, FALSE, sizeof (SearchEntry));
+  search->words = g_array_new (FALSE, FALSE, sizeof (SearchWord));
+  search->matches = g_array_new (FALSE, FALSE, sizeof (guint));
+  search->timer = g_timer_new ();
+
+  /* walking the menu is cheap, the expensive work happens
+   * in applications_menu_search_build() */
+  applications_menu_search_collect (search, menu);
+
+  return search;
+}
+
+
+
+void
+applications_menu_search_free (ApplicationsMenuSearch *search)
+{
+  SearchEntry *entry;
+  guint        i;
+
+  if (search->pending != NULL)
+    {
+      for (i = search->n_indexed; i < search->pending->len; i++)
+        g_object_unref (G_OBJECT (g_ptr_array_index (search->pending, i)));
+      g_ptr_array_free (search->pending, TRUE);
+    }
+
+  if (search->desktop_ids != NULL)
+    g_hash_table_destroy (search->desktop_ids);
+
+  for (i = 0; i < search->entries->len; i++)
+    {
+      entry = &g_array_index (search->entries, SearchEntry, i);
+      g_object_unref (G_OBJECT (entry->item));
+      g_free (entry->collate_key);
+      g_free (entry->haystack);
+      g_free (entry->words);
+    }
+
+  g_array_free (search->entries, TRUE);
+  g_array_free (search->words, TRUE);
+  g_array_free (search->matches, TRUE);
+  g_timer_destroy (search->timer);
+  g_free (search->ranks);
+
+  g_slice_free (ApplicationsMenuSearch, search);
+}
+
+
+
+/* index up to max_items pending items (all if 0), returns
+ * TRUE when there are still items left to index */
+gboolean
+applications_menu_search_build (ApplicationsMenuSearch *search,
+                                guint                   max_items)
+{
+  guint n;
+
+  bar_return_val_if_fail (search != NULL, FALSE);
+
+  if (search->is_ready)
+    return FALSE;
+
+  for (n = 0; search->n_indexed < search->pending->len; n++)
+    {
+      if (max_items > 0 && n >= max_items)
+        return TRUE;
+
+      applications_menu_search_index_item (search,
+          g_ptr_array_index (search->pending, search->n_indexed++));
+    }
+
+  /* all items are indexed, sort the words for prefix lookups */
+  g_array_sort (search->words, applications_menu_search_compare_words);
+
+  search->ranks = g_new (guint8, MAX (search->entries->len, 1));
+  memset (search->ranks, RANK_NO_MATCH, search->entries->len);
+
+  /* the item references are owned by the entries now */
+  g_ptr_array_free (search->pending, TRUE);
+  search->pending = NULL;
+
+  g_hash_table_destroy (search->desktop_ids);
+  search->desktop_ids = NULL;
+
+  search->is_ready = TRUE;
+
+  bar_debug (BAR_DEBUG_APPLICATIONSMENU,
+             "search index contains %u items and %u words",
+             search->entries->len, search->words->len);
+
+  return FALSE;
+}
+
+
+
+/* returns the best matching menu items, the list should be
+ * freed with g_slist_free(), the items are not referenced */
+GSList *
+applications_menu_search_query (ApplicationsMenuSearch *search,
+                                const gchar            *text,
+                                guint                   max_results)
+{
+  gchar        *normalized, *casefolded;
+  gchar       **terms = NULL;
+  const gchar  *term = NULL;
+  SearchWord   *word;
+  SearchEntry  *entry;
+  guint         lower, upper, mid;
+  guint         i, j, n, t;
+  gsize         len;
+  guint        *matches;
+  gboolean      keep;
+  GSList       *result = NULL;
+
+  bar_return_val_if_fail (search != NULL, NULL);
+  bar_return_val_if_fail (search->is_ready, NULL);
+
+  if (blxo_str_is_empty (text))
+    return NULL;
+
+  g_timer_start (search->timer);
+  g_array_set_size (search->matches, 0);
+
+  normalized = g_utf8_normalize (text, -1, G_NORMALIZE_ALL);
+  if (G_UNLIKELY (normalized == NULL))
+    goto done;
+  casefolded = g_utf8_casefold (normalized, -1);
+  terms = g_strsplit_set (casefolded, " \t", -1);
+  g_free (casefolded);
+  g_free (normalized);
+
+  /* the first term is looked up in the prefix index */
+  for (t = 0; terms[t] != NULL; t++)
+    if (*terms[t] != '\0')
+      break;
+
+  term = terms[t];
+  if (term == NULL)
+    goto done;
+
+  /* find the first word that is not smaller then the term */
+  lower = 0;
+  upper = search->words->len;
+  while (lower < upper)
+    {
+      mid = lower + (upper - lower) / 2;
+      word = &g_array_index (search->words, SearchWord, mid);
+      if (strcmp (word->word, term) < 0)
+        lower = mid + 1;
+      else
+        upper = mid;
+    }
+
+  /* collect all entries with a word starting with the term */
+  len = strlen (term);
+  for (i = lower; i < search->words->len; i++)
+    {
+      word = &g_array_index (search->words, SearchWord, i);
+      if (strncmp (word->word, term, len) != 0)
+        break;
+
+      if (search->ranks[word->entry] == RANK_NO_MATCH)
+        g_array_append_val (search->matches, word->entry);
+      search->ranks[word->entry] = MIN (search->ranks[word->entry], word->rank);
+    }
+
+  /* fill up with items that contain the term inside a word */
+  if (search->matches->len < max_results)
+    {
+      for (i = 0; i < search->entries->len; i++)
+        {
+          if (search->ranks[i] != RANK_NO_MATCH)
+            continue;
+
+          entry = &g_array_index (search->entries, SearchEntry, i);
+          if (strstr (entry->haystack, term) != NULL)
+            {
+              search->ranks[i] = RANK_SUBSTRING;
+              g_array_append_val (search->matches, i);
+            }
+        }
+    }
+
+  /* all other terms should appear somewhere in the item */
+  matches = (guint *) search->matches->data;
+  for (i = 0, n = 0; i < search->matches->len; i++)
+    {
+      entry = &g_array_index (search->entries, SearchEntry, matches[i]);
+
+      for (j = t + 1, keep = TRUE; keep && terms[j] != NULL; j++)
+        if (*terms[j] != '\0' && strstr (entry->haystack, terms[j]) == NULL)
+          keep = FALSE;
+
+      if (keep)
+        matches[n++] = matches[i];
+      else
+        search->ranks[matches[i]] = RANK_NO_MATCH;
+    }
+  g_array_set_size (search->matches, n);
+
+  g_array_sort_with_data (search->matches,
+      applications_menu_search_compare_matches, search);
+
+  /* take the best results and reset the ranks for the next query */
+  matches = (guint *) search->matches->data;
+  for (i = 0; i < search->matches->len; i++)
+    {
+      if (i < max_results)
+        {
+          entry = &g_array_index (search->entries, SearchEntry, matches[i]);
+          result = g_slist_prepend (result, entry->item);
+        }
+
+      search->ranks[matches[i]] = RANK_NO_MATCH;
+    }
+
+  done:
+
+  g_strfreev (terms);
+
+  bar_debug_filtered (BAR_DEBUG_APPLICATIONSMENU,
+                      "query \"%s\" matched %u of %u items in %.3f ms",
+                      text, search->matches->len, search->entries->len,
+                      g_timer_elapsed (search->timer, NULL) * 1000.0);
+
+  return g_slist_reverse (result);
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __APPLICATIONS_MENU_SEARCH_H__
+#define __APPLICATIONS_MENU_SEARCH_H__
+
+#include <glib.h>
+#include <pojk/pojk.h>
+
+G_BEGIN_DECLS
+
+typedef struct _ApplicationsMenuSearch ApplicationsMenuSearch;
+
+ApplicationsMenuSearch *applications_menu_search_new      (PojkMenu               *menu);
+
+void                    applications_menu_search_free     (ApplicationsMenuSearch *search);
+
+gboolean                applications_menu_search_build    (ApplicationsMenuSearch *search,
+                                                           guint                   max_items);
+
+
+GSList                 *applications_menu_search_query    (ApplicationsMenuSearch *search,
+                                                           const gchar            *text,
+                                                           guint                   max_results);
+
+G_END_DECLS
+
+#endif /* !__APPLICATIONS_MENU_SEARCH_H__ */
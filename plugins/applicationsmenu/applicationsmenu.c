@@ -20,6 +20,11 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <gdk/gdkkeysyms.h>
 #include <blxo/blxo.h>
 #include <pojk/pojk.h>
 #include <pojk-gtk/pojk-gtk.h>
@@ -32,6 +37,7 @@
 #include <common/bar-debug.h>
 
 #include "applicationsmenu.h"
+#include "applicationsmenu-search.h"
 #include "applicationsmenu-dialog_ui.h"
 
 
@@ -40,6 +46,12 @@
 #define DEFAULT_ICON_NAME "blade-bar-menu"
 #define DEFAULT_ICON_SIZE (16)
 
+/* number of items shown in the search menu */
+#define SEARCH_MAX_RESULTS (15)
+
+/* number of items indexed per idle iteration */
+#define SEARCH_BUILD_ITEMS (50)
+
 
 
 struct _ApplicationsMenuPluginClass
@@ -56,8 +68,16 @@ struct _ApplicationsMenuPlugin
   GtkWidget       *icon;
   GtkWidget       *label;
   GtkWidget       *menu;
+  PojkMenu        *pojk_menu;
+
+  /* type-ahead search in the menu */
+  GtkWidget              *search_menu;
+  GString                *search_text;
+  ApplicationsMenuSearch *search;
+  guint                   search_build_id;
 
-  guint            is_constructed : 1;
+  /* the pojk menu is only loaded when the menu pops up */
+  guint            menu_needs_update : 1;
 
   guint            show_button_title : 1;
   gchar           *button_title;
@@ -111,6 +131,10 @@ static gboolean  applications_menu_plugin_menu                 (GtkWidget
                                                                 ApplicationsMenuPlugin *plugin);
 static void      applications_menu_plugin_menu_deactivate      (GtkWidget              *menu,
                                                                 GtkWidget              *button);
+static gboolean  applications_menu_plugin_menu_key_press       (GtkWidget              *menu,
+                                                                GdkEventKey            *event,
+                                                                ApplicationsMenuPlugin *plugin);
+static void      applications_menu_plugin_search_reset         (ApplicationsMenuPlugin *plugin);
 static void      applications_menu_plugin_set_pojk_menu      (ApplicationsMenuPlugin *plugin);
 static void      applications_menu_button_theme_changed        (ApplicationsMenuPlugin *plugin);
 
@@ -230,6 +254,16 @@ applications_menu_plugin_init (ApplicationsMenuPlugin *plugin)
   plugin->menu = pojk_gtk_menu_new (NULL);
   g_signal_connect (G_OBJECT (plugin->menu), "selection-done",
       G_CALLBACK (applications_menu_plugin_menu_deactivate), plugin->button);
+  g_signal_connect (G_OBJECT (plugin->menu), "key-press-event",
+      G_CALLBACK (applications_menu_plugin_menu_key_press), plugin);
+
+  /* menu with the search results, replaces the menu when typing */
+  plugin->search_text = g_string_new (NULL);
+  plugin->search_menu = gtk_menu_new ();
+  g_signal_connect (G_OBJECT (plugin->search_menu), "selection-done",
+      G_CALLBACK (applications_menu_plugin_menu_deactivate), plugin->button);
+  g_signal_connect (G_OBJECT (plugin->search_menu), "key-press-event",
+      G_CALLBACK (applications_menu_plugin_menu_key_press), plugin);
 
   plugin->style_set_id = g_signal_connect_swapped (G_OBJECT (plugin->button), "style-set",
                                                    G_CALLBACK (applications_menu_button_theme_changed), plugin);
@@ -355,17 +389,13 @@ applications_menu_plugin_set_property (GObject      *object,
 
     case PROP_CUSTOM_MENU:
       plugin->custom_menu = g_value_get_boolean (value);
-
-      if (plugin->is_constructed)
-        applications_menu_plugin_set_pojk_menu (plugin);
+      plugin->menu_needs_update = TRUE;
       break;
 
     case PROP_CUSTOM_MENU_FILE:
       g_free (plugin->custom_menu_file);
       plugin->custom_menu_file = g_value_dup_string (value);
-
-      if (plugin->is_constructed)
-        applications_menu_plugin_set_pojk_menu (plugin);
+      plugin->menu_needs_update = TRUE;
       break;
 
     default:
@@ -406,14 +436,14 @@ applications_menu_plugin_construct (BladeBarPlugin *bar_plugin)
                          blade_bar_plugin_get_property_base (bar_plugin),
                          properties, FALSE);
 
-  /* make sure the menu is set */
-  applications_menu_plugin_set_pojk_menu (plugin);
+  /* the menu is loaded on the first popup, so the bar startup
+   * does not have to wait for all the desktop files to be parsed */
+  plugin->menu_needs_update = TRUE;
 
   gtk_widget_show (plugin->button);
 
   applications_menu_plugin_size_changed (bar_plugin,
       blade_bar_plugin_get_size (bar_plugin));
-  plugin->is_constructed = TRUE;
 }
 
 
@@ -426,6 +456,15 @@ applications_menu_plugin_free_data (BladeBarPlugin *bar_plugin)
   if (plugin->menu != NULL)
     gtk_widget_destroy (plugin->menu);
 
+  if (plugin->search_menu != NULL)
+    gtk_widget_destroy (plugin->search_menu);
+
+  applications_menu_plugin_search_reset (plugin);
+  g_string_free (plugin->search_text, TRUE);
+
+  if (plugin->pojk_menu != NULL)
+    g_object_unref (G_OBJECT (plugin->pojk_menu));
+
   if (plugin->style_set_id != 0)
     {
       g_signal_handler_disconnect (plugin->button, plugin->style_set_id);
@@ -767,6 +806,7 @@ applications_menu_plugin_set_pojk_menu (ApplicationsMenuPlugin *plugin)
 
   /* set the menu */
   pojk_gtk_menu_set_menu (POJK_GTK_MENU (plugin->menu), menu);
+  plugin->menu_needs_update = FALSE;
 
   /* debugging information */
   if (0)
@@ -780,7 +820,308 @@ applications_menu_plugin_set_pojk_menu (ApplicationsMenuPlugin *plugin)
   g_free (filename);
     }
 
-  g_object_unref (G_OBJECT (menu));
+  /* keep the menu around for the search index */
+  if (plugin->pojk_menu != NULL)
+    g_object_unref (G_OBJECT (plugin->pojk_menu));
+  plugin->pojk_menu = menu;
+
+  /* the index of the old menu is useless now */
+  applications_menu_plugin_search_reset (plugin);
+}
+
+
+
+static gboolean
+applications_menu_plugin_search_build_idle (gpointer user_data)
+{
+  ApplicationsMenuPlugin *plugin = XFCE_APPLICATIONS_MENU_PLUGIN (user_data);
+  gboolean                proceed = FALSE;
+
+  GDK_THREADS_ENTER ();
+
+  if (plugin->search == NULL && plugin->pojk_menu != NULL)
+    plugin->search = applications_menu_search_new (plugin->pojk_menu);
+
+  /* index the menu in small steps so the menu stays responsive */
+  if (plugin->search != NULL)
+    proceed = applications_menu_search_build (plugin->search, SEARCH_BUILD_ITEMS);
+
+  GDK_THREADS_LEAVE ();
+
+  return proceed;
+}
+
+
+
+static void
+applications_menu_plugin_search_build_idle_destroyed (gpointer user_data)
+{
+  XFCE_APPLICATIONS_MENU_PLUGIN (user_data)->search_build_id = 0;
+}
+
+
+
+static void
+applications_menu_plugin_search_reset (ApplicationsMenuPlugin *plugin)
+{
+  bar_return_if_fail (XFCE_IS_APPLICATIONS_MENU_PLUGIN (plugin));
+
+  if (plugin->search_build_id != 0)
+    g_source_remove (plugin->search_build_id);
+
+  if (plugin->search != NULL)
+    {
+      applications_menu_search_free (plugin->search);
+      plugin->search = NULL;
+    }
+}
+
+
+
+static GtkWidget *
+applications_menu_plugin_find_menu_item (GtkWidget    *menu,
+                                         PojkMenuItem *item)
+{
+  GList     *children, *li;
+  GtkWidget *submenu;
+  GtkWidget *mi = NULL;
+
+  children = gtk_container_get_children (GTK_CONTAINER (menu));
+  for (li = children; li != NULL && mi == NULL; li = li->next)
+    {
+      if (!GTK_IS_MENU_ITEM (li->data))
+        continue;
+
+      /* pojk connects the activate signal of its menu items
+       * with the item they launch as user data */
+      if (g_signal_handler_find (G_OBJECT (li->data), G_SIGNAL_MATCH_DATA,
+                                 0, 0, NULL, NULL, item) != 0)
+        {
+          mi = li->data;
+        }
+      else
+        {
+          submenu = gtk_menu_item_get_submenu (GTK_MENU_ITEM (li->data));
+          if (submenu != NULL)
+            mi = applications_menu_plugin_find_menu_item (submenu, item);
+        }
+    }
+  g_list_free (children);
+
+  return mi;
+}
+
+
+
+static void
+applications_menu_plugin_search_activate (GtkWidget    *search_mi,
+                                          PojkMenuItem *item)
+{
+  ApplicationsMenuPlugin *plugin;
+  GtkWidget              *mi;
+
+  bar_return_if_fail (POJK_IS_MENU_ITEM (item));
+
+  plugin = g_object_get_data (G_OBJECT (search_mi), "applications-menu-plugin");
+  bar_return_if_fail (XFCE_IS_APPLICATIONS_MENU_PLUGIN (plugin));
+
+  /* launch the item like the menu does, so the field codes, working
+   * directory and startup notification are handled in one place */
+  mi = applications_menu_plugin_find_menu_item (plugin->menu, item);
+  if (G_LIKELY (mi != NULL))
+    gtk_menu_item_activate (GTK_MENU_ITEM (mi));
+  else
+    g_warning ("Menu item \"%s\" is not in the applications menu",
+               pojk_menu_item_get_name (item));
+}
+
+
+
+static void
+applications_menu_plugin_menu_connect_submenus (ApplicationsMenuPlugin *plugin,
+                                                GtkWidget              *menu)
+{
+  GList     *children, *li;
+  GtkWidget *submenu;
+
+  children = gtk_container_get_children (GTK_CONTAINER (menu));
+  for (li = children; li != NULL; li = li->next)
+    {
+      if (!GTK_IS_MENU_ITEM (li->data))
+        continue;
+
+      submenu = gtk_menu_item_get_submenu (GTK_MENU_ITEM (li->data));
+      if (submenu == NULL)
+        continue;
+
+      /* submenus are separate windows, so they need the type-ahead
+       * handler too; pojk rebuilds them when the menu is reloaded */
+      if (g_signal_handler_find (G_OBJECT (submenu),
+                                 G_SIGNAL_MATCH_FUNC | G_SIGNAL_MATCH_DATA, 0, 0, NULL,
+                                 G_CALLBACK (applications_menu_plugin_menu_key_press),
+                                 plugin) == 0)
+        g_signal_connect (G_OBJECT (submenu), "key-press-event",
+            G_CALLBACK (applications_menu_plugin_menu_key_press), plugin);
+
+      applications_menu_plugin_menu_connect_submenus (plugin, submenu);
+    }
+  g_list_free (children);
+}
+
+
+
+static void
+applications_menu_plugin_search_update (ApplicationsMenuPlugin *plugin)
+{
+  GtkMenuPositionFunc  position_func = NULL;
+  GList               *children;
+  GSList              *items, *li;
+  GtkWidget           *mi, *image;
+  GtkWidget           *first = NULL;
+  const gchar         *icon_name;
+  gboolean             show_icons, show_tooltips;
+
+  bar_return_if_fail (XFCE_IS_APPLICATIONS_MENU_PLUGIN (plugin));
+
+  /* the menus are positioned at the button if it is active */
+  if (gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (plugin->button)))
+    position_func = blade_bar_plugin_position_menu;
+
+  if (plugin->search_text->len == 0)
+    {
+      /* nothing to search for, switch back to the menu */
+      gtk_menu_popdown (GTK_MENU (plugin->search_menu));
+      gtk_menu_popup (GTK_MENU (plugin->menu), NULL, NULL,
+                      position_func, plugin, 1,
+                      gtk_get_current_event_time ());
+      return;
+    }
+
+  /* finish the index if the user was faster then the idle build */
+  if (plugin->search == NULL && plugin->pojk_menu != NULL)
+    plugin->search = applications_menu_search_new (plugin->pojk_menu);
+  if (plugin->search != NULL)
+    applications_menu_search_build (plugin->search, 0);
+
+  /* remove the previous results */
+  children = gtk_container_get_children (GTK_CONTAINER (plugin->search_menu));
+  g_list_foreach (children, (GFunc) gtk_widget_destroy, NULL);
+  g_list_free (children);
+
+  mi = gtk_menu_item_new_with_label (plugin->search_text->str);
+  gtk_widget_set_sensitive (mi, FALSE);
+  gtk_menu_shell_append (GTK_MENU_SHELL (plugin->search_menu), mi);
+  gtk_widget_show (mi);
+
+  mi = gtk_separator_menu_item_new ();
+  gtk_menu_shell_append (GTK_MENU_SHELL (plugin->search_menu), mi);
+  gtk_widget_show (mi);
+
+  items = NULL;
+  if (plugin->search != NULL)
+    items = applications_menu_search_query (plugin->search, plugin->search_text->str,
+                                            SEARCH_MAX_RESULTS);
+
+  show_icons = pojk_gtk_menu_get_show_menu_icons (POJK_GTK_MENU (plugin->menu));
+  show_tooltips = pojk_gtk_menu_get_show_tooltips (POJK_GTK_MENU (plugin->menu));
+
+  for (li = items; li != NULL; li = li->next)
+    {
+      mi = gtk_image_menu_item_new_with_label (pojk_menu_item_get_name (li->data));
+      gtk_image_menu_item_set_always_show_image (GTK_IMAGE_MENU_ITEM (mi), TRUE);
+      g_object_set_data (G_OBJECT (mi), "applications-menu-plugin", plugin);
+      g_signal_connect_data (G_OBJECT (mi), "activate",
+          G_CALLBACK (applications_menu_plugin_search_activate),
+          g_object_ref (G_OBJECT (li->data)), (GClosureNotify) g_object_unref, 0);
+      gtk_menu_shell_append (GTK_MENU_SHELL (plugin->search_menu), mi);
+      gtk_widget_show (mi);
+
+      if (show_tooltips)
+        gtk_widget_set_tooltip_text (mi, pojk_menu_item_get_comment (li->data));
+
+      icon_name = pojk_menu_item_get_icon_name (li->data);
+      if (show_icons && !blxo_str_is_empty (icon_name))
+        {
+          image = blade_bar_image_new_from_source (icon_name);
+          blade_bar_image_set_size (BLADE_BAR_IMAGE (image), DEFAULT_ICON_SIZE);
+          gtk_image_menu_item_set_image (GTK_IMAGE_MENU_ITEM (mi), image);
+          gtk_widget_show (image);
+        }
+
+      if (first == NULL)
+        first = mi;
+    }
+
+  if (items == NULL)
+    {
+      mi = gtk_menu_item_new_with_label (_("No applications found"));
+      gtk_widget_set_sensitive (mi, FALSE);
+      gtk_menu_shell_append (GTK_MENU_SHELL (plugin->search_menu), mi);
+      gtk_widget_show (mi);
+    }
+
+  g_slist_free (items);
+
+  if (!GTK_WIDGET_VISIBLE (plugin->search_menu))
+    {
+      /* replace the menu with the search results */
+      gtk_menu_popdown (GTK_MENU (plugin->menu));
+      gtk_menu_popup (GTK_MENU (plugin->search_menu), NULL, NULL,
+                      position_func, plugin, 1,
+                      gtk_get_current_event_time ());
+    }
+  else
+    {
+      gtk_menu_reposition (GTK_MENU (plugin->search_menu));
+    }
+
+  /* so enter launches the best match */
+  if (first != NULL)
+    gtk_menu_shell_select_item (GTK_MENU_SHELL (plugin->search_menu), first);
+}
+
+
+
+static gboolean
+applications_menu_plugin_menu_key_press (GtkWidget              *menu,
+                                         GdkEventKey            *event,
+                                         ApplicationsMenuPlugin *plugin)
+{
+  GString  *text;
+  gchar    *prev;
+  gunichar  c;
+
+  bar_return_val_if_fail (XFCE_IS_APPLICATIONS_MENU_PLUGIN (plugin), FALSE);
+  bar_return_val_if_fail (GTK_IS_MENU (menu), FALSE);
+
+  /* leave accelerators to the menu */
+  if (BAR_HAS_FLAG (event->state, GDK_CONTROL_MASK | GDK_MOD1_MASK))
+    return FALSE;
+
+  text = plugin->search_text;
+  if (event->keyval == GDK_KEY_BackSpace)
+    {
+      if (text->len == 0)
+        return FALSE;
+
+      prev = g_utf8_find_prev_char (text->str, text->str + text->len);
+      g_string_truncate (text, prev != NULL ? (gsize) (prev - text->str) : 0);
+    }
+  else
+    {
+      /* space activates menu items if there is no search text */
+      c = gdk_keyval_to_unicode (event->keyval);
+      if (c == 0
+          || !g_unichar_isprint (c)
+          || (text->len == 0 && g_unichar_isspace (c)))
+        return FALSE;
+
+      g_string_append_unichar (text, c);
+    }
+
+  applications_menu_plugin_search_update (plugin);
+
+  return TRUE;
 }
 
 
@@ -799,15 +1140,33 @@ applications_menu_plugin_menu (GtkWidget              *button,
            && !BAR_HAS_FLAG (event->state, GDK_CONTROL_MASK)))
     return FALSE;
 
+  /* load the menu if this did not happen yet or if the
+   * menu properties changed since the last popup */
+  if (plugin->menu_needs_update)
+    applications_menu_plugin_set_pojk_menu (plugin);
+
   if (button != NULL)
     gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (button), TRUE);
 
   /* show the menu */
+  g_string_truncate (plugin->search_text, 0);
   gtk_menu_popup (GTK_MENU (plugin->menu), NULL, NULL,
                   button != NULL ? blade_bar_plugin_position_menu : NULL,
                   plugin, 1,
                   event != NULL ? event->time : gtk_get_current_event_time ());
 
+  /* the items are loaded now, make type-ahead work in the submenus */
+  applications_menu_plugin_menu_connect_submenus (plugin, plugin->menu);
+
+  /* index the loaded menu for type-ahead search */
+  if (plugin->search == NULL
+      && plugin->search_build_id == 0)
+    {
+      plugin->search_build_id = g_idle_add_full (G_PRIORITY_LOW,
+          applications_menu_plugin_search_build_idle, plugin,
+          applications_menu_plugin_search_build_idle_destroyed);
+    }
+
   return TRUE;
 }
 
@@ -43,6 +43,6 @@ case "$1" in
 esac
 
 # try to open bar menu, if this fails try xfdesktop
-@bindir@/blade-bar --plugin-event=applicationsmenu:popup:bool:$ATPOINTER || xfdesktop --menu
+@bindir@/blade-bar-popup applicationsmenu:popup:bool:$ATPOINTER || xfdesktop --menu
 
 # vim:set ts=2 sw=2 et ai:
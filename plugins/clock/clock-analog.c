@@ -46,8 +46,17 @@ static void      xfce_clock_analog_get_property  (GObject              *object,
                                                   GValue               *value,
                                                   GParamSpec           *pspec);
 static void      xfce_clock_analog_finalize      (GObject              *object);
+static void      xfce_clock_analog_style_set     (GtkWidget            *widget,
+                                                  GtkStyle             *previous_style);
+static void      xfce_clock_analog_state_changed (GtkWidget            *widget,
+                                                  GtkStateType          previous_state);
+static void      xfce_clock_analog_face_clear    (XfceClockAnalog      *analog);
 static gboolean  xfce_clock_analog_expose_event  (GtkWidget            *widget,
                                                   GdkEventExpose       *event);
+static void      xfce_clock_analog_get_center    (GtkWidget            *widget,
+                                                  gdouble              *xc,
+                                                  gdouble              *yc,
+                                                  gdouble              *radius);
 static void      xfce_clock_analog_draw_ticks    (cairo_t              *cr,
                                                   gdouble               xc,
                                                   gdouble               yc,
@@ -59,6 +68,13 @@ static void      xfce_clock_analog_draw_pointer  (cairo_t              *cr,
                                                   gdouble               angle,
                                                   gdouble               scale,
                                                   gboolean              line);
+static void      xfce_clock_analog_queue_pointer (GtkWidget            *widget,
+                                                  gdouble               xc,
+                                                  gdouble               yc,
+                                                  gdouble               radius,
+                                                  gdouble               angle,
+                                                  gdouble               scale,
+                                                  gboolean              line);
 static gboolean  xfce_clock_analog_update        (XfceClockAnalog      *analog,
                                                   ClockTime            *time);
 
@@ -86,6 +102,16 @@ struct _XfceClockAnalog
 
   guint               show_seconds : 1;
   ClockTime          *time;
+
+  /* the ticks, drawn once for the allocated size and style */
+  cairo_surface_t    *face;
+  gint                face_width;
+  gint                face_height;
+
+  /* time of the pointers on the screen, -1 to redraw everything */
+  gint                hour;
+  gint                minute;
+  gint                second;
 };
 
 
@@ -107,6 +133,8 @@ xfce_clock_analog_class_init (XfceClockAnalogClass *klass)
 
   gtkwidget_class = GTK_WIDGET_CLASS (klass);
   gtkwidget_class->expose_event = xfce_clock_analog_expose_event;
+  gtkwidget_class->style_set = xfce_clock_analog_style_set;
+  gtkwidget_class->state_changed = xfce_clock_analog_state_changed;
 
   g_object_class_install_property (gobject_class,
                                    PROP_SIZE_RATIO,
@@ -137,6 +165,12 @@ static void
 xfce_clock_analog_init (XfceClockAnalog *analog)
 {
   analog->show_seconds = FALSE;
+  analog->face = NULL;
+  analog->face_width = 0;
+  analog->face_height = 0;
+  analog->hour = -1;
+  analog->minute = -1;
+  analog->second = -1;
 }
 
 
@@ -164,6 +198,7 @@ xfce_clock_analog_set_property (GObject      *object,
     }
 
   /* reschedule the timeout and redraw */
+  analog->minute = -1;
   clock_time_timeout_set_interval (analog->timeout,
       analog->show_seconds ? CLOCK_INTERVAL_SECOND : CLOCK_INTERVAL_MINUTE);
   xfce_clock_analog_update (analog, analog->time);
@@ -200,14 +235,56 @@ xfce_clock_analog_get_property (GObject    *object,
 static void
 xfce_clock_analog_finalize (GObject *object)
 {
+  XfceClockAnalog *analog = XFCE_CLOCK_ANALOG (object);
+
   /* stop the timeout */
-  clock_time_timeout_free (XFCE_CLOCK_ANALOG (object)->timeout);
+  clock_time_timeout_free (analog->timeout);
+
+  if (analog->face != NULL)
+    cairo_surface_destroy (analog->face);
 
   (*G_OBJECT_CLASS (xfce_clock_analog_parent_class)->finalize) (object);
 }
 
 
 
+static void
+xfce_clock_analog_face_clear (XfceClockAnalog *analog)
+{
+  if (analog->face != NULL)
+    {
+      cairo_surface_destroy (analog->face);
+      analog->face = NULL;
+    }
+}
+
+
+
+static void
+xfce_clock_analog_style_set (GtkWidget *widget,
+                             GtkStyle  *previous_style)
+{
+  /* the ticks are drawn in the foreground color */
+  xfce_clock_analog_face_clear (XFCE_CLOCK_ANALOG (widget));
+
+  if (GTK_WIDGET_CLASS (xfce_clock_analog_parent_class)->style_set != NULL)
+    (*GTK_WIDGET_CLASS (xfce_clock_analog_parent_class)->style_set) (widget, previous_style);
+}
+
+
+
+static void
+xfce_clock_analog_state_changed (GtkWidget    *widget,
+                                 GtkStateType  previous_state)
+{
+  xfce_clock_analog_face_clear (XFCE_CLOCK_ANALOG (widget));
+
+  if (GTK_WIDGET_CLASS (xfce_clock_analog_parent_class)->state_changed != NULL)
+    (*GTK_WIDGET_CLASS (xfce_clock_analog_parent_class)->state_changed) (widget, previous_state);
+}
+
+
+
 static gboolean
 xfce_clock_analog_expose_event (GtkWidget      *widget,
                                 GdkEventExpose *event)
@@ -215,19 +292,14 @@ xfce_clock_analog_expose_event (GtkWidget      *widget,
   XfceClockAnalog *analog = XFCE_CLOCK_ANALOG (widget);
   gdouble          xc, yc;
   gdouble          angle, radius;
-  cairo_t         *cr;
+  cairo_t         *cr, *face_cr;
   GDateTime       *date_time;
+  GdkColor        *color;
 
   bar_return_val_if_fail (XFCE_CLOCK_IS_ANALOG (analog), FALSE);
 
   /* get center of the widget and the radius */
-  xc = (widget->allocation.width / 2.0);
-  yc = (widget->allocation.height / 2.0);
-  radius = MIN (xc, yc);
-
-  /* add the window offset */
-  xc += widget->allocation.x;
-  yc += widget->allocation.y;
+  xfce_clock_analog_get_center (widget, &xc, &yc, &radius);
 
   /* get the cairo context */
   cr = gdk_cairo_create (widget->window);
@@ -238,15 +310,39 @@ xfce_clock_analog_expose_event (GtkWidget      *widget,
       gdk_cairo_rectangle (cr, &event->area);
       cairo_clip (cr);
 
+      color = &widget->style->fg[GTK_WIDGET_STATE (widget)];
+
+      /* (re)draw the ticks once for this size */
+      if (analog->face == NULL
+          || analog->face_width != widget->allocation.width
+          || analog->face_height != widget->allocation.height)
+        {
+          xfce_clock_analog_face_clear (analog);
+
+          analog->face_width = widget->allocation.width;
+          analog->face_height = widget->allocation.height;
+          analog->face = cairo_surface_create_similar (cairo_get_target (cr),
+                                                       CAIRO_CONTENT_COLOR_ALPHA,
+                                                       MAX (analog->face_width, 1),
+                                                       MAX (analog->face_height, 1));
+
+          face_cr = cairo_create (analog->face);
+          cairo_translate (face_cr, -widget->allocation.x, -widget->allocation.y);
+          gdk_cairo_set_source_color (face_cr, color);
+          xfce_clock_analog_draw_ticks (face_cr, xc, yc, radius);
+          cairo_destroy (face_cr);
+        }
+
+      cairo_set_source_surface (cr, analog->face,
+                                widget->allocation.x, widget->allocation.y);
+      cairo_paint (cr);
+
       /* get the local time */
       date_time = clock_time_get_time (analog->time);
 
       /* set the line properties */
       cairo_set_line_width (cr, 1);
-      gdk_cairo_set_source_color (cr, &widget->style->fg[GTK_WIDGET_STATE (widget)]);
-
-      /* draw the ticks */
-      xfce_clock_analog_draw_ticks (cr, xc, yc, radius);
+      gdk_cairo_set_source_color (cr, color);
 
       if (analog->show_seconds)
         {
@@ -273,6 +369,23 @@ xfce_clock_analog_expose_event (GtkWidget      *widget,
 
 
 
+static void
+xfce_clock_analog_get_center (GtkWidget *widget,
+                              gdouble   *xc,
+                              gdouble   *yc,
+                              gdouble   *radius)
+{
+  *xc = (widget->allocation.width / 2.0);
+  *yc = (widget->allocation.height / 2.0);
+  *radius = MIN (*xc, *yc);
+
+  /* add the window offset */
+  *xc += widget->allocation.x;
+  *yc += widget->allocation.y;
+}
+
+
+
 static void
 xfce_clock_analog_draw_ticks (cairo_t *cr,
                               gdouble  xc,
@@ -345,18 +458,91 @@ xfce_clock_analog_draw_pointer (cairo_t *cr,
 
 
 
+static void
+xfce_clock_analog_queue_pointer (GtkWidget *widget,
+                                 gdouble    xc,
+                                 gdouble    yc,
+                                 gdouble    radius,
+                                 gdouble    angle,
+                                 gdouble    scale,
+                                 gboolean   line)
+{
+  gdouble xt, yt;
+  gdouble r;
+  gint    x1, y1, x2, y2;
+
+  /* bounding box of the tip and the round base of the pointer */
+  xt = xc + sin (angle) * radius * scale;
+  yt = yc + cos (angle) * radius * scale;
+  r = line ? 0.0 : radius * CLOCK_SCALE;
+
+  /* with a margin for the antialiasing */
+  x1 = floor (MIN (xc - r, xt)) - 1;
+  y1 = floor (MIN (yc - r, yt)) - 1;
+  x2 = ceil (MAX (xc + r, xt)) + 1;
+  y2 = ceil (MAX (yc + r, yt)) + 1;
+
+  gtk_widget_queue_draw_area (widget, x1, y1, x2 - x1, y2 - y1);
+}
+
+
+
 static gboolean
 xfce_clock_analog_update (XfceClockAnalog *analog,
                           ClockTime       *clock_time)
 {
   GtkWidget *widget = GTK_WIDGET (analog);
+  GDateTime *date_time;
+  gint       hour, minute, second;
+  gdouble    xc, yc, radius;
 
   bar_return_val_if_fail (XFCE_CLOCK_IS_ANALOG (analog), FALSE);
   bar_return_val_if_fail (XFCE_IS_CLOCK_TIME (clock_time), FALSE);
 
+  date_time = clock_time_get_time (clock_time);
+  hour = g_date_time_get_hour (date_time);
+  minute = g_date_time_get_minute (date_time);
+  second = g_date_time_get_second (date_time);
+  g_date_time_unref (date_time);
+
   /* update if the widget if visible */
   if (G_LIKELY (GTK_WIDGET_VISIBLE (widget)))
-    gtk_widget_queue_draw (widget);
+    {
+      if (analog->minute == -1)
+        {
+          gtk_widget_queue_draw (widget);
+        }
+      else
+        {
+          /* only queue the old and new position of the pointers that
+           * moved, the ticks underneath come from the cached face */
+          xfce_clock_analog_get_center (widget, &xc, &yc, &radius);
+
+          if (analog->show_seconds && second != analog->second)
+            {
+              xfce_clock_analog_queue_pointer (widget, xc, yc, radius,
+                  TICKS_TO_RADIANS (analog->second), 0.7, TRUE);
+              xfce_clock_analog_queue_pointer (widget, xc, yc, radius,
+                  TICKS_TO_RADIANS (second), 0.7, TRUE);
+            }
+
+          if (minute != analog->minute || hour != analog->hour)
+            {
+              xfce_clock_analog_queue_pointer (widget, xc, yc, radius,
+                  TICKS_TO_RADIANS (analog->minute), 0.8, FALSE);
+              xfce_clock_analog_queue_pointer (widget, xc, yc, radius,
+                  TICKS_TO_RADIANS (minute), 0.8, FALSE);
+              xfce_clock_analog_queue_pointer (widget, xc, yc, radius,
+                  HOURS_TO_RADIANS (analog->hour, analog->minute), 0.5, FALSE);
+              xfce_clock_analog_queue_pointer (widget, xc, yc, radius,
+                  HOURS_TO_RADIANS (hour, minute), 0.5, FALSE);
+            }
+        }
+    }
+
+  analog->hour = hour;
+  analog->minute = minute;
+  analog->second = second;
 
   return TRUE;
 }
@@ -42,8 +42,17 @@ static void      xfce_clock_binary_get_property  (GObject              *object,
                                                   GValue               *value,
                                                   GParamSpec           *pspec);
 static void      xfce_clock_binary_finalize      (GObject              *object);
+static void      xfce_clock_binary_style_set     (GtkWidget            *widget,
+                                                  GtkStyle             *previous_style);
+static void      xfce_clock_binary_state_changed (GtkWidget            *widget,
+                                                  GtkStateType          previous_state);
+static void      xfce_clock_binary_face_clear    (XfceClockBinary      *binary);
 static gboolean  xfce_clock_binary_expose_event  (GtkWidget            *widget,
                                                   GdkEventExpose       *event);
+static void      xfce_clock_binary_get_area      (XfceClockBinary      *binary,
+                                                  GtkAllocation        *alloc,
+                                                  gint                 *cols,
+                                                  gint                 *rows);
 static gboolean  xfce_clock_binary_update        (XfceClockBinary      *binary,
                                                   ClockTime            *time);
 
@@ -78,6 +87,14 @@ struct _XfceClockBinary
   guint     show_grid : 1;
 
   ClockTime *time;
+
+  /* grid and inactive leds, drawn once for the allocated size and style */
+  cairo_surface_t *face;
+  gint             face_width;
+  gint             face_height;
+
+  /* time of the leds on the screen, -1 to redraw everything */
+  gint             ticks[3];
 };
 
 
@@ -99,6 +116,8 @@ xfce_clock_binary_class_init (XfceClockBinaryClass *klass)
 
   gtkwidget_class = GTK_WIDGET_CLASS (klass);
   gtkwidget_class->expose_event = xfce_clock_binary_expose_event;
+  gtkwidget_class->style_set = xfce_clock_binary_style_set;
+  gtkwidget_class->state_changed = xfce_clock_binary_state_changed;
 
   g_object_class_install_property (gobject_class,
                                    PROP_SIZE_RATIO,
@@ -153,7 +172,10 @@ xfce_clock_binary_init (XfceClockBinary *binary)
   binary->true_binary = FALSE;
   binary->show_inactive = TRUE;
   binary->show_grid = FALSE;
-
+  binary->face = NULL;
+  binary->face_width = 0;
+  binary->face_height = 0;
+  binary->ticks[0] = -1;
 }
 
 
@@ -194,6 +216,10 @@ xfce_clock_binary_set_property (GObject      *object,
       break;
     }
 
+  /* redraw the face and all the leds */
+  xfce_clock_binary_face_clear (binary);
+  binary->ticks[0] = -1;
+
   /* reschedule the timeout and resize */
   clock_time_timeout_set_interval (binary->timeout,
       binary->show_seconds ? CLOCK_INTERVAL_SECOND : CLOCK_INTERVAL_MINUTE);
@@ -248,21 +274,67 @@ xfce_clock_binary_get_property (GObject    *object,
 static void
 xfce_clock_binary_finalize (GObject *object)
 {
+  XfceClockBinary *binary = XFCE_CLOCK_BINARY (object);
+
   /* stop the timeout */
-  clock_time_timeout_free (XFCE_CLOCK_BINARY (object)->timeout);
+  clock_time_timeout_free (binary->timeout);
+
+  if (binary->face != NULL)
+    cairo_surface_destroy (binary->face);
 
   (*G_OBJECT_CLASS (xfce_clock_binary_parent_class)->finalize) (object);
 }
 
 
 
+static void
+xfce_clock_binary_face_clear (XfceClockBinary *binary)
+{
+  if (binary->face != NULL)
+    {
+      cairo_surface_destroy (binary->face);
+      binary->face = NULL;
+    }
+}
+
+
+
+static void
+xfce_clock_binary_style_set (GtkWidget *widget,
+                             GtkStyle  *previous_style)
+{
+  /* the face is drawn in the style colors */
+  xfce_clock_binary_face_clear (XFCE_CLOCK_BINARY (widget));
+
+  if (GTK_WIDGET_CLASS (xfce_clock_binary_parent_class)->style_set != NULL)
+    (*GTK_WIDGET_CLASS (xfce_clock_binary_parent_class)->style_set) (widget, previous_style);
+}
+
+
+
+static void
+xfce_clock_binary_state_changed (GtkWidget    *widget,
+                                 GtkStateType  previous_state)
+{
+  xfce_clock_binary_face_clear (XFCE_CLOCK_BINARY (widget));
+
+  if (GTK_WIDGET_CLASS (xfce_clock_binary_parent_class)->state_changed != NULL)
+    (*GTK_WIDGET_CLASS (xfce_clock_binary_parent_class)->state_changed) (widget, previous_state);
+}
+
+
+
+/*
+ * Without a time, only the inactive leds of the face are drawn,
+ * with a time only the active leds.
+ */
 static void
 xfce_clock_binary_expose_event_true_binary (XfceClockBinary *binary,
                                             cairo_t         *cr,
-                                            GtkAllocation   *alloc)
+                                            GtkAllocation   *alloc,
+                                            GDateTime       *date_time)
 {
   GdkColor    *active, *inactive;
-  GDateTime   *date_time;
   gint         row, rows;
   static gint  binary_table[] = { 32, 16, 8, 4, 2, 1 };
   gint         col, cols = G_N_ELEMENTS (binary_table);
@@ -282,8 +354,6 @@ xfce_clock_binary_expose_event_true_binary (XfceClockBinary *binary,
       active = &(GTK_WIDGET (binary)->style->dark[GTK_STATE_SELECTED]);
     }
 
-  date_time = clock_time_get_time (binary->time);
-
   /* init sizes */
   remain_h = alloc->height;
   offset_y = alloc->y;
@@ -292,7 +362,9 @@ xfce_clock_binary_expose_event_true_binary (XfceClockBinary *binary,
   for (row = 0; row < rows; row++)
     {
       /* get the time this row represents */
-      if (row == 0)
+      if (date_time == NULL)
+        ticks = 0;
+      else if (row == 0)
         ticks = g_date_time_get_hour (date_time);
       else if (row == 1)
         ticks = g_date_time_get_minute (date_time);
@@ -318,7 +390,7 @@ xfce_clock_binary_expose_event_true_binary (XfceClockBinary *binary,
               gdk_cairo_set_source_color (cr, active);
               ticks -= binary_table[col];
             }
-          else if (binary->show_inactive)
+          else if (date_time == NULL && binary->show_inactive)
             {
               gdk_cairo_set_source_color (cr, inactive);
             }
@@ -335,8 +407,6 @@ xfce_clock_binary_expose_event_true_binary (XfceClockBinary *binary,
       /* advance offset */
       offset_y += h;
     }
-
-  g_date_time_unref (date_time);
 }
 
 
@@ -344,11 +414,11 @@ xfce_clock_binary_expose_event_true_binary (XfceClockBinary *binary,
 static void
 xfce_clock_binary_expose_event_binary (XfceClockBinary *binary,
                                        cairo_t         *cr,
-                                       GtkAllocation   *alloc)
+                                       GtkAllocation   *alloc,
+                                       GDateTime       *date_time)
 {
   GdkColor    *active, *inactive;
   static gint  binary_table[] = { 80, 40, 20, 10, 8, 4, 2, 1 };
-  GDateTime   *date_time;
   gint         row, rows = G_N_ELEMENTS (binary_table) / 2;
   gint         col, cols;
   gint         digit;
@@ -368,8 +438,6 @@ xfce_clock_binary_expose_event_binary (XfceClockBinary *binary,
       active = &(GTK_WIDGET (binary)->style->dark[GTK_STATE_SELECTED]);
     }
 
-  date_time = clock_time_get_time (binary->time);
-
   remain_w = alloc->width;
   offset_x = alloc->x;
 
@@ -378,7 +446,9 @@ xfce_clock_binary_expose_event_binary (XfceClockBinary *binary,
   for (col = 0; col < cols; col++)
     {
       /* get the time this row represents */
-      if (col == 0)
+      if (date_time == NULL)
+        ticks = 0;
+      else if (col == 0)
         ticks = g_date_time_get_hour (date_time);
       else if (col == 2)
         ticks = g_date_time_get_minute (date_time);
@@ -405,7 +475,7 @@ xfce_clock_binary_expose_event_binary (XfceClockBinary *binary,
               gdk_cairo_set_source_color (cr, active);
               ticks -= binary_table[digit];
             }
-          else if (binary->show_inactive)
+          else if (date_time == NULL && binary->show_inactive)
             {
               gdk_cairo_set_source_color (cr, inactive);
             }
@@ -426,21 +496,69 @@ xfce_clock_binary_expose_event_binary (XfceClockBinary *binary,
 
 
 
+static void
+xfce_clock_binary_draw_face (XfceClockBinary *binary,
+                             cairo_t         *cr,
+                             GtkAllocation   *alloc,
+                             gint             cols,
+                             gint             rows)
+{
+  GdkColor *color;
+  gint      col, row;
+  gdouble   remain_w, x;
+  gdouble   remain_h, y;
+  gint      w, h;
+
+  if (binary->show_grid)
+    {
+      color = &(GTK_WIDGET (binary)->style->light[GTK_STATE_SELECTED]);
+      gdk_cairo_set_source_color (cr, color);
+      cairo_set_line_width (cr, 1);
+
+      remain_w = alloc->width;
+      remain_h = alloc->height;
+      x = alloc->x - 0.5;
+      y = alloc->y - 0.5;
+
+      cairo_rectangle (cr, x, y, alloc->width, alloc->height);
+      cairo_stroke (cr);
+
+      for (col = 0; col < cols - 1; col++)
+        {
+          w = remain_w / (cols - col);
+          x += w; remain_w -= w;
+          cairo_move_to (cr, x, alloc->y);
+          cairo_rel_line_to (cr, 0, alloc->height);
+          cairo_stroke (cr);
+        }
+
+      for (row = 0; row < rows - 1; row++)
+        {
+          h = remain_h / (rows - row);
+          y += h; remain_h -= h;
+          cairo_move_to (cr, alloc->x, y);
+          cairo_rel_line_to (cr, alloc->width, 0);
+          cairo_stroke (cr);
+        }
+    }
+
+  if (binary->true_binary)
+    xfce_clock_binary_expose_event_true_binary (binary, cr, alloc, NULL);
+  else
+    xfce_clock_binary_expose_event_binary (binary, cr, alloc, NULL);
+}
+
+
+
 static gboolean
 xfce_clock_binary_expose_event (GtkWidget      *widget,
                                 GdkEventExpose *event)
 {
   XfceClockBinary *binary = XFCE_CLOCK_BINARY (widget);
-  cairo_t         *cr;
-  GdkColor        *color;
-  gint             col, cols;
-  gint             row, rows;
+  cairo_t         *cr, *face_cr;
+  gint             cols, rows;
   GtkAllocation    alloc;
-  gdouble          remain_w, x;
-  gdouble          remain_h, y;
-  gint             w, h;
-  gint             pad_x, pad_y;
-  gint             diff;
+  GDateTime       *date_time;
 
   bar_return_val_if_fail (XFCE_CLOCK_IS_BINARY (binary), FALSE);
   bar_return_val_if_fail (GDK_IS_WINDOW (widget->window), FALSE);
@@ -452,64 +570,41 @@ xfce_clock_binary_expose_event (GtkWidget      *widget,
       gdk_cairo_rectangle (cr, &event->area);
       cairo_clip (cr);
 
-      gtk_misc_get_padding (GTK_MISC (widget), &pad_x, &pad_y);
-
-      alloc = widget->allocation;
-      alloc.width -= 1 + 2 * pad_x;
-      alloc.height -= 1 + 2 * pad_y;
-      alloc.x += pad_x + 1;
-      alloc.y += pad_y + 1;
+      xfce_clock_binary_get_area (binary, &alloc, &cols, &rows);
 
-      /* align columns and fix rounding */
-      cols = binary->true_binary ? 6 : (binary->show_seconds ? 6 : 4);
-      diff = alloc.width - (floor ((gdouble) alloc.width / cols) * cols);
-      alloc.width -= diff;
-      alloc.x += diff / 2;
-
-      /* align rows and fix rounding */
-      rows = binary->true_binary ? (binary->show_seconds ? 3 : 2) : 4;
-      diff = alloc.height - (floor ((gdouble) alloc.height / rows) * rows);
-      alloc.height -= diff;
-      alloc.y += diff / 2;
-
-      if (binary->show_grid)
+      /* (re)draw the grid and inactive leds once for this size */
+      if (binary->face == NULL
+          || binary->face_width != widget->allocation.width
+          || binary->face_height != widget->allocation.height)
         {
-          color = &(GTK_WIDGET (binary)->style->light[GTK_STATE_SELECTED]);
-          gdk_cairo_set_source_color (cr, color);
-          cairo_set_line_width (cr, 1);
-
-          remain_w = alloc.width;
-          remain_h = alloc.height;
-          x = alloc.x - 0.5;
-          y = alloc.y - 0.5;
-
-          cairo_rectangle (cr, x, y, alloc.width, alloc.height);
-          cairo_stroke (cr);
+          xfce_clock_binary_face_clear (binary);
+
+          binary->face_width = widget->allocation.width;
+          binary->face_height = widget->allocation.height;
+          binary->face = cairo_surface_create_similar (cairo_get_target (cr),
+                                                       CAIRO_CONTENT_COLOR_ALPHA,
+                                                       MAX (binary->face_width, 1),
+                                                       MAX (binary->face_height, 1));
+
+          face_cr = cairo_create (binary->face);
+          cairo_translate (face_cr, -widget->allocation.x, -widget->allocation.y);
+          xfce_clock_binary_draw_face (binary, face_cr, &alloc, cols, rows);
+          cairo_destroy (face_cr);
+        }
 
-          for (col = 0; col < cols - 1; col++)
-            {
-              w = remain_w / (cols - col);
-              x += w; remain_w -= w;
-              cairo_move_to (cr, x, alloc.y);
-              cairo_rel_line_to (cr, 0, alloc.height);
-              cairo_stroke (cr);
-            }
+      cairo_set_source_surface (cr, binary->face,
+                                widget->allocation.x, widget->allocation.y);
+      cairo_paint (cr);
 
-          for (row = 0; row < rows - 1; row++)
-            {
-              h = remain_h / (rows - row);
-              y += h; remain_h -= h;
-              cairo_move_to (cr, alloc.x, y);
-              cairo_rel_line_to (cr, alloc.width, 0);
-              cairo_stroke (cr);
-            }
-        }
+      /* the active leds on top */
+      date_time = clock_time_get_time (binary->time);
 
       if (binary->true_binary)
-        xfce_clock_binary_expose_event_true_binary (binary, cr, &alloc);
+        xfce_clock_binary_expose_event_true_binary (binary, cr, &alloc, date_time);
       else
-        xfce_clock_binary_expose_event_binary (binary, cr, &alloc);
+        xfce_clock_binary_expose_event_binary (binary, cr, &alloc, date_time);
 
+      g_date_time_unref (date_time);
       cairo_destroy (cr);
     }
 
@@ -518,17 +613,91 @@ xfce_clock_binary_expose_event (GtkWidget      *widget,
 
 
 
+static void
+xfce_clock_binary_get_area (XfceClockBinary *binary,
+                            GtkAllocation   *alloc,
+                            gint            *cols,
+                            gint            *rows)
+{
+  GtkWidget *widget = GTK_WIDGET (binary);
+  gint       pad_x, pad_y;
+  gint       diff;
+
+  gtk_misc_get_padding (GTK_MISC (widget), &pad_x, &pad_y);
+
+  *alloc = widget->allocation;
+  alloc->width -= 1 + 2 * pad_x;
+  alloc->height -= 1 + 2 * pad_y;
+  alloc->x += pad_x + 1;
+  alloc->y += pad_y + 1;
+
+  /* align columns and fix rounding */
+  *cols = binary->true_binary ? 6 : (binary->show_seconds ? 6 : 4);
+  diff = alloc->width - (floor ((gdouble) alloc->width / *cols) * *cols);
+  alloc->width -= diff;
+  alloc->x += diff / 2;
+
+  /* align rows and fix rounding */
+  *rows = binary->true_binary ? (binary->show_seconds ? 3 : 2) : 4;
+  diff = alloc->height - (floor ((gdouble) alloc->height / *rows) * *rows);
+  alloc->height -= diff;
+  alloc->y += diff / 2;
+}
+
+
+
 static gboolean
 xfce_clock_binary_update (XfceClockBinary     *binary,
                           ClockTime           *clock_time)
 {
-  GtkWidget *widget = GTK_WIDGET (binary);
+  GtkWidget     *widget = GTK_WIDGET (binary);
+  GDateTime     *date_time;
+  gint           ticks[3];
+  gint           i, n, w, h;
+  gint           cols, rows;
+  GtkAllocation  alloc;
 
   bar_return_val_if_fail (XFCE_CLOCK_IS_BINARY (binary), FALSE);
 
+  date_time = clock_time_get_time (clock_time);
+  ticks[0] = g_date_time_get_hour (date_time);
+  ticks[1] = g_date_time_get_minute (date_time);
+  ticks[2] = g_date_time_get_second (date_time);
+  g_date_time_unref (date_time);
+
   /* update if the widget if visible */
   if (G_LIKELY (GTK_WIDGET_VISIBLE (widget)))
-    gtk_widget_queue_draw (widget);
+    {
+      if (binary->ticks[0] == -1)
+        {
+          gtk_widget_queue_draw (widget);
+        }
+      else
+        {
+          /* only queue the rows (true binary) or pairs of columns
+           * of the hours, minutes or seconds that changed */
+          xfce_clock_binary_get_area (binary, &alloc, &cols, &rows);
+          n = binary->show_seconds ? 3 : 2;
+          w = alloc.width / cols;
+          h = alloc.height / rows;
+
+          for (i = 0; i < n; i++)
+            {
+              if (ticks[i] == binary->ticks[i])
+                continue;
+
+              if (binary->true_binary)
+                gtk_widget_queue_draw_area (widget, alloc.x, alloc.y + i * h,
+                                            alloc.width, h);
+              else
+                gtk_widget_queue_draw_area (widget, alloc.x + 2 * i * w, alloc.y,
+                                            2 * w, alloc.height);
+            }
+        }
+    }
+
+  for (i = 0; i < 3; i++)
+    binary->ticks[i] = ticks[i];
 
   return TRUE;
 }
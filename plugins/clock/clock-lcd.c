@@ -92,6 +92,15 @@ struct _XfceClockLcd
   guint               flash_separators : 1;
 
   ClockTime          *time;
+
+  /* time of the digits on the screen, -1 to redraw everything */
+  gint                hour;
+  gint                minute;
+  gint                second;
+
+  /* left side of the minutes and seconds, including the dots */
+  gint                minutes_x;
+  gint                seconds_x;
 };
 
 typedef struct
@@ -174,6 +183,11 @@ xfce_clock_lcd_init (XfceClockLcd *lcd)
   lcd->show_meridiem = FALSE;
   lcd->show_military = TRUE;
   lcd->flash_separators = FALSE;
+  lcd->hour = -1;
+  lcd->minute = -1;
+  lcd->second = -1;
+  lcd->minutes_x = -1;
+  lcd->seconds_x = -1;
 }
 
 
@@ -215,6 +229,9 @@ xfce_clock_lcd_set_property (GObject      *object,
 
   g_object_notify (object, "size-ratio");
 
+  /* redraw all the digits */
+  lcd->hour = -1;
+
   /* reschedule the timeout and resize */
   show_seconds = lcd->show_seconds || lcd->flash_separators;
   clock_time_timeout_set_interval (lcd->timeout,
@@ -364,6 +381,12 @@ xfce_clock_lcd_expose_event (GtkWidget      *widget,
               ticks = g_date_time_get_second (date_time);
             }
 
+          /* remember where the digits start for partial redraws */
+          if (i == 0)
+            lcd->minutes_x = floor (offset_x);
+          else
+            lcd->seconds_x = floor (offset_x);
+
           /* draw the dots */
           if (lcd->flash_separators && (g_date_time_get_second (date_time) % 2) == 1)
             offset_x += size * RELATIVE_SPACE * 2;
@@ -587,12 +610,46 @@ xfce_clock_lcd_update (XfceClockLcd *lcd,
                        ClockTime    *clock_time)
 {
   GtkWidget *widget = GTK_WIDGET (lcd);
+  GDateTime *date_time;
+  gint       hour, minute, second;
+  gint       x = -1;
 
   bar_return_val_if_fail (XFCE_CLOCK_IS_LCD (lcd), FALSE);
 
+  date_time = clock_time_get_time (clock_time);
+  hour = g_date_time_get_hour (date_time);
+  minute = g_date_time_get_minute (date_time);
+  second = g_date_time_get_second (date_time);
+  g_date_time_unref (date_time);
+
   /* update if the widget if visible */
   if (G_LIKELY (GTK_WIDGET_VISIBLE (widget)))
-    gtk_widget_queue_draw (widget);
+    {
+      if (lcd->hour != hour || lcd->minutes_x == -1)
+        {
+          /* the hours can change the width of the clock */
+          gtk_widget_queue_draw (widget);
+        }
+      else
+        {
+          /* only queue the digits right of the first one that changed,
+           * which usually are the seconds */
+          if (minute != lcd->minute
+              || (lcd->flash_separators && (second % 2) != (lcd->second % 2)))
+            x = lcd->minutes_x;
+          else if (lcd->show_seconds && second != lcd->second)
+            x = lcd->seconds_x;
+
+          if (x != -1)
+            gtk_widget_queue_draw_area (widget, x, widget->allocation.y,
+                                        widget->allocation.x + widget->allocation.width - x,
+                                        widget->allocation.height);
+        }
+    }
+
+  lcd->hour = hour;
+  lcd->minute = minute;
+  lcd->second = second;
 
   return TRUE;
 }
@@ -53,6 +53,12 @@
  * right time, they can prepend that manually in the entry */
 #define ZONEINFO_DIR "/usr/share/zoneinfo/posix/"
 
+/* compact list of all zones and links, shipped by tzdata since 2017c */
+#define ZONEINFO_INDEX "/usr/share/zoneinfo/tzdata.zi"
+
+/* number of timezone names added to the completion model per idle */
+#define ZONEINFO_CHUNK (50)
+
 
 
 static void     clock_plugin_get_property              (GObject               *object,
@@ -161,12 +167,20 @@ struct _ClockPlugin
 
 typedef struct
 {
-  ClockPlugin *plugin;
-  GtkBuilder  *builder;
-  guint        zonecompletion_idle;
+  ClockPlugin  *plugin;
+  GtkBuilder   *builder;
+  guint         zonecompletion_idle;
+  GtkListStore *zonecompletion_store;
+  guint         zonecompletion_n;
 }
 ClockPluginDialog;
 
+/* timezone names for the completion, collected once and shared by all
+ * dialogs in this process; the walk of ZONEINFO_DIR (when there is no
+ * index) reads one directory per idle from the stack of todo dirs */
+static GPtrArray *zoneinfo_names = NULL;
+static GSList    *zoneinfo_dirs = NULL;
+
 static const gchar *tooltip_formats[] =
 {
   DEFAULT_TOOLTIP_FORMAT,
@@ -827,6 +841,9 @@ clock_plugin_configure_plugin_free (gpointer user_data)
   if (dialog->zonecompletion_idle != 0)
     g_source_remove (dialog->zonecompletion_idle);
 
+  if (dialog->zonecompletion_store != NULL)
+    g_object_unref (G_OBJECT (dialog->zonecompletion_store));
+
   g_slice_free (ClockPluginDialog, dialog);
 }
 
@@ -869,45 +886,88 @@ clock_plugin_configure_run_config_tool (GtkWidget   *button,
 
 
 
+static gboolean
+clock_plugin_configure_zoneinfo_load_index (void)
+{
+  gchar  *contents;
+  gchar **lines, **fields;
+  guint   i;
+
+  if (!g_file_get_contents (ZONEINFO_INDEX, &contents, NULL, NULL))
+    return FALSE;
+
+  /* we only need the names of the zones (Z name ...) and links
+   * (L target name), the rules are not interesting */
+  lines = g_strsplit (contents, "\n", -1);
+  g_free (contents);
+
+  for (i = 0; lines[i] != NULL; i++)
+    {
+      if ((lines[i][0] != 'Z' && lines[i][0] != 'L')
+          || lines[i][1] != ' ')
+        continue;
+
+      fields = g_strsplit (lines[i], " ", 4);
+      if (lines[i][0] == 'Z' && g_strv_length (fields) >= 2)
+        g_ptr_array_add (zoneinfo_names, g_strdup (fields[1]));
+      else if (lines[i][0] == 'L' && g_strv_length (fields) >= 3)
+        g_ptr_array_add (zoneinfo_names, g_strdup (fields[2]));
+      g_strfreev (fields);
+    }
+
+  g_strfreev (lines);
+
+  return zoneinfo_names->len > 0;
+}
+
+
+
 static void
-clock_plugin_configure_zoneinfo_model_insert (GtkListStore *store,
-                                              const gchar  *parent)
+clock_plugin_configure_zoneinfo_read_dir (void)
 {
+  gchar       *parent;
   gchar       *filename;
-  GtkTreeIter  iter;
   GDir        *dir;
   const gchar *name;
   gsize        dirlen = strlen (ZONEINFO_DIR);
 
-  bar_return_if_fail (GTK_IS_LIST_STORE (store));
+  bar_return_if_fail (zoneinfo_dirs != NULL);
 
-  dir = g_dir_open (parent, 0, NULL);
-  if (dir == NULL)
-    return;
+  /* pop the next directory from the stack */
+  parent = zoneinfo_dirs->data;
+  zoneinfo_dirs = g_slist_delete_link (zoneinfo_dirs, zoneinfo_dirs);
 
-  for (;;)
+  dir = g_dir_open (parent, 0, NULL);
+  if (dir != NULL)
     {
-      name = g_dir_read_name (dir);
-      if (name == NULL)
-        break;
+      for (;;)
+        {
+          name = g_dir_read_name (dir);
+          if (name == NULL)
+            break;
 
-      filename = g_build_filename (parent, name, NULL);
+          filename = g_build_filename (parent, name, NULL);
 
-      if (g_file_test (filename, G_FILE_TEST_IS_DIR))
-        {
-          if (!g_file_test (filename, G_FILE_TEST_IS_SYMLINK))
-            clock_plugin_configure_zoneinfo_model_insert (store, filename);
-        }
-      else
-        {
-          gtk_list_store_append (store, &iter);
-          gtk_list_store_set (store, &iter, 0, filename + dirlen, -1);
+          if (g_file_test (filename, G_FILE_TEST_IS_DIR))
+            {
+              if (!g_file_test (filename, G_FILE_TEST_IS_SYMLINK))
+                {
+                  zoneinfo_dirs = g_slist_prepend (zoneinfo_dirs, filename);
+                  continue;
+                }
+            }
+          else
+            {
+              g_ptr_array_add (zoneinfo_names, g_strdup (filename + dirlen));
+            }
+
+          g_free (filename);
         }
 
-      g_free (filename);
+      g_dir_close (dir);
     }
 
-  g_dir_close (dir);
+  g_free (parent);
 }
 
 
@@ -917,34 +977,69 @@ clock_plugin_configure_zoneinfo_model (gpointer data)
 {
   ClockPluginDialog  *dialog = data;
   GtkEntryCompletion *completion;
-  GtkListStore       *store;
   GObject            *object;
+  guint               n;
 
   GDK_THREADS_ENTER ();
 
-  dialog->zonecompletion_idle = 0;
+  if (dialog->zonecompletion_store == NULL)
+    {
+      object = gtk_builder_get_object (dialog->builder, "timezone-name");
+      if (G_UNLIKELY (!GTK_IS_ENTRY (object)))
+        {
+          dialog->zonecompletion_idle = 0;
+          GDK_THREADS_LEAVE ();
+          return FALSE;
+        }
+
+      /* attach an empty model, it is filled in the next idles */
+      dialog->zonecompletion_store = gtk_list_store_new (1, G_TYPE_STRING);
+      gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (dialog->zonecompletion_store),
+                                            0, GTK_SORT_ASCENDING);
 
-  object = gtk_builder_get_object (dialog->builder, "timezone-name");
-  bar_return_val_if_fail (GTK_IS_ENTRY (object), FALSE);
+      completion = gtk_entry_completion_new ();
+      gtk_entry_completion_set_model (completion, GTK_TREE_MODEL (dialog->zonecompletion_store));
 
-  /* build timezone model */
-  store = gtk_list_store_new (1, G_TYPE_STRING);
-  clock_plugin_configure_zoneinfo_model_insert (store, ZONEINFO_DIR);
-  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store), 0, GTK_SORT_ASCENDING);
+      gtk_entry_set_completion (GTK_ENTRY (object), completion);
+      gtk_entry_completion_set_popup_single_match (completion, TRUE);
+      gtk_entry_completion_set_text_column (completion, 0);
 
-  completion = gtk_entry_completion_new ();
-  gtk_entry_completion_set_model (completion, GTK_TREE_MODEL (store));
-  g_object_unref (G_OBJECT (store));
+      g_object_unref (G_OBJECT (completion));
+    }
 
-  gtk_entry_set_completion (GTK_ENTRY (object), completion);
-  gtk_entry_completion_set_popup_single_match (completion, TRUE);
-  gtk_entry_completion_set_text_column (completion, 0);
+  if (zoneinfo_names == NULL)
+    {
+      /* first dialog in this process, prefer the index of tzdata */
+      zoneinfo_names = g_ptr_array_new ();
+      if (!clock_plugin_configure_zoneinfo_load_index ())
+        zoneinfo_dirs = g_slist_prepend (NULL, g_strdup (ZONEINFO_DIR));
+    }
+  else if (zoneinfo_dirs != NULL
+           && dialog->zonecompletion_n == zoneinfo_names->len)
+    {
+      /* this dialog is up to date, read the next directory */
+      clock_plugin_configure_zoneinfo_read_dir ();
+    }
 
-  g_object_unref (G_OBJECT (completion));
+  /* add the next chunk of names to the model */
+  for (n = 0; n < ZONEINFO_CHUNK
+       && dialog->zonecompletion_n < zoneinfo_names->len; n++)
+    {
+      gtk_list_store_insert_with_values (dialog->zonecompletion_store, NULL, -1, 0,
+          g_ptr_array_index (zoneinfo_names, dialog->zonecompletion_n), -1);
+      dialog->zonecompletion_n++;
+    }
 
   GDK_THREADS_LEAVE ();
 
-  return FALSE;
+  if (zoneinfo_dirs == NULL
+      && dialog->zonecompletion_n == zoneinfo_names->len)
+    {
+      dialog->zonecompletion_idle = 0;
+      return FALSE;
+    }
+
+  return TRUE;
 }
 
 
@@ -986,8 +1081,9 @@ clock_plugin_configure_plugin (BladeBarPlugin *bar_plugin)
   blxo_mutual_binding_new (G_OBJECT (plugin->time), "timezone",
                           G_OBJECT (object), "text");
 
-  /* idle add the zone completion */
-  dialog->zonecompletion_idle = g_idle_add (clock_plugin_configure_zoneinfo_model, dialog);
+  /* fill the zone completion in the background */
+  dialog->zonecompletion_idle = g_idle_add_full (G_PRIORITY_LOW,
+      clock_plugin_configure_zoneinfo_model, dialog, NULL);
 
   object = gtk_builder_get_object (builder, "mode");
   g_signal_connect_data (G_OBJECT (object), "changed",
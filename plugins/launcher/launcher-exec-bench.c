@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+#include <pojk/pojk.h>
+
+#include "launcher-exec.h"
+
+/* number of times every launch is repeated */
+#define N_RUNS (5)
+
+
+
+/*
+ * launcher-exec-bench
+ *
+ * Times launcher_plugin_item_exec(), the code that runs when files are
+ * dropped on a launcher, for 1, 100 and 1000 dropped files. This covers
+ * expanding the command line and spawning the processes, the command is
+ * true(1) so the time of the launched program itself does not count.
+ * Each count runs with a command that takes all the files (%F) and one
+ * that runs an instance per file (%f). Needs a display for the screen
+ * the commands are spawned on. The results are printed as key=value
+ * lines.
+ */
+
+
+
+static const guint bench_n_uris[] = { 1, 100, 1000 };
+
+
+
+static PojkMenuItem *
+bench_item_new (const gchar  *exec,
+                gchar       **filename)
+{
+  gchar        *contents;
+  GFile        *file;
+  PojkMenuItem *item;
+  gint          fd;
+
+  fd = g_file_open_tmp ("launcher-exec-bench-XXXXXX.desktop", filename, NULL);
+  if (fd == -1)
+    g_error ("Failed to create a temporary desktop file");
+  close (fd);
+
+  contents = g_strdup_printf ("[Desktop Entry]\n"
+                              "Type=Application\n"
+                              "Name=Bench\n"
+                              "StartupNotify=false\n"
+                              "Exec=%s\n", exec);
+  if (!g_file_set_contents (*filename, contents, -1, NULL))
+    g_error ("Failed to write \"%s\"", *filename);
+  g_free (contents);
+
+  file = g_file_new_for_path (*filename);
+  item = pojk_menu_item_new (file);
+  g_object_unref (G_OBJECT (file));
+
+  return item;
+}
+
+
+
+static void
+bench_run (const gchar *name,
+           const gchar *exec,
+           GSList      *uri_list,
+           guint        n_uris)
+{
+  PojkMenuItem *item;
+  GdkScreen    *screen;
+  GTimer       *timer;
+  gchar        *filename;
+  gdouble       elapsed, total = 0.0, longest = 0.0;
+  guint         run;
+
+  item = bench_item_new (exec, &filename);
+  screen = gdk_screen_get_default ();
+  timer = g_timer_new ();
+
+  for (run = 0; run < N_RUNS; run++)
+    {
+      g_timer_start (timer);
+      launcher_plugin_item_exec (item, GDK_CURRENT_TIME, screen, uri_list);
+      elapsed = g_timer_elapsed (timer, NULL) * 1000.0;
+
+      total += elapsed;
+      longest = MAX (longest, elapsed);
+
+      /* handle the child watches of the spawned processes */
+      while (g_main_context_pending (NULL))
+        g_main_context_iteration (NULL, FALSE);
+    }
+
+  g_print ("launch.%s.%u.avg-ms=%.3f\n", name, n_uris, total / N_RUNS);
+  g_print ("launch.%s.%u.max-ms=%.3f\n", name, n_uris, longest);
+
+  g_timer_destroy (timer);
+  g_object_unref (G_OBJECT (item));
+  g_unlink (filename);
+  g_free (filename);
+}
+
+
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GSList *uri_list;
+  guint   i, n;
+
+  if (!gtk_init_check (&argc, &argv))
+    {
+      g_printerr ("%s: Unable to open display\n", g_get_prgname ());
+      return EXIT_FAILURE;
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (bench_n_uris); i++)
+    {
+      /* escaped characters and quotes, like a file manager drops them */
+      uri_list = NULL;
+      for (n = bench_n_uris[i]; n > 0; n--)
+        uri_list = g_slist_prepend (uri_list,
+            g_strdup_printf ("file:///home/user/Pictures/Holiday%%202011/It%%27s%%20photo%%20%u.jpg", n));
+
+      bench_run ("all-files", "true %F", uri_list, bench_n_uris[i]);
+      bench_run ("per-file", "true %f", uri_list, bench_n_uris[i]);
+
+      g_slist_foreach (uri_list, (GFunc) g_free, NULL);
+      g_slist_free (uri_list);
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2008-2010 Nick Schermer <nick@xfce.org>
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <gtk/gtk.h>
+#include <blxo/blxo.h>
+#include <libbladeutil/libbladeutil.h>
+#include <libbladeui/libbladeui.h>
+#include <pojk/pojk.h>
+
+#include <common/bar-private.h>
+
+#include "launcher-exec.h"
+
+
+
+static void               launcher_plugin_exec_append_quoted            (GString              *string,
+                                                                         const gchar          *unquoted);
+static gboolean           launcher_plugin_exec_append_filename          (GString              *string,
+                                                                         const gchar          *uri);
+static gboolean           launcher_plugin_item_exec_on_screen           (PojkMenuItem         *item,
+                                                                         guint32               event_time,
+                                                                         GdkScreen            *screen,
+                                                                         GSList               *uri_list,
+                                                                         GString              *buffer);
+
+
+
+static void
+launcher_plugin_exec_append_quoted (GString     *string,
+                                    const gchar *unquoted)
+{
+  const gchar *p;
+
+  /* same quoting as g_shell_quote(), but without the
+   * temporary string for every argument */
+  g_string_append_c (string, '\'');
+  for (p = unquoted; *p != '\0'; ++p)
+    {
+      if (*p == '\'')
+        g_string_append (string, "'\\''");
+      else
+        g_string_append_c (string, *p);
+    }
+  g_string_append_c (string, '\'');
+}
+
+
+
+static gboolean
+launcher_plugin_exec_append_filename (GString     *string,
+                                      const gchar *uri)
+{
+  gchar       *filename;
+  const gchar *p;
+  gint         hi, lo;
+  gchar        c;
+
+  /* let glib handle everything that is not a plain local uri */
+  if (G_UNLIKELY (g_ascii_strncasecmp (uri, "file:///", 8) != 0
+                  || strchr (uri, '#') != NULL))
+    {
+      filename = g_filename_from_uri (uri, NULL, NULL);
+      if (G_UNLIKELY (filename == NULL))
+        return FALSE;
+
+      launcher_plugin_exec_append_quoted (string, filename);
+      g_free (filename);
+
+      return TRUE;
+    }
+
+  /* unescape the path directly into the quoted argument */
+  g_string_append_c (string, '\'');
+  for (p = uri + 7; *p != '\0'; ++p)
+    {
+      c = *p;
+      if (c == '%')
+        {
+          hi = g_ascii_xdigit_value (p[1]);
+          lo = hi >= 0 ? g_ascii_xdigit_value (p[2]) : -1;
+          if (G_UNLIKELY (lo < 0))
+            {
+              /* invalid escape, match g_filename_from_uri() */
+              return FALSE;
+            }
+
+          c = (hi << 4) | lo;
+          p += 2;
+
+          /* a nul byte or slash cannot be escaped in a path */
+          if (G_UNLIKELY (c == '\0' || c == '/'))
+            return FALSE;
+        }
+
+      if (c == '\'')
+        g_string_append (string, "'\\''");
+      else
+        g_string_append_c (string, c);
+    }
+  g_string_append_c (string, '\'');
+
+  return TRUE;
+}
+
+
+
+/* expand the field codes of the command of item into buffer, which
+ * is reused for every call, and split it into argv */
+gboolean
+launcher_plugin_exec_parse (PojkMenuItem   *item,
+                            GSList           *uri_list,
+                            GString          *buffer,
+                            gchar          ***argv,
+                            GError          **error)
+{
+  const gchar *p;
+  GSList      *li;
+  gchar       *uri;
+  const gchar *command, *tmp;
+  gsize        len;
+
+  bar_return_val_if_fail (POJK_IS_MENU_ITEM (item), FALSE);
+
+  /* get the command */
+  command = pojk_menu_item_get_command (item);
+  bar_return_val_if_fail (!blxo_str_is_empty (command), FALSE);
+
+  /* reuse the buffer of the caller */
+  g_string_truncate (buffer, 0);
+
+  /* prepend terminal command if required */
+  if (pojk_menu_item_requires_terminal (item))
+    g_string_append (buffer, "blxo-open --launch TerminalEmulator ");
+
+  for (p = command; *p != '\0'; ++p)
+    {
+      if (G_UNLIKELY (p[0] == '%' && p[1] != '\0'))
+        {
+          switch (*++p)
+            {
+            case 'f':
+            case 'F':
+              for (li = uri_list; li != NULL; li = li->next)
+                {
+                  /* remove partial output if the uri is not local */
+                  len = buffer->len;
+                  if (!launcher_plugin_exec_append_filename (buffer, li->data))
+                    {
+                      g_string_truncate (buffer, len);
+                      continue;
+                    }
+
+                  if (*p == 'f')
+                    break;
+                  if (li->next != NULL)
+                    g_string_append_c (buffer, ' ');
+                }
+              break;
+
+            case 'u':
+            case 'U':
+              for (li = uri_list; li != NULL; li = li->next)
+                {
+                  launcher_plugin_exec_append_quoted (buffer, (const gchar *)
+                                                      li->data);
+
+                  if (*p == 'u')
+                    break;
+                  if (li->next != NULL)
+                    g_string_append_c (buffer, ' ');
+                }
+              break;
+
+            case 'i':
+              tmp = pojk_menu_item_get_icon_name (item);
+              if (!blxo_str_is_empty (tmp))
+                {
+                  g_string_append (buffer, "--icon ");
+                  launcher_plugin_exec_append_quoted (buffer, tmp);
+                }
+              break;
+
+            case 'c':
+              tmp = pojk_menu_item_get_name (item);
+              if (!blxo_str_is_empty (tmp))
+                launcher_plugin_exec_append_quoted (buffer, tmp);
+              break;
+
+            case 'k':
+              uri = pojk_menu_item_get_uri (item);
+              if (!blxo_str_is_empty (uri))
+                launcher_plugin_exec_append_quoted (buffer, uri);
+              g_free (uri);
+              break;
+
+            case '%':
+              g_string_append_c (buffer, '%');
+              break;
+            }
+        }
+      else
+        {
+          g_string_append_c (buffer, *p);
+        }
+    }
+
+  return g_shell_parse_argv (buffer->str, NULL, argv, error);
+}
+
+
+
+static gboolean
+launcher_plugin_item_exec_on_screen (PojkMenuItem *item,
+                                     guint32         event_time,
+                                     GdkScreen      *screen,
+                                     GSList         *uri_list,
+                                     GString        *buffer)
+{
+  GError    *error = NULL;
+  gchar    **argv;
+  gboolean   succeed = FALSE;
+
+  bar_return_val_if_fail (POJK_IS_MENU_ITEM (item), FALSE);
+  bar_return_val_if_fail (GDK_IS_SCREEN (screen), FALSE);
+
+  /* parse the execute command */
+  if (launcher_plugin_exec_parse (item, uri_list, buffer, &argv, &error))
+    {
+      /* launch the command on the screen */
+      succeed = xfce_spawn_on_screen (screen,
+                                      pojk_menu_item_get_path (item),
+                                      argv, NULL, G_SPAWN_SEARCH_PATH,
+                                      pojk_menu_item_supports_startup_notification (item),
+                                      event_time,
+                                      pojk_menu_item_get_icon_name (item),
+                                      &error);
+
+      g_strfreev (argv);
+    }
+
+  if (G_UNLIKELY (!succeed))
+    {
+      /* show an error dialog */
+      xfce_dialog_show_error (NULL, error,
+                              _("Failed to execute command \"%s\"."),
+                              pojk_menu_item_get_command (item));
+      g_error_free (error);
+    }
+
+  return succeed;
+}
+
+
+
+void
+launcher_plugin_item_exec (PojkMenuItem *item,
+                           guint32         event_time,
+                           GdkScreen      *screen,
+                           GSList         *uri_list)
+{
+  GSList      *li, fake;
+  gboolean     proceed = TRUE;
+  const gchar *command;
+  GString     *buffer;
+
+  bar_return_if_fail (POJK_IS_MENU_ITEM (item));
+  bar_return_if_fail (GDK_IS_SCREEN (screen));
+
+  /* leave when there is nothing to execute */
+  command = pojk_menu_item_get_command (item);
+  if (blxo_str_is_empty (command))
+    return;
+
+  /* one command line buffer for all the instances we spawn */
+  buffer = g_string_sized_new (256);
+
+  if (G_UNLIKELY (uri_list != NULL
+      && strstr (command, "%F") == NULL
+      && strstr (command, "%U") == NULL))
+    {
+      fake.next = NULL;
+
+      /* run an instance for each file, break on the first error */
+      for (li = uri_list; li != NULL && proceed; li = li->next)
+        {
+          fake.data = li->data;
+          proceed = launcher_plugin_item_exec_on_screen (item, event_time, screen,
+                                                         &fake, buffer);
+        }
+    }
+  else
+    {
+      /* all uris are passed to a single instance */
+      launcher_plugin_item_exec_on_screen (item, event_time, screen,
+                                           uri_list, buffer);
+    }
+
+  g_string_free (buffer, TRUE);
+}
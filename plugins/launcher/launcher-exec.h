@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2008-2010 Nick Schermer <nick@xfce.org>
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef __XFCE_LAUNCHER_EXEC_H__
+#define __XFCE_LAUNCHER_EXEC_H__
+
+#include <gtk/gtk.h>
+#include <pojk/pojk.h>
+
+G_BEGIN_DECLS
+
+gboolean launcher_plugin_exec_parse (PojkMenuItem   *item,
+                                     GSList           *uri_list,
+                                     GString          *buffer,
+                                     gchar          ***argv,
+                                     GError          **error);
+
+void     launcher_plugin_item_exec  (PojkMenuItem     *item,
+                                     guint32           event_time,
+                                     GdkScreen        *screen,
+                                     GSList           *uri_list);
+
+G_END_DECLS
+
+#endif /* !__XFCE_LAUNCHER_EXEC_H__ */
@@ -38,6 +38,7 @@
 
 #include "launcher.h"
 #include "launcher-dialog.h"
+#include "launcher-exec.h"
 
 #define ARROW_BUTTON_SIZE              (12)
 #define TOOLTIP_ICON_SIZE              (32)
@@ -158,23 +159,9 @@ static gboolean           launcher_plugin_item_query_tooltip            (GtkWidg
                                                                          gboolean              keyboard_mode,
                                                                          GtkTooltip           *tooltip,
                                                                          PojkMenuItem       *item);
-static gboolean           launcher_plugin_item_exec_on_screen           (PojkMenuItem       *item,
-                                                                         guint32               event_time,
-                                                                         GdkScreen            *screen,
-                                                                         GSList               *uri_list);
-static void               launcher_plugin_item_exec                     (PojkMenuItem       *item,
-                                                                         guint32               event_time,
-                                                                         GdkScreen            *screen,
-                                                                         GSList               *uri_list);
 static void               launcher_plugin_item_exec_from_clipboard      (PojkMenuItem       *item,
                                                                          guint32               event_time,
                                                                          GdkScreen            *screen);
-static void               launcher_plugin_exec_append_quoted            (GString              *string,
-                                                                         const gchar          *unquoted);
-static gboolean           launcher_plugin_exec_parse                    (PojkMenuItem       *item,
-                                                                         GSList               *uri_list,
-                                                                         gchar              ***argv,
-                                                                         GError              **error);
 static GSList            *launcher_plugin_uri_list_extract              (GtkSelectionData     *data);
 static void               launcher_plugin_uri_list_free                 (GSList               *uri_list);
 
@@ -2273,87 +2260,6 @@ launcher_plugin_item_query_tooltip (GtkWidget      *widget,
 
 
 
-static gboolean
-launcher_plugin_item_exec_on_screen (PojkMenuItem *item,
-                                     guint32         event_time,
-                                     GdkScreen      *screen,
-                                     GSList         *uri_list)
-{
-  GError    *error = NULL;
-  gchar    **argv;
-  gboolean   succeed = FALSE;
-
-  bar_return_val_if_fail (POJK_IS_MENU_ITEM (item), FALSE);
-  bar_return_val_if_fail (GDK_IS_SCREEN (screen), FALSE);
-
-  /* parse the execute command */
-  if (launcher_plugin_exec_parse (item, uri_list, &argv, &error))
-    {
-      /* launch the command on the screen */
-      succeed = xfce_spawn_on_screen (screen,
-                                      pojk_menu_item_get_path (item),
-                                      argv, NULL, G_SPAWN_SEARCH_PATH,
-                                      pojk_menu_item_supports_startup_notification (item),
-                                      event_time,
-                                      pojk_menu_item_get_icon_name (item),
-                                      &error);
-
-      g_strfreev (argv);
-    }
-
-  if (G_UNLIKELY (!succeed))
-    {
-      /* show an error dialog */
-      xfce_dialog_show_error (NULL, error,
-                              _("Failed to execute command \"%s\"."),
-                              pojk_menu_item_get_command (item));
-      g_error_free (error);
-    }
-
-  return succeed;
-}
-
-
-
-static void
-launcher_plugin_item_exec (PojkMenuItem *item,
-                           guint32         event_time,
-                           GdkScreen      *screen,
-                           GSList         *uri_list)
-{
-  GSList      *li, fake;
-  gboolean     proceed = TRUE;
-  const gchar *command;
-
-  bar_return_if_fail (POJK_IS_MENU_ITEM (item));
-  bar_return_if_fail (GDK_IS_SCREEN (screen));
-
-  /* leave when there is nothing to execute */
-  command = pojk_menu_item_get_command (item);
-  if (blxo_str_is_empty (command))
-    return;
-
-  if (G_UNLIKELY (uri_list != NULL
-      && strstr (command, "%F") == NULL
-      && strstr (command, "%U") == NULL))
-    {
-      fake.next = NULL;
-
-      /* run an instance for each file, break on the first error */
-      for (li = uri_list; li != NULL && proceed; li = li->next)
-        {
-          fake.data = li->data;
-          proceed = launcher_plugin_item_exec_on_screen (item, event_time, screen, &fake);
-        }
-    }
-  else
-    {
-      launcher_plugin_item_exec_on_screen (item, event_time, screen, uri_list);
-    }
-}
-
-
-
 static void
 launcher_plugin_item_exec_from_clipboard (PojkMenuItem *item,
                                           guint32         event_time,
@@ -2403,123 +2309,6 @@ launcher_plugin_item_exec_from_clipboard (PojkMenuItem *item,
 
 
 
-static void
-launcher_plugin_exec_append_quoted (GString     *string,
-                                    const gchar *unquoted)
-{
-  gchar *quoted;
-
-  quoted = g_shell_quote (unquoted);
-  g_string_append (string, quoted);
-  g_free (quoted);
-}
-
-
-
-static gboolean
-launcher_plugin_exec_parse (PojkMenuItem   *item,
-                            GSList           *uri_list,
-                            gchar          ***argv,
-                            GError          **error)
-{
-  GString     *string;
-  const gchar *p;
-  gboolean     result;
-  GSList      *li;
-  gchar       *filename, *uri;
-  const gchar *command, *tmp;
-
-  bar_return_val_if_fail (POJK_IS_MENU_ITEM (item), FALSE);
-
-  /* get the command */
-  command = pojk_menu_item_get_command (item);
-  bar_return_val_if_fail (!blxo_str_is_empty (command), FALSE);
-
-  /* allocate an empty string */
-  string = g_string_sized_new (100);
-
-  /* prepend terminal command if required */
-  if (pojk_menu_item_requires_terminal (item))
-    g_string_append (string, "blxo-open --launch TerminalEmulator ");
-
-  for (p = command; *p != '\0'; ++p)
-    {
-      if (G_UNLIKELY (p[0] == '%' && p[1] != '\0'))
-        {
-          switch (*++p)
-            {
-            case 'f':
-            case 'F':
-              for (li = uri_list; li != NULL; li = li->next)
-                {
-                  filename = g_filename_from_uri ((const gchar *) li->data,
-                                                  NULL, NULL);
-                  if (G_LIKELY (filename != NULL))
-                    launcher_plugin_exec_append_quoted (string, filename);
-                  g_free (filename);
-
-                  if (*p == 'f')
-                    break;
-                  if (li->next != NULL)
-                    g_string_append_c (string, ' ');
-                }
-              break;
-
-            case 'u':
-            case 'U':
-              for (li = uri_list; li != NULL; li = li->next)
-                {
-                  launcher_plugin_exec_append_quoted (string, (const gchar *)
-                                                      li->data);
-
-                  if (*p == 'u')
-                    break;
-                  if (li->next != NULL)
-                    g_string_append_c (string, ' ');
-                }
-              break;
-
-            case 'i':
-              tmp = pojk_menu_item_get_icon_name (item);
-              if (!blxo_str_is_empty (tmp))
-                {
-                  g_string_append (string, "--icon ");
-                  launcher_plugin_exec_append_quoted (string, tmp);
-                }
-              break;
-
-            case 'c':
-              tmp = pojk_menu_item_get_name (item);
-              if (!blxo_str_is_empty (tmp))
-                launcher_plugin_exec_append_quoted (string, tmp);
-              break;
-
-            case 'k':
-              uri = pojk_menu_item_get_uri (item);
-              if (!blxo_str_is_empty (uri))
-                launcher_plugin_exec_append_quoted (string, uri);
-              g_free (uri);
-              break;
-
-            case '%':
-              g_string_append_c (string, '%');
-              break;
-            }
-        }
-      else
-        {
-          g_string_append_c (string, *p);
-        }
-    }
-
-  result = g_shell_parse_argv (string->str, NULL, argv, error);
-  g_string_free (string, TRUE);
-
-  return result;
-}
-
-
-
 static GSList *
 launcher_plugin_uri_list_extract (GtkSelectionData *data)
 {
@@ -2561,23 +2350,30 @@ launcher_plugin_uri_list_extract (GtkSelectionData *data)
       /* create the list of uris */
       for (i = 0; array[i] != NULL; i++)
         {
-          /* skip empty strings */
-          if (!!blxo_str_is_empty (array[i]))
-            continue;
-
           uri = NULL;
 
           if (g_path_is_absolute (array[i]))
-            uri = g_filename_to_uri (array[i], NULL, NULL);
-          else if (blxo_str_looks_like_an_uri (array[i]))
-            uri = g_strdup (array[i]);
+            {
+              uri = g_filename_to_uri (array[i], NULL, NULL);
+              g_free (array[i]);
+            }
+          else if (!blxo_str_is_empty (array[i])
+                   && blxo_str_looks_like_an_uri (array[i]))
+            {
+              /* take over the string */
+              uri = array[i];
+            }
+          else
+            {
+              g_free (array[i]);
+            }
 
           /* append the uri if we extracted one */
           if (G_LIKELY (uri != NULL))
             list = g_slist_prepend (list, uri);
         }
 
-      g_strfreev (array);
+      g_free (array);
     }
 
   return g_slist_reverse (list);
@@ -23,12 +23,19 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
 #ifdef HAVE_STRING_H
 #include <string.h>
 #endif
 
 #include <X11/Xlib.h>
 #include <X11/Xatom.h>
+#ifdef HAVE_LIBX11_XCB
+#include <X11/Xlib-xcb.h>
+#include <xcb/xcb.h>
+#endif
 
 #include <gdk/gdk.h>
 #include <gdk/gdkx.h>
@@ -43,6 +50,11 @@
 
 
 
+/* poll interval for the replies of the name requests */
+#define NAME_POLL_INTERVAL (5)
+
+
+
 struct _SystraySocketClass
 {
   GtkSocketClass __parent__;
@@ -60,18 +72,47 @@ struct _SystraySocket
   guint            is_composited : 1;
   guint            parent_relative_bg : 1;
   guint            hidden : 1;
+  guint            name_resolved : 1;
+
+#ifdef HAVE_LIBX11_XCB
+  /* pending _NET_WM_NAME and WM_NAME requests, 0 if done */
+  guint            name_requests[2];
+  guint            name_poll_id;
+#endif
 };
 
 
 
-static void     systray_socket_finalize      (GObject        *object);
-static void     systray_socket_realize       (GtkWidget      *widget);
-static void     systray_socket_size_allocate (GtkWidget      *widget,
-                                              GtkAllocation  *allocation);
-static gboolean systray_socket_expose_event  (GtkWidget      *widget,
-                                              GdkEventExpose *event);
-static void     systray_socket_style_set     (GtkWidget      *widget,
-                                              GtkStyle       *previous_style);
+enum
+{
+  NAME_CHANGED,
+  LAST_SIGNAL
+};
+
+
+
+/* sockets waiting for a synthetic expose, see
+ * systray_socket_force_redraw() */
+static GSList *redraw_sockets = NULL;
+static guint   redraw_idle_id = 0;
+
+static guint   socket_signals[LAST_SIGNAL];
+
+
+
+static void            systray_socket_finalize      (GObject        *object);
+static void            systray_socket_realize       (GtkWidget      *widget);
+static void            systray_socket_size_allocate (GtkWidget      *widget,
+                                                     GtkAllocation  *allocation);
+static gboolean        systray_socket_expose_event  (GtkWidget      *widget,
+                                                     GdkEventExpose *event);
+static void            systray_socket_style_set     (GtkWidget      *widget,
+                                                     GtkStyle       *previous_style);
+static GdkFilterReturn systray_socket_filter        (GdkXEvent      *xevent,
+                                                     GdkEvent       *event,
+                                                     gpointer        user_data);
+static void            systray_socket_name_request  (SystraySocket  *socket);
+static void            systray_socket_name_cancel   (SystraySocket  *socket);
 
 
 
@@ -93,6 +134,14 @@ systray_socket_class_init (SystraySocketClass *klass)
   gtkwidget_class->size_allocate = systray_socket_size_allocate;
   gtkwidget_class->expose_event = systray_socket_expose_event;
   gtkwidget_class->style_set = systray_socket_style_set;
+
+  socket_signals[NAME_CHANGED] =
+      g_signal_new (g_intern_static_string ("name-changed"),
+                    G_OBJECT_CLASS_TYPE (klass),
+                    G_SIGNAL_RUN_LAST,
+                    0, NULL, NULL,
+                    g_cclosure_marshal_VOID__VOID,
+                    G_TYPE_NONE, 0);
 }
 
 
@@ -102,6 +151,12 @@ systray_socket_init (SystraySocket *socket)
 {
   socket->hidden = FALSE;
   socket->name = NULL;
+  socket->name_resolved = FALSE;
+#ifdef HAVE_LIBX11_XCB
+  socket->name_requests[0] = 0;
+  socket->name_requests[1] = 0;
+  socket->name_poll_id = 0;
+#endif
 }
 
 
@@ -111,6 +166,14 @@ systray_socket_finalize (GObject *object)
 {
   SystraySocket *socket = XFCE_SYSTRAY_SOCKET (object);
 
+  /* drop a pending redraw */
+  redraw_sockets = g_slist_remove (redraw_sockets, socket);
+  if (redraw_sockets == NULL && redraw_idle_id != 0)
+    g_source_remove (redraw_idle_id);
+
+  gdk_window_remove_filter (NULL, systray_socket_filter, socket);
+  systray_socket_name_cancel (socket);
+
   g_free (socket->name);
 
   G_OBJECT_CLASS (systray_socket_parent_class)->finalize (object);
@@ -254,6 +317,12 @@ systray_socket_new (GdkScreen       *screen,
   /* get the window attributes */
   display = gdk_screen_get_display (screen);
   gdk_error_trap_push ();
+
+  /* watch the name of the icon, GtkSocket selects the same mask
+   * on the window when the icon is embedded; errors are reported
+   * with the reply of the attributes */
+  XSelectInput (GDK_DISPLAY_XDISPLAY (display), window, PropertyChangeMask);
+
   result = XGetWindowAttributes (GDK_DISPLAY_XDISPLAY (display),
                                  window, &attr);
 
@@ -296,23 +365,39 @@ systray_socket_new (GdkScreen       *screen,
       && gdk_display_supports_composite (gdk_screen_get_display (screen)))
     socket->is_composited = TRUE;
 
+  /* watch for name changes of the icon */
+  gdk_window_add_filter (NULL, systray_socket_filter, socket);
+
+  /* ask for the name, but don't wait for it */
+  systray_socket_name_request (socket);
+
   return GTK_WIDGET (socket);
 }
 
 
 
-void
-systray_socket_force_redraw (SystraySocket *socket)
+static gboolean
+systray_socket_force_redraw_idle (gpointer user_data)
 {
-  GtkWidget  *widget = GTK_WIDGET (socket);
-  XEvent      xev;
-  GdkDisplay *display;
+  GSList        *li;
+  SystraySocket *socket;
+  GtkWidget     *widget;
+  XEvent         xev;
+  Display       *xdisplay = NULL;
 
-  bar_return_if_fail (XFCE_IS_SYSTRAY_SOCKET (socket));
+  gdk_error_trap_push ();
 
-  if (GTK_WIDGET_MAPPED (socket) && socket->parent_relative_bg)
+  for (li = redraw_sockets; li != NULL; li = li->next)
     {
-      display = gtk_widget_get_display (widget);
+      socket = XFCE_SYSTRAY_SOCKET (li->data);
+      widget = GTK_WIDGET (socket);
+
+      if (!GTK_WIDGET_MAPPED (socket)
+          || !socket->parent_relative_bg
+          || GTK_SOCKET (socket)->plug_window == NULL)
+        continue;
+
+      xdisplay = GDK_DISPLAY_XDISPLAY (gtk_widget_get_display (widget));
 
       xev.xexpose.type = Expose;
       xev.xexpose.window = GDK_WINDOW_XWINDOW (GTK_SOCKET (socket)->plug_window);
@@ -322,16 +407,50 @@ systray_socket_force_redraw (SystraySocket *socket)
       xev.xexpose.height = widget->allocation.height;
       xev.xexpose.count = 0;
 
-      gdk_error_trap_push ();
-      XSendEvent (GDK_DISPLAY_XDISPLAY (display),
-                  xev.xexpose.window,
-                  False, ExposureMask,
-                  &xev);
-      /* We have to sync to reliably catch errors from the XSendEvent(),
-       * since that is asynchronous.
-       */
-      XSync (GDK_DISPLAY_XDISPLAY (display), False);
-      gdk_error_trap_pop ();
+      XSendEvent (xdisplay, xev.xexpose.window,
+                  False, ExposureMask, &xev);
+    }
+
+  /* We have to sync to reliably catch errors from the XSendEvent(),
+   * since that is asynchronous. Once for all the icons, so moving the
+   * bar costs a single round-trip instead of one per icon.
+   */
+  if (xdisplay != NULL)
+    XSync (xdisplay, False);
+  gdk_error_trap_pop ();
+
+  g_slist_free (redraw_sockets);
+  redraw_sockets = NULL;
+
+  return FALSE;
+}
+
+
+
+static void
+systray_socket_force_redraw_idle_destroyed (gpointer user_data)
+{
+  redraw_idle_id = 0;
+}
+
+
+
+void
+systray_socket_force_redraw (SystraySocket *socket)
+{
+  bar_return_if_fail (XFCE_IS_SYSTRAY_SOCKET (socket));
+
+  if (GTK_WIDGET_MAPPED (socket) && socket->parent_relative_bg)
+    {
+      /* queue the expose, all sockets are handled in one go */
+      if (g_slist_find (redraw_sockets, socket) == NULL)
+        redraw_sockets = g_slist_prepend (redraw_sockets, socket);
+
+      if (redraw_idle_id == 0)
+        {
+          redraw_idle_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE + 20, systray_socket_force_redraw_idle,
+                                            NULL, systray_socket_force_redraw_idle_destroyed);
+        }
     }
 }
 
@@ -402,19 +521,209 @@ systray_socket_get_name_prop (SystraySocket *socket,
 
 
 
+static GdkFilterReturn
+systray_socket_filter (GdkXEvent *xevent,
+                       GdkEvent  *event,
+                       gpointer   user_data)
+{
+  SystraySocket *socket = XFCE_SYSTRAY_SOCKET (user_data);
+  XEvent        *xev = (XEvent *) xevent;
+  GdkDisplay    *display;
+
+  if (xev->type != PropertyNotify
+      || xev->xproperty.window != socket->window)
+    return GDK_FILTER_CONTINUE;
+
+  display = gtk_widget_get_display (GTK_WIDGET (socket));
+  if (xev->xproperty.atom != gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_NAME")
+      && xev->xproperty.atom != gdk_x11_get_xatom_by_name_for_display (display, "WM_NAME"))
+    return GDK_FILTER_CONTINUE;
+
+  bar_debug_filtered (BAR_DEBUG_SYSTRAY, "socket %s[%p] changed name",
+                      socket->name, socket);
+
+  /* forget the name, also a missing one, and resolve it again */
+  g_free (socket->name);
+  socket->name = NULL;
+  socket->name_resolved = FALSE;
+
+  systray_socket_name_request (socket);
+
+#ifndef HAVE_LIBX11_XCB
+  /* without async requests the name is read again when asked for */
+  g_signal_emit (G_OBJECT (socket), socket_signals[NAME_CHANGED], 0);
+#endif
+
+  return GDK_FILTER_CONTINUE;
+}
+
+
+
+#ifdef HAVE_LIBX11_XCB
+static gboolean
+systray_socket_name_reply (SystraySocket *socket,
+                           guint          n,
+                           const gchar   *type_name)
+{
+  GdkDisplay               *display;
+  xcb_connection_t         *connection;
+  xcb_get_property_reply_t *reply = NULL;
+  xcb_generic_error_t      *error = NULL;
+  const gchar              *val;
+  gint                      len;
+
+  display = gtk_widget_get_display (GTK_WIDGET (socket));
+  connection = XGetXCBConnection (GDK_DISPLAY_XDISPLAY (display));
+
+  if (!xcb_poll_for_reply (connection, socket->name_requests[n],
+                           (void **) &reply, &error))
+    return FALSE;
+
+  socket->name_requests[n] = 0;
+
+  /* same checks as in systray_socket_get_name_prop() */
+  if (reply != NULL
+      && reply->type == gdk_x11_get_xatom_by_name_for_display (display, type_name)
+      && reply->format == 8)
+    {
+      val = xcb_get_property_value (reply);
+      len = xcb_get_property_value_length (reply);
+      if (len > 0 && g_utf8_validate (val, len, NULL))
+        socket->name = g_utf8_strdown (val, len);
+    }
+
+  free (reply);
+  free (error);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+systray_socket_name_poll (gpointer user_data)
+{
+  SystraySocket *socket = XFCE_SYSTRAY_SOCKET (user_data);
+  Display       *xdisplay;
+
+  /* _NET_WM_NAME first, for gtk icon implementations */
+  if (socket->name_requests[0] != 0)
+    {
+      if (!systray_socket_name_reply (socket, 0, "UTF8_STRING"))
+        return TRUE;
+
+      if (socket->name != NULL && socket->name_requests[1] != 0)
+        {
+          xdisplay = GDK_DISPLAY_XDISPLAY (gtk_widget_get_display (GTK_WIDGET (socket)));
+          xcb_discard_reply (XGetXCBConnection (xdisplay), socket->name_requests[1]);
+          socket->name_requests[1] = 0;
+        }
+    }
+
+  /* WM_NAME for qt icons */
+  if (socket->name_requests[1] != 0
+      && !systray_socket_name_reply (socket, 1, "STRING"))
+    return TRUE;
+
+  socket->name_resolved = TRUE;
+
+  bar_debug_filtered (BAR_DEBUG_SYSTRAY, "socket %s[%p] resolved name",
+                      socket->name, socket);
+
+  g_signal_emit (G_OBJECT (socket), socket_signals[NAME_CHANGED], 0);
+
+  return FALSE;
+}
+
+
+
+static void
+systray_socket_name_poll_destroyed (gpointer user_data)
+{
+  XFCE_SYSTRAY_SOCKET (user_data)->name_poll_id = 0;
+}
+#endif
+
+
+
+static void
+systray_socket_name_request (SystraySocket *socket)
+{
+#ifdef HAVE_LIBX11_XCB
+  GdkDisplay       *display;
+  xcb_connection_t *connection;
+
+  systray_socket_name_cancel (socket);
+
+  /* send both requests at once, the replies are picked up from
+   * the main loop, so docking an icon costs no round trip */
+  display = gtk_widget_get_display (GTK_WIDGET (socket));
+  connection = XGetXCBConnection (GDK_DISPLAY_XDISPLAY (display));
+
+  socket->name_requests[0] = xcb_get_property (connection, FALSE, socket->window,
+      gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_NAME"),
+      gdk_x11_get_xatom_by_name_for_display (display, "UTF8_STRING"),
+      0, G_MAXINT32).sequence;
+  socket->name_requests[1] = xcb_get_property (connection, FALSE, socket->window,
+      gdk_x11_get_xatom_by_name_for_display (display, "WM_NAME"),
+      XA_STRING, 0, G_MAXINT32).sequence;
+  xcb_flush (connection);
+
+  socket->name_poll_id = g_timeout_add_full (G_PRIORITY_DEFAULT, NAME_POLL_INTERVAL,
+                                             systray_socket_name_poll, socket,
+                                             systray_socket_name_poll_destroyed);
+#endif
+}
+
+
+
+static void
+systray_socket_name_cancel (SystraySocket *socket)
+{
+#ifdef HAVE_LIBX11_XCB
+  Display *xdisplay;
+  guint    n;
+
+  xdisplay = GDK_DISPLAY_XDISPLAY (gtk_widget_get_display (GTK_WIDGET (socket)));
+
+  for (n = 0; n < G_N_ELEMENTS (socket->name_requests); n++)
+    {
+      if (socket->name_requests[n] != 0)
+        xcb_discard_reply (XGetXCBConnection (xdisplay), socket->name_requests[n]);
+      socket->name_requests[n] = 0;
+    }
+
+  if (socket->name_poll_id != 0)
+    g_source_remove (socket->name_poll_id);
+#endif
+}
+
+
+
 const gchar *
 systray_socket_get_name (SystraySocket *socket)
 {
   bar_return_val_if_fail (XFCE_IS_SYSTRAY_SOCKET (socket), NULL);
 
-  if (G_LIKELY (socket->name != NULL))
+  /* also remember icons without a name, the box asks for the
+   * name of each icon for every comparison when sorting; a
+   * rename of the icon resets this */
+  if (G_LIKELY (socket->name_resolved))
     return socket->name;
 
+#ifdef HAVE_LIBX11_XCB
+  /* the reply is not there yet, name-changed is emitted
+   * when it arrives */
+  if (socket->name_poll_id != 0)
+    return NULL;
+#endif
+
   /* try _NET_WM_NAME first, for gtk icon implementations, fall back to
    * WM_NAME for qt icons */
   socket->name = systray_socket_get_name_prop (socket, "_NET_WM_NAME", "UTF8_STRING");
   if (G_UNLIKELY (socket->name == NULL))
     socket->name = systray_socket_get_name_prop (socket, "WM_NAME", "STRING");
+  socket->name_resolved = TRUE;
 
   return socket->name;
 }
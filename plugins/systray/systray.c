@@ -78,6 +78,8 @@ static void     systray_plugin_icon_added                   (SystrayManager
 static void     systray_plugin_icon_removed                 (SystrayManager        *manager,
                                                              GtkWidget             *icon,
                                                              SystrayPlugin         *plugin);
+static void     systray_plugin_icon_name_changed            (SystraySocket         *socket,
+                                                             SystrayPlugin         *plugin);
 static void     systray_plugin_lost_selection               (SystrayManager        *manager,
                                                              SystrayPlugin         *plugin);
 static void     systray_plugin_dialog_add_application_names (gpointer               key,
@@ -595,20 +597,38 @@ static void
 systray_plugin_box_expose_event_icon (GtkWidget *child,
                                       gpointer   user_data)
 {
-  cairo_t       *cr = user_data;
-  GtkAllocation *alloc;
+  GdkEventExpose *event = user_data;
+  cairo_t        *cr;
+  GtkAllocation  *alloc;
+
+  if (!systray_socket_is_composited (XFCE_SYSTRAY_SOCKET (child)))
+    return;
+
+  alloc = &child->allocation;
+
+  /* skip hidden (see offscreen in box widget) icons */
+  if (alloc->x < 0 || alloc->y < 0)
+    return;
 
-  if (systray_socket_is_composited (XFCE_SYSTRAY_SOCKET (child)))
+  /* gdk tracks the damage of composited windows and invalidates the
+   * area of the icon in the box, so only icons that changed or are
+   * below an exposed area overlap the region */
+  if (gdk_region_rect_in (event->region, alloc) == GDK_OVERLAP_RECTANGLE_OUT)
+    return;
+
+  cr = gdk_cairo_create (event->window);
+  if (G_LIKELY (cr != NULL))
     {
-      alloc = &child->allocation;
+      gdk_cairo_region (cr, event->region);
+      cairo_clip (cr);
+      gdk_cairo_rectangle (cr, alloc);
+      cairo_clip (cr);
 
-      /* skip hidden (see offscreen in box widget) icons */
-      if (alloc->x > -1 && alloc->y > -1)
-        {
-          gdk_cairo_set_source_pixmap (cr, gtk_widget_get_window (child),
-                                       alloc->x, alloc->y);
-          cairo_paint (cr);
-        }
+      gdk_cairo_set_source_pixmap (cr, gtk_widget_get_window (child),
+                                   alloc->x, alloc->y);
+      cairo_paint (cr);
+
+      cairo_destroy (cr);
     }
 }
 
@@ -618,24 +638,13 @@ static void
 systray_plugin_box_expose_event (GtkWidget      *box,
                                  GdkEventExpose *event)
 {
-  cairo_t *cr;
-
   if (!gtk_widget_is_composited (box))
     return;
 
-  cr = gdk_cairo_create (gtk_widget_get_window (box));
-  if (G_LIKELY (cr != NULL))
-    {
-      gdk_cairo_rectangle (cr, &event->area);
-      cairo_clip (cr);
-
-      /* separately draw all the composed tray icons after gtk
-       * handled the expose event */
-      gtk_container_foreach (GTK_CONTAINER (box),
-          systray_plugin_box_expose_event_icon, cr);
-
-      cairo_destroy (cr);
-    }
+  /* separately draw the composed tray icons in the exposed
+   * region after gtk handled the expose event */
+  gtk_container_foreach (GTK_CONTAINER (box),
+      systray_plugin_box_expose_event_icon, event);
 }
 
 
@@ -724,20 +733,25 @@ systray_plugin_names_remove (gpointer key,
 
 
 
-static void
-systray_plugin_names_update_icon (GtkWidget *icon,
-                                  gpointer   data)
+static gboolean
+systray_plugin_names_update_icon (GtkWidget     *icon,
+                                  SystrayPlugin *plugin)
 {
-  SystrayPlugin *plugin = XFCE_SYSTRAY_PLUGIN (data);
   SystraySocket *socket = XFCE_SYSTRAY_SOCKET (icon);
   const gchar   *name;
+  gboolean       hidden;
 
-  bar_return_if_fail (XFCE_IS_SYSTRAY_PLUGIN (plugin));
-  bar_return_if_fail (XFCE_IS_SYSTRAY_SOCKET (icon));
+  bar_return_val_if_fail (XFCE_IS_SYSTRAY_PLUGIN (plugin), FALSE);
+  bar_return_val_if_fail (XFCE_IS_SYSTRAY_SOCKET (icon), FALSE);
 
   name = systray_socket_get_name (socket);
-  systray_socket_set_hidden (socket,
-      systray_plugin_names_get_hidden (plugin, name));
+  hidden = systray_plugin_names_get_hidden (plugin, name);
+  if (systray_socket_get_hidden (socket) == hidden)
+    return FALSE;
+
+  systray_socket_set_hidden (socket, hidden);
+
+  return TRUE;
 }
 
 
@@ -745,11 +759,20 @@ systray_plugin_names_update_icon (GtkWidget *icon,
 static void
 systray_plugin_names_update (SystrayPlugin *plugin)
 {
+  GList    *children, *li;
+  gboolean  changed = FALSE;
+
   bar_return_if_fail (XFCE_IS_SYSTRAY_PLUGIN (plugin));
 
-  gtk_container_foreach (GTK_CONTAINER (plugin->box),
-     systray_plugin_names_update_icon, plugin);
-  systray_box_update (XFCE_SYSTRAY_BOX (plugin->box));
+  children = gtk_container_get_children (GTK_CONTAINER (plugin->box));
+  for (li = children; li != NULL; li = li->next)
+    if (systray_plugin_names_update_icon (GTK_WIDGET (li->data), plugin))
+      changed = TRUE;
+  g_list_free (children);
+
+  /* only resort and relayout the box if an icon changed state */
+  if (changed)
+    systray_box_update (XFCE_SYSTRAY_BOX (plugin->box));
 }
 
 
@@ -829,6 +852,10 @@ systray_plugin_icon_added (SystrayManager *manager,
   gtk_container_add (GTK_CONTAINER (plugin->box), icon);
   gtk_widget_show (icon);
 
+  /* the name is resolved asynchronously and can change */
+  g_signal_connect (G_OBJECT (icon), "name-changed",
+      G_CALLBACK (systray_plugin_icon_name_changed), plugin);
+
   bar_debug_filtered (BAR_DEBUG_SYSTRAY, "added %s[%p] icon",
       systray_socket_get_name (XFCE_SYSTRAY_SOCKET (icon)), icon);
 }
@@ -845,6 +872,9 @@ systray_plugin_icon_removed (SystrayManager *manager,
   bar_return_if_fail (plugin->manager == manager);
   bar_return_if_fail (GTK_IS_WIDGET (icon));
 
+  g_signal_handlers_disconnect_by_func (G_OBJECT (icon),
+      G_CALLBACK (systray_plugin_icon_name_changed), plugin);
+
   /* remove the icon from the box */
   gtk_container_remove (GTK_CONTAINER (plugin->box), icon);
 
@@ -854,6 +884,23 @@ systray_plugin_icon_removed (SystrayManager *manager,
 
 
 
+static void
+systray_plugin_icon_name_changed (SystraySocket *socket,
+                                  SystrayPlugin *plugin)
+{
+  bar_return_if_fail (XFCE_IS_SYSTRAY_PLUGIN (plugin));
+  bar_return_if_fail (XFCE_IS_SYSTRAY_SOCKET (socket));
+
+  bar_debug_filtered (BAR_DEBUG_SYSTRAY, "icon %s[%p] changed name",
+      systray_socket_get_name (socket), socket);
+
+  /* the name is also the sort key, so always resort the box */
+  systray_plugin_names_update_icon (GTK_WIDGET (socket), plugin);
+  systray_box_update (XFCE_SYSTRAY_BOX (plugin->box));
+}
+
+
+
 static void
 systray_plugin_lost_selection (SystrayManager *manager,
                                SystrayPlugin  *plugin)
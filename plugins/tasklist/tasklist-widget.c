@@ -34,6 +34,7 @@
 #include <libbladebar/libbladebar.h>
 #include <common/bar-private.h>
 #include <common/bar-debug.h>
+#include <common/bar-trace.h>
 
 #ifdef GDK_WINDOWING_X11
 #include <X11/Xlib.h>
@@ -55,6 +56,7 @@
 #define ARROW_BUTTON_SIZE            (20)
 #define WIREFRAME_SIZE               (5) /* same as xfwm4 */
 #define DRAG_ACTIVATE_TIMEOUT        (500)
+#define BUTTON_UPDATE_TIMEOUT        (16) /* ~ one frame */
 
 
 
@@ -74,6 +76,7 @@
 #define xfce_tasklist_deskbar(tasklist) ((tasklist)->mode == BLADE_BAR_PLUGIN_MODE_DESKBAR)
 #define xfce_tasklist_filter_monitors(tasklist) (!(tasklist)->all_monitors && (tasklist)->n_monitors > 1)
 #define xfce_tasklist_geometry_set_invalid(tasklist) ((tasklist)->n_monitors = 0)
+#define xfce_tasklist_count(tasklist,counter) ((tasklist)->counters[counter].count++)
 
 
 
@@ -96,6 +99,19 @@ enum
   PROP_MIDDLE_CLICK
 };
 
+enum
+{
+  COUNTER_WINDOW_ADDED,
+  COUNTER_WINDOW_REMOVED,
+  COUNTER_NAME_CHANGED,
+  COUNTER_STATE_CHANGED,
+  COUNTER_ICON_CHANGED,
+  COUNTER_SORT,
+  COUNTER_SIZE_REQUEST,
+  COUNTER_SIZE_ALLOCATE,
+  N_COUNTERS
+};
+
 struct _XfceTasklistClass
 {
   GtkContainerClass __parent__;
@@ -176,6 +192,13 @@ struct _XfceTasklist
   /* icon geometries update timeout */
   guint                 update_icon_geometries_id;
 
+  /* traced workspace switch waiting for the relayout */
+  guint                 tracing_workspace_switch : 1;
+
+  /* handler invocations, reported with BAR_DEBUG=tasklist */
+  BarDebugCounter       counters[N_COUNTERS];
+  guint                 counters_timeout_id;
+
   /* idle monitor geometry update */
   guint                 update_monitor_geometry_id;
 
@@ -214,6 +237,13 @@ typedef enum
 }
 XfceTasklistChildType;
 
+typedef enum
+{
+  CHILD_UPDATE_NAME = 1 << 0,
+  CHILD_UPDATE_ICON = 1 << 1
+}
+XfceTasklistChildUpdate;
+
 typedef struct _XfceTasklistChild XfceTasklistChild;
 struct _XfceTasklistChild
 {
@@ -233,6 +263,10 @@ struct _XfceTasklistChild
   guint                   motion_timeout_id;
   guint                   motion_timestamp;
 
+  /* coalesced name and icon changes of the window */
+  guint                   update_timeout_id;
+  XfceTasklistChildUpdate update_flags;
+
   /* unique id for sorting by insert time,
    * simply increased for each new button */
   guint                   unique_id;
@@ -253,6 +287,18 @@ static const GtkTargetEntry source_targets[] =
   { "application/x-wnck-window-id", 0, 0 }
 };
 
+static const gchar *counter_names[N_COUNTERS] =
+{
+  "tasklist-window-added",
+  "tasklist-window-removed",
+  "tasklist-name-changed",
+  "tasklist-state-changed",
+  "tasklist-icon-changed",
+  "tasklist-sort",
+  "tasklist-size-request",
+  "tasklist-size-allocate"
+};
+
 
 
 static void               xfce_tasklist_get_property                     (GObject              *object,
@@ -306,6 +352,7 @@ static void               xfce_tasklist_skipped_windows_state_changed    (WnckWi
                                                                           WnckWindowState       new_state,
                                                                           XfceTasklist         *tasklist);
 static void               xfce_tasklist_sort                             (XfceTasklist         *tasklist);
+static void               xfce_tasklist_sort_child                       (XfceTasklistChild    *child);
 static gboolean           xfce_tasklist_update_icon_geometries           (gpointer              data);
 static void               xfce_tasklist_update_icon_geometries_destroyed (gpointer              data);
 
@@ -551,6 +598,8 @@ xfce_tasklist_class_init (XfceTasklistClass *klass)
 static void
 xfce_tasklist_init (XfceTasklist *tasklist)
 {
+  guint i;
+
   GTK_WIDGET_SET_FLAGS (tasklist, GTK_NO_WINDOW);
 
   tasklist->locked = 0;
@@ -578,7 +627,17 @@ xfce_tasklist_init (XfceTasklist *tasklist)
   tasklist->wireframe_window = 0;
 #endif
   tasklist->update_icon_geometries_id = 0;
+  tasklist->tracing_workspace_switch = FALSE;
   tasklist->update_monitor_geometry_id = 0;
+  for (i = 0; i < N_COUNTERS; i++)
+    {
+      tasklist->counters[i].name = counter_names[i];
+      tasklist->counters[i].count = 0;
+      tasklist->counters[i].reported = 0;
+    }
+  tasklist->counters_timeout_id = bar_debug_counters_watch (BAR_DEBUG_TASKLIST,
+                                                            tasklist->counters,
+                                                            N_COUNTERS);
   tasklist->max_button_length = DEFAULT_MAX_BUTTON_LENGTH;
   tasklist->min_button_length = DEFAULT_MIN_BUTTON_LENGTH;
   tasklist->max_button_size = DEFAULT_BUTTON_SIZE;
@@ -776,6 +835,8 @@ xfce_tasklist_finalize (GObject *object)
     g_source_remove (tasklist->update_icon_geometries_id);
   if (tasklist->update_monitor_geometry_id != 0)
     g_source_remove (tasklist->update_monitor_geometry_id);
+  if (tasklist->counters_timeout_id != 0)
+    g_source_remove (tasklist->counters_timeout_id);
 
   /* free the class group hash table */
   g_hash_table_destroy (tasklist->class_groups);
@@ -803,6 +864,8 @@ xfce_tasklist_size_request (GtkWidget      *widget,
   XfceTasklistChild *child;
   gint               child_height = 0;
 
+  xfce_tasklist_count (tasklist, COUNTER_SIZE_REQUEST);
+
   for (li = tasklist->windows, n_windows = 0; li != NULL; li = li->next)
     {
       child = li->data;
@@ -1038,6 +1101,8 @@ xfce_tasklist_size_allocate (GtkWidget     *widget,
 
   bar_return_if_fail (GTK_WIDGET_VISIBLE (tasklist->arrow_button));
 
+  xfce_tasklist_count (tasklist, COUNTER_SIZE_ALLOCATE);
+
   /* set widget allocation */
   widget->allocation = *allocation;
 
@@ -1046,6 +1111,8 @@ xfce_tasklist_size_allocate (GtkWidget     *widget,
     TRANSPOSE_AREA (area);
   bar_return_if_fail (area.height == tasklist->size);
 
+  bar_trace_begin ("tasklist-allocate");
+
   /* TODO if we compare the allocation with the requisition we can
    * do a fast path to the child allocation, i think */
 
@@ -1162,6 +1229,14 @@ xfce_tasklist_size_allocate (GtkWidget     *widget,
   if (tasklist->update_icon_geometries_id == 0)
     tasklist->update_icon_geometries_id = g_idle_add_full (G_PRIORITY_LOW, xfce_tasklist_update_icon_geometries,
                                                            tasklist, xfce_tasklist_update_icon_geometries_destroyed);
+
+  bar_trace_end ("tasklist-allocate");
+
+  if (G_UNLIKELY (tasklist->tracing_workspace_switch))
+    {
+      tasklist->tracing_workspace_switch = FALSE;
+      bar_trace_async_end (0, "tasklist-workspace-switch");
+    }
 }
 
 
@@ -1337,6 +1412,8 @@ xfce_tasklist_remove (GtkContainer *container,
 
           if (child->motion_timeout_id != 0)
             g_source_remove (child->motion_timeout_id);
+          if (child->update_timeout_id != 0)
+            g_source_remove (child->update_timeout_id);
 
           g_slice_free (XfceTasklistChild, child);
 
@@ -1617,6 +1694,15 @@ xfce_tasklist_active_workspace_changed (WnckScreen    *screen,
           && tasklist->all_workspaces))
     return;
 
+  /* measure until the buttons are allocated */
+  if (G_UNLIKELY (bar_trace_enabled ())
+      && previous_workspace != NULL
+      && !tasklist->tracing_workspace_switch)
+    {
+      tasklist->tracing_workspace_switch = TRUE;
+      bar_trace_async_begin (0, "tasklist-workspace-switch");
+    }
+
   /* walk all the children and update their visibility */
   active_ws = wnck_screen_get_active_workspace (screen);
   for (li = tasklist->windows; li != NULL; li = li->next)
@@ -1650,6 +1736,8 @@ xfce_tasklist_window_added (WnckScreen   *screen,
   bar_return_if_fail (tasklist->screen == screen);
   bar_return_if_fail (wnck_window_get_screen (window) == screen);
 
+  xfce_tasklist_count (tasklist, COUNTER_WINDOW_ADDED);
+
   /* ignore this window, but watch it for state changes */
   if (wnck_window_is_skip_tasklist (window))
     {
@@ -1702,6 +1790,9 @@ xfce_tasklist_window_added (WnckScreen   *screen,
     }
 
   gtk_widget_queue_resize (GTK_WIDGET (tasklist));
+
+  if (G_UNLIKELY (bar_trace_enabled ()))
+    bar_trace_counter ("tasklist-buttons", g_list_length (tasklist->windows));
 }
 
 
@@ -1723,6 +1814,8 @@ xfce_tasklist_window_removed (WnckScreen   *screen,
   bar_return_if_fail (XFCE_IS_TASKLIST (tasklist));
   bar_return_if_fail (tasklist->screen == screen);
 
+  xfce_tasklist_count (tasklist, COUNTER_WINDOW_REMOVED);
+
   /* check if the window is in our skipped window list */
   if (wnck_window_is_skip_tasklist (window)
       && (lp = g_slist_find (tasklist->skipped_windows, window)) != NULL)
@@ -1784,6 +1877,9 @@ xfce_tasklist_window_removed (WnckScreen   *screen,
           break;
         }
     }
+
+  if (G_UNLIKELY (bar_trace_enabled ()))
+    bar_trace_counter ("tasklist-buttons", g_list_length (tasklist->windows));
 }
 
 
@@ -1835,6 +1931,8 @@ xfce_tasklist_sort (XfceTasklist *tasklist)
 {
   bar_return_if_fail (XFCE_IS_TASKLIST (tasklist));
 
+  xfce_tasklist_count (tasklist, COUNTER_SORT);
+
   if (tasklist->sort_order != XFCE_TASKLIST_SORT_ORDER_DND)
     tasklist->windows = g_list_sort_with_data (tasklist->windows,
                                                xfce_tasklist_button_compare,
@@ -1845,6 +1943,38 @@ xfce_tasklist_sort (XfceTasklist *tasklist)
 
 
 
+static void
+xfce_tasklist_sort_child (XfceTasklistChild *child)
+{
+  XfceTasklist *tasklist = child->tasklist;
+  GList        *li;
+
+  bar_return_if_fail (XFCE_IS_TASKLIST (tasklist));
+
+  li = g_list_find (tasklist->windows, child);
+  if (G_UNLIKELY (li == NULL))
+    return;
+
+  /* nothing to do if the button is still between its neighbours,
+   * which is the common case for a title change */
+  if ((li->prev == NULL
+       || xfce_tasklist_button_compare (li->prev->data, child, tasklist) <= 0)
+      && (li->next == NULL
+          || xfce_tasklist_button_compare (child, li->next->data, tasklist) <= 0))
+    return;
+
+  xfce_tasklist_count (tasklist, COUNTER_SORT);
+
+  tasklist->windows = g_list_delete_link (tasklist->windows, li);
+  tasklist->windows = g_list_insert_sorted_with_data (tasklist->windows, child,
+                                                      xfce_tasklist_button_compare,
+                                                      tasklist);
+
+  gtk_widget_queue_resize (GTK_WIDGET (tasklist));
+}
+
+
+
 static gboolean
 xfce_tasklist_update_icon_geometries (gpointer data)
 {
@@ -2445,6 +2575,8 @@ xfce_tasklist_button_icon_changed (WnckWindow        *window,
   bar_return_if_fail (WNCK_IS_WINDOW (window));
   bar_return_if_fail (child->window == window);
 
+  xfce_tasklist_count (tasklist, COUNTER_ICON_CHANGED);
+
   /* 0 means icons are disabled */
   if (tasklist->minimized_icon_lucency == 0)
     return;
@@ -2491,6 +2623,8 @@ xfce_tasklist_button_name_changed (WnckWindow        *window,
   bar_return_if_fail (WNCK_IS_WINDOW (child->window));
   bar_return_if_fail (XFCE_IS_TASKLIST (child->tasklist));
 
+  xfce_tasklist_count (child->tasklist, COUNTER_NAME_CHANGED);
+
   name = wnck_window_get_name (child->window);
   gtk_widget_set_tooltip_text (GTK_WIDGET (child->button), name);
 
@@ -2501,14 +2635,84 @@ xfce_tasklist_button_name_changed (WnckWindow        *window,
   else if (wnck_window_is_shaded (child->window))
     name = label = g_strdup_printf ("=%s=", name);
 
-  gtk_label_set_text (GTK_LABEL (child->label), name);
+  /* setting the same text still queues a resize of the label */
+  if (strcmp (gtk_label_get_text (GTK_LABEL (child->label)), name) != 0)
+    gtk_label_set_text (GTK_LABEL (child->label), name);
 
   g_free (label);
 
   /* if window is null, we have not inserted the button the in
    * tasklist, so no need to sort, because we insert with sorting */
   if (window != NULL)
-    xfce_tasklist_sort (child->tasklist);
+    xfce_tasklist_sort_child (child);
+}
+
+
+
+static gboolean
+xfce_tasklist_button_update (gpointer data)
+{
+  XfceTasklistChild       *child = data;
+  XfceTasklistChildUpdate  flags = child->update_flags;
+
+  bar_return_val_if_fail (WNCK_IS_WINDOW (child->window), FALSE);
+
+  child->update_flags = 0;
+
+  if (BAR_HAS_FLAG (flags, CHILD_UPDATE_NAME))
+    xfce_tasklist_button_name_changed (child->window, child);
+  if (BAR_HAS_FLAG (flags, CHILD_UPDATE_ICON))
+    xfce_tasklist_button_icon_changed (child->window, child);
+
+  return FALSE;
+}
+
+
+
+static void
+xfce_tasklist_button_update_destroyed (gpointer data)
+{
+  ((XfceTasklistChild *) data)->update_timeout_id = 0;
+}
+
+
+
+static void
+xfce_tasklist_button_queue_update (XfceTasklistChild       *child,
+                                   XfceTasklistChildUpdate  flags)
+{
+  BAR_SET_FLAG (child->update_flags, flags);
+
+  /* apply all changes within a frame at once, applications like
+   * terminals can change their title many times per second */
+  if (child->update_timeout_id == 0)
+    {
+      child->update_timeout_id = g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, BUTTON_UPDATE_TIMEOUT,
+                                                     xfce_tasklist_button_update, child,
+                                                     xfce_tasklist_button_update_destroyed);
+    }
+}
+
+
+
+static void
+xfce_tasklist_button_name_changed_queued (WnckWindow        *window,
+                                          XfceTasklistChild *child)
+{
+  bar_return_if_fail (child->window == window);
+
+  xfce_tasklist_button_queue_update (child, CHILD_UPDATE_NAME);
+}
+
+
+
+static void
+xfce_tasklist_button_icon_changed_queued (WnckWindow        *window,
+                                          XfceTasklistChild *child)
+{
+  bar_return_if_fail (child->window == window);
+
+  xfce_tasklist_button_queue_update (child, CHILD_UPDATE_ICON);
 }
 
 
@@ -2528,6 +2732,8 @@ xfce_tasklist_button_state_changed (WnckWindow        *window,
   bar_return_if_fail (child->window == window);
   bar_return_if_fail (XFCE_IS_TASKLIST (child->tasklist));
 
+  xfce_tasklist_count (child->tasklist, COUNTER_STATE_CHANGED);
+
   /* remove if the new state is hidding the window from the tasklist */
   if (BAR_HAS_FLAG (changed_state, WNCK_WINDOW_STATE_SKIP_TASKLIST))
     {
@@ -3160,9 +3366,9 @@ xfce_tasklist_button_new (WnckWindow   *window,
 
   /* monitor window changes */
   g_signal_connect (G_OBJECT (window), "icon-changed",
-      G_CALLBACK (xfce_tasklist_button_icon_changed), child);
+      G_CALLBACK (xfce_tasklist_button_icon_changed_queued), child);
   g_signal_connect (G_OBJECT (window), "name-changed",
-      G_CALLBACK (xfce_tasklist_button_name_changed), child);
+      G_CALLBACK (xfce_tasklist_button_name_changed_queued), child);
   g_signal_connect (G_OBJECT (window), "state-changed",
       G_CALLBACK (xfce_tasklist_button_state_changed), child);
   g_signal_connect (G_OBJECT (window), "workspace-changed",
@@ -0,0 +1,479 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+
+#include <gtk/gtk.h>
+#include <gdk/gdkx.h>
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+
+
+
+/*
+ * tasklist-window-storm [OPTION...]
+ *
+ * Opens and closes a lot of toplevel windows, renames them, raises their
+ * urgency hint, minimizes them, moves them to other workspaces and
+ * monitors, and asks the window manager to switch workspaces. This is the
+ * load the tasklist and window menu plugins see on a busy desktop; run it
+ * next to the bar with BAR_DEBUG=tasklist,windowmenu and compare the
+ * counters the plugins report.
+ *
+ * Every kind of operation has its own rate in operations per second, 0
+ * runs them as fast as the X server accepts them. Minimizing, workspace
+ * moves and switches are requests to the window manager, without one they
+ * only cost the bar the client messages. The timings are printed as
+ * key=value lines.
+ */
+
+
+
+typedef struct _StormOperation StormOperation;
+
+typedef gboolean (*StormFunc) (GtkWidget **window,
+                               guint       index,
+                               gint        round);
+
+struct _StormOperation
+{
+  const gchar *name;
+  gint        *rate;
+  StormFunc    func;
+
+  /* number of operations and seconds spent on them */
+  guint        count;
+  gdouble      elapsed;
+};
+
+
+
+static gboolean storm_open    (GtkWidget **window,
+                               guint       index,
+                               gint        round);
+static gboolean storm_rename  (GtkWidget **window,
+                               guint       index,
+                               gint        round);
+static gboolean storm_urgent  (GtkWidget **window,
+                               guint       index,
+                               gint        round);
+static gboolean storm_monitor (GtkWidget **window,
+                               guint       index,
+                               gint        round);
+static gboolean storm_iconify (GtkWidget **window,
+                               guint       index,
+                               gint        round);
+static gboolean storm_desktop (GtkWidget **window,
+                               guint       index,
+                               gint        round);
+static gboolean storm_close   (GtkWidget **window,
+                               guint       index,
+                               gint        round);
+
+
+
+static gint opt_windows = 200;
+static gint opt_rounds = 5;
+static gint opt_switches = 50;
+static gint opt_open_rate = 0;
+static gint opt_rename_rate = 0;
+static gint opt_urgent_rate = 0;
+static gint opt_monitor_rate = 0;
+static gint opt_iconify_rate = 0;
+static gint opt_desktop_rate = 0;
+static gint opt_close_rate = 0;
+static gint opt_switch_rate = 0;
+
+/* number of workspaces of the window manager */
+static gint n_desktops = 1;
+
+
+
+static GOptionEntry option_entries[] =
+{
+  { "windows", 'w', 0, G_OPTION_ARG_INT, &opt_windows, "Number of windows per round", "N" },
+  { "rounds", 'r', 0, G_OPTION_ARG_INT, &opt_rounds, "Number of times the windows are opened and closed", "N" },
+  { "switches", 's', 0, G_OPTION_ARG_INT, &opt_switches, "Number of workspace switches", "N" },
+  { "open-rate", 0, 0, G_OPTION_ARG_INT, &opt_open_rate, "Windows opened per second", "N" },
+  { "rename-rate", 0, 0, G_OPTION_ARG_INT, &opt_rename_rate, "Windows renamed per second", "N" },
+  { "urgent-rate", 0, 0, G_OPTION_ARG_INT, &opt_urgent_rate, "Urgency hints set per second", "N" },
+  { "monitor-rate", 0, 0, G_OPTION_ARG_INT, &opt_monitor_rate, "Windows moved to another monitor per second", "N" },
+  { "iconify-rate", 0, 0, G_OPTION_ARG_INT, &opt_iconify_rate, "Windows minimized or restored per second", "N" },
+  { "desktop-rate", 0, 0, G_OPTION_ARG_INT, &opt_desktop_rate, "Windows moved to another workspace per second", "N" },
+  { "close-rate", 0, 0, G_OPTION_ARG_INT, &opt_close_rate, "Windows closed per second", "N" },
+  { "switch-rate", 0, 0, G_OPTION_ARG_INT, &opt_switch_rate, "Workspace switches per second", "N" },
+  { NULL }
+};
+
+/* the operations of a round, in this order */
+static StormOperation operations[] =
+{
+  { "open", &opt_open_rate, storm_open },
+  { "rename", &opt_rename_rate, storm_rename },
+  { "urgent", &opt_urgent_rate, storm_urgent },
+  { "monitor", &opt_monitor_rate, storm_monitor },
+  { "iconify", &opt_iconify_rate, storm_iconify },
+  { "desktop", &opt_desktop_rate, storm_desktop },
+  { "close", &opt_close_rate, storm_close }
+};
+
+
+
+/* push all requests to the server and wait until it handled them */
+static void
+storm_sync (void)
+{
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  XSync (GDK_DISPLAY_XDISPLAY (gdk_display_get_default ()), False);
+}
+
+
+
+/* wait until n operations took as long as the rate asks for */
+static void
+storm_pace (GTimer *timer,
+            guint   n,
+            gint    rate)
+{
+  gdouble wait;
+
+  if (rate <= 0)
+    return;
+
+  /* the operation has to reach the server before we sleep */
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+  XFlush (GDK_DISPLAY_XDISPLAY (gdk_display_get_default ()));
+
+  wait = (gdouble) n / rate - g_timer_elapsed (timer, NULL);
+  if (wait > 0.0)
+    g_usleep (wait * G_USEC_PER_SEC);
+}
+
+
+
+static void
+storm_client_message (Window       window,
+                      const gchar *message_type,
+                      glong        data0,
+                      glong        data1)
+{
+  Display *dpy = GDK_DISPLAY_XDISPLAY (gdk_display_get_default ());
+  Window   root = GDK_ROOT_WINDOW ();
+  XEvent   xev = { 0, };
+
+  xev.xclient.type = ClientMessage;
+  xev.xclient.serial = 0;
+  xev.xclient.send_event = True;
+  xev.xclient.display = dpy;
+  xev.xclient.window = window;
+  xev.xclient.message_type = XInternAtom (dpy, message_type, False);
+  xev.xclient.format = 32;
+  xev.xclient.data.l[0] = data0;
+  xev.xclient.data.l[1] = data1;
+
+  XSendEvent (dpy, root, False,
+              SubstructureRedirectMask | SubstructureNotifyMask, &xev);
+}
+
+
+
+static gint
+storm_get_n_desktops (void)
+{
+  Display *dpy = GDK_DISPLAY_XDISPLAY (gdk_display_get_default ());
+  Atom     type;
+  gint     format;
+  gulong   n_items, bytes_after;
+  guchar  *data = NULL;
+  gint     n = 1;
+
+  if (XGetWindowProperty (dpy, GDK_ROOT_WINDOW (),
+                          XInternAtom (dpy, "_NET_NUMBER_OF_DESKTOPS", False),
+                          0, 1, False, XA_CARDINAL, &type, &format,
+                          &n_items, &bytes_after, &data) == Success
+      && type == XA_CARDINAL && format == 32 && n_items == 1)
+    n = *(glong *) data;
+
+  if (data != NULL)
+    XFree (data);
+
+  return MAX (n, 1);
+}
+
+
+
+static gboolean
+storm_open (GtkWidget **window,
+            guint       index,
+            gint        round)
+{
+  gchar *title;
+
+  title = g_strdup_printf ("Storm %d.%u", round, index);
+  *window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_title (GTK_WINDOW (*window), title);
+  gtk_window_set_default_size (GTK_WINDOW (*window), 120, 80);
+  gtk_widget_show (*window);
+  g_free (title);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+storm_rename (GtkWidget **window,
+              guint       index,
+              gint        round)
+{
+  gchar *title;
+
+  title = g_strdup_printf ("Storm %d.%u (renamed)", round, index);
+  gtk_window_set_title (GTK_WINDOW (*window), title);
+  g_free (title);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+storm_urgent (GtkWidget **window,
+              guint       index,
+              gint        round)
+{
+  /* a few windows asking for attention at once */
+  if (index % 10 != 0)
+    return FALSE;
+
+  gtk_window_set_urgency_hint (GTK_WINDOW (*window), TRUE);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+storm_monitor (GtkWidget **window,
+               guint       index,
+               gint        round)
+{
+  GdkScreen    *screen = gtk_window_get_screen (GTK_WINDOW (*window));
+  GdkRectangle  geometry;
+  gint          n_monitors;
+
+  /* move to the next monitor, with a single monitor to the other half
+   * of the screen, the geometry change still reaches the tasklist */
+  n_monitors = gdk_screen_get_n_monitors (screen);
+  gdk_screen_get_monitor_geometry (screen, (index + round + 1) % n_monitors, &geometry);
+  if (n_monitors == 1)
+    geometry.x += ((index + round) % 2) * geometry.width / 2;
+
+  gtk_window_move (GTK_WINDOW (*window), geometry.x, geometry.y);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+storm_iconify (GtkWidget **window,
+               guint       index,
+               gint        round)
+{
+  /* minimize half of the windows, restore the other
+   * half in the next round */
+  if ((index + round) % 2 == 0)
+    gtk_window_iconify (GTK_WINDOW (*window));
+  else
+    gtk_window_deiconify (GTK_WINDOW (*window));
+
+  return TRUE;
+}
+
+
+
+static gboolean
+storm_desktop (GtkWidget **window,
+               guint       index,
+               gint        round)
+{
+  if (n_desktops < 2)
+    return FALSE;
+
+  /* _NET_WM_DESKTOP request from a pager, away from the
+   * first workspace so a filtering tasklist drops it */
+  storm_client_message (GDK_WINDOW_XID (gtk_widget_get_window (*window)), "_NET_WM_DESKTOP",
+                        1 + (index + round) % (n_desktops - 1), 2);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+storm_close (GtkWidget **window,
+             guint       index,
+             gint        round)
+{
+  gtk_widget_destroy (*window);
+  *window = NULL;
+
+  return TRUE;
+}
+
+
+
+static gdouble
+storm_round (GPtrArray *windows,
+             gint       round)
+{
+  StormOperation *operation;
+  GTimer         *timer;
+  gdouble         elapsed, total = 0.0;
+  guint           i, n, count;
+
+  timer = g_timer_new ();
+
+  for (n = 0; n < G_N_ELEMENTS (operations); n++)
+    {
+      operation = &operations[n];
+      count = 0;
+
+      g_timer_start (timer);
+
+      for (i = 0; i < windows->len; i++)
+        if (operation->func ((GtkWidget **) &g_ptr_array_index (windows, i), i, round))
+          storm_pace (timer, ++count, *operation->rate);
+      storm_sync ();
+
+      elapsed = g_timer_elapsed (timer, NULL);
+      operation->count += count;
+      operation->elapsed += elapsed;
+      total += elapsed;
+    }
+
+  g_timer_destroy (timer);
+
+  return total;
+}
+
+
+
+static gdouble
+storm_switch_workspaces (void)
+{
+  GTimer  *timer;
+  gdouble  elapsed;
+  gint     i;
+
+  timer = g_timer_new ();
+
+  /* _NET_CURRENT_DESKTOP request, toggle between the first two
+   * workspaces; the window stays on one of them so the tasklist
+   * has to filter on each switch */
+  for (i = 0; i < opt_switches; i++)
+    {
+      storm_client_message (GDK_ROOT_WINDOW (), "_NET_CURRENT_DESKTOP",
+                            (i + 1) % 2, gtk_get_current_event_time ());
+      storm_pace (timer, i + 1, opt_switch_rate);
+    }
+  storm_sync ();
+
+  elapsed = g_timer_elapsed (timer, NULL);
+  g_timer_destroy (timer);
+
+  return elapsed;
+}
+
+
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GError    *error = NULL;
+  GPtrArray *windows;
+  GtkWidget *window;
+  gdouble    elapsed, total = 0.0;
+  guint      n;
+  gint       i;
+
+  if (!gtk_init_with_args (&argc, &argv, NULL, option_entries, NULL, &error))
+    {
+      g_printerr ("%s: %s\n", g_get_prgname (),
+                  error != NULL ? error->message : "Unable to open display");
+      g_clear_error (&error);
+
+      return EXIT_FAILURE;
+    }
+
+  opt_windows = MAX (opt_windows, 1);
+  n_desktops = storm_get_n_desktops ();
+
+  windows = g_ptr_array_sized_new (opt_windows);
+  g_ptr_array_set_size (windows, opt_windows);
+
+  for (i = 0; i < opt_rounds; i++)
+    {
+      elapsed = storm_round (windows, i);
+      total += elapsed;
+      g_print ("storm.round.%d.ms=%.1f\n", i, elapsed * 1000.0);
+    }
+
+  if (opt_rounds > 0)
+    {
+      g_print ("storm.windows-per-second=%.0f\n",
+               (gdouble) opt_windows * opt_rounds / MAX (total, 0.001));
+
+      for (n = 0; n < G_N_ELEMENTS (operations); n++)
+        {
+          g_print ("storm.%s.count=%u\n", operations[n].name, operations[n].count);
+          if (operations[n].count > 0)
+            g_print ("storm.%s.per-second=%.0f\n", operations[n].name,
+                     operations[n].count / MAX (operations[n].elapsed, 0.001));
+        }
+    }
+
+  if (opt_switches > 0)
+    {
+      window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+      gtk_window_set_title (GTK_WINDOW (window), "Storm workspace");
+      gtk_widget_show (window);
+      storm_sync ();
+
+      elapsed = storm_switch_workspaces ();
+      g_print ("storm.switch.ms=%.2f\n", elapsed * 1000.0 / opt_switches);
+
+      gtk_widget_destroy (window);
+      storm_sync ();
+    }
+
+  g_ptr_array_free (windows, TRUE);
+
+  return EXIT_SUCCESS;
+}
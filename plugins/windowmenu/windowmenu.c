@@ -28,6 +28,7 @@
 #include <common/bar-utils.h>
 #include <gdk/gdkkeysyms.h>
 #include <common/bar-private.h>
+#include <common/bar-debug.h>
 
 #include "windowmenu.h"
 #include "windowmenu-dialog_ui.h"
@@ -39,6 +40,18 @@
 #define URGENT_FLAGS            (WNCK_WINDOW_STATE_DEMANDS_ATTENTION | \
                                  WNCK_WINDOW_STATE_URGENT)
 
+#define window_menu_plugin_count(plugin,counter) ((plugin)->counters[counter].count++)
+
+enum
+{
+  COUNTER_ACTIVE_WINDOW_CHANGED,
+  COUNTER_WINDOW_STATE_CHANGED,
+  COUNTER_WINDOW_OPENED,
+  COUNTER_WINDOW_CLOSED,
+  COUNTER_BLINKING_CHANGED,
+  N_COUNTERS
+};
+
 struct _WindowMenuPluginClass
 {
   BladeBarPluginClass __parent__;
@@ -69,6 +82,10 @@ struct _WindowMenuPlugin
   gint                minimized_icon_lucency;
   PangoEllipsizeMode  ellipsize_mode;
   gint                max_width_chars;
+
+  /* handler invocations, reported with BAR_DEBUG=windowmenu */
+  BarDebugCounter     counters[N_COUNTERS];
+  guint               counters_timeout_id;
 };
 
 enum
@@ -138,6 +155,14 @@ BLADE_BAR_DEFINE_PLUGIN_RESIDENT (WindowMenuPlugin, window_menu_plugin)
 
 
 static GQuark window_quark = 0;
+static const gchar *counter_names[N_COUNTERS] =
+{
+  "windowmenu-active-window-changed",
+  "windowmenu-window-state-changed",
+  "windowmenu-window-opened",
+  "windowmenu-window-closed",
+  "windowmenu-blinking-changed"
+};
 static GtkIconSize menu_icon_size = GTK_ICON_SIZE_INVALID;
 
 
@@ -237,6 +262,8 @@ window_menu_plugin_class_init (WindowMenuPluginClass *klass)
 static void
 window_menu_plugin_init (WindowMenuPlugin *plugin)
 {
+  guint i;
+
   plugin->button_style = BUTTON_STYLE_ICON;
   plugin->workspace_actions = FALSE;
   plugin->workspace_names = TRUE;
@@ -247,6 +274,16 @@ window_menu_plugin_init (WindowMenuPlugin *plugin)
   plugin->ellipsize_mode = DEFAULT_ELLIPSIZE_MODE;
   plugin->max_width_chars = DEFAULT_MAX_WIDTH_CHARS;
 
+  for (i = 0; i < N_COUNTERS; i++)
+    {
+      plugin->counters[i].name = counter_names[i];
+      plugin->counters[i].count = 0;
+      plugin->counters[i].reported = 0;
+    }
+  plugin->counters_timeout_id = bar_debug_counters_watch (BAR_DEBUG_WINDOWMENU,
+                                                          plugin->counters,
+                                                          N_COUNTERS);
+
   /* create the widgets */
   plugin->button = xfce_arrow_button_new (GTK_ARROW_NONE);
   blade_bar_plugin_add_action_widget (BLADE_BAR_PLUGIN (plugin), plugin->button);
@@ -476,6 +513,12 @@ window_menu_plugin_free_data (BladeBarPlugin *bar_plugin)
 {
   WindowMenuPlugin *plugin = XFCE_WINDOW_MENU_PLUGIN (bar_plugin);
 
+  if (plugin->counters_timeout_id != 0)
+    {
+      g_source_remove (plugin->counters_timeout_id);
+      plugin->counters_timeout_id = 0;
+    }
+
   /* disconnect screen changed signal */
   g_signal_handlers_disconnect_by_func (G_OBJECT (plugin),
           window_menu_plugin_screen_changed, NULL);
@@ -625,6 +668,8 @@ window_menu_plugin_active_window_changed (WnckScreen       *screen,
   bar_return_if_fail (WNCK_IS_SCREEN (screen));
   bar_return_if_fail (plugin->screen == screen);
 
+  window_menu_plugin_count (plugin, COUNTER_ACTIVE_WINDOW_CHANGED);
+
   /* only do this when the icon is visible */
   if (plugin->button_style == BUTTON_STYLE_ICON)
     {
@@ -670,6 +715,8 @@ window_menu_plugin_window_state_changed (WnckWindow       *window,
   bar_return_if_fail (plugin->urgentcy_notification);
   bar_return_if_fail (plugin->urgentcy_notification);
 
+  window_menu_plugin_count (plugin, COUNTER_WINDOW_STATE_CHANGED);
+
   /* only response to urgency changes and urgency notify is enabled */
   if (!BAR_HAS_FLAG (changed_mask, URGENT_FLAGS))
     return;
@@ -681,10 +728,12 @@ window_menu_plugin_window_state_changed (WnckWindow       *window,
     plugin->urgent_windows--;
 
   /* check if we need to change the button */
-  if (plugin->urgent_windows == 1)
-    xfce_arrow_button_set_blinking (XFCE_ARROW_BUTTON (plugin->button), TRUE);
-  else if (plugin->urgent_windows == 0)
-    xfce_arrow_button_set_blinking (XFCE_ARROW_BUTTON (plugin->button), FALSE);
+  if (plugin->urgent_windows == 1 || plugin->urgent_windows == 0)
+    {
+      xfce_arrow_button_set_blinking (XFCE_ARROW_BUTTON (plugin->button),
+                                      plugin->urgent_windows == 1);
+      window_menu_plugin_count (plugin, COUNTER_BLINKING_CHANGED);
+    }
 }
 
 
@@ -700,6 +749,8 @@ window_menu_plugin_window_opened (WnckScreen       *screen,
   bar_return_if_fail (plugin->screen == screen);
   bar_return_if_fail (plugin->urgentcy_notification);
 
+  window_menu_plugin_count (plugin, COUNTER_WINDOW_OPENED);
+
   /* monitor the window's state */
   g_signal_connect (G_OBJECT (window), "state-changed",
       G_CALLBACK (window_menu_plugin_window_state_changed), plugin);
@@ -723,6 +774,8 @@ window_menu_plugin_window_closed (WnckScreen       *screen,
   bar_return_if_fail (plugin->screen == screen);
   bar_return_if_fail (plugin->urgentcy_notification);
 
+  window_menu_plugin_count (plugin, COUNTER_WINDOW_CLOSED);
+
   /* check if we need to update the urgency counter */
   if (wnck_window_needs_attention (window))
     window_menu_plugin_window_state_changed (window, URGENT_FLAGS,
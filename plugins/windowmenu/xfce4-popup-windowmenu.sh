@@ -42,6 +42,6 @@ case "$1" in
     ;;
 esac
 
-exec @bindir@/blade-bar --plugin-event=windowmenu:popup:bool:$ATPOINTER
+exec @bindir@/blade-bar-popup windowmenu:popup:bool:$ATPOINTER
 
 # vim:set ts=2 sw=2 et ai:
@@ -0,0 +1,348 @@
+#!/bin/sh
+#
+# Copyright (C) 2026 agent <agent@local>
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+#
+
+#
+# Starts the bar on a private Xvfb display with a private D-Bus session
+# and Blconf store, holding BENCH_BARS bars of BENCH_PLUGINS plugins each,
+# runs the window storm against it and prints the results of the trace
+# as key=value lines:
+#
+#   startup.ms                 first trace event to the main loop
+#   span.NAME.*                count, total, average and maximum of the
+#                              traced spans: itembar-request and
+#                              itembar-allocate (relayout), tasklist-allocate
+#                              and tasklist-workspace-switch (latency), ...
+#   counter.NAME               last value of a counter, rss-kb and the
+#                              event counters of the tasklist and window menu
+#   counter.rss-kb.max         maximum resident memory of the bar in kB
+#   tasklist.updates-per-second  window adds and removes the tasklist handled
+#   storm.*                    timings of the window storm itself
+#
+# BENCH_STORM_ARGS are passed to the window storm, for example the
+# rates of its operations (--open-rate=N, --desktop-rate=N, ...).
+#
+# BENCH_SHARED_WRAPPER=false runs every external plugin in its own
+# wrapper instead of the shared wrapper host.
+#
+# The report is also written to BENCH_REPORT if set. BENCH_KEEP=1 keeps
+# the temporary directory with the trace for chrome://tracing.
+#
+# Exit status 77 (skipped) if Xvfb, dbus-launch or the installed bar
+# are not available.
+#
+
+: ${BENCH_BARS:=2}
+: ${BENCH_PLUGINS:=8}
+: ${BENCH_WINDOWS:=200}
+: ${BENCH_ROUNDS:=3}
+: ${BENCH_SWITCHES:=50}
+: ${BENCH_SETTLE:=3}
+: ${BENCH_SHARED_WRAPPER:=true}
+: ${BENCH_PLUGIN_NAMES:="launcher separator clock showdesktop directorymenu actions pager windowmenu"}
+: ${BLADE_BAR:=blade-bar}
+: ${WINDOW_STORM:=../plugins/tasklist/tasklist-window-storm}
+
+skip ()
+{
+  echo "SKIP: $*" >&2
+  exit 77
+}
+
+fail ()
+{
+  echo "FAIL: $*" >&2
+  exit 1
+}
+
+command -v Xvfb >/dev/null 2>&1 || skip "Xvfb not found"
+command -v dbus-launch >/dev/null 2>&1 || skip "dbus-launch not found"
+test -x "$BLADE_BAR" || skip "$BLADE_BAR not installed, run make install first"
+test -z "$BLADE_BAR_MIGRATE" || test -x "$BLADE_BAR_MIGRATE" \
+  || skip "$BLADE_BAR_MIGRATE not installed, run make install first"
+test -x "$WINDOW_STORM" || skip "$WINDOW_STORM not built"
+test -n "$BLADE_BAR_CONFIG_VERSION" || skip "BLADE_BAR_CONFIG_VERSION not set"
+
+tmp=`mktemp -d "${TMPDIR:-/tmp}/bar-bench.XXXXXX"` || fail "no temporary directory"
+trace="$tmp/trace.json"
+xvfb_pid=
+bar_pid=
+wm_pid=
+
+cleanup ()
+{
+  test -n "$bar_pid" && kill "$bar_pid" 2>/dev/null
+  test -n "$wm_pid" && kill "$wm_pid" 2>/dev/null
+  test -n "$DBUS_SESSION_BUS_PID" && kill "$DBUS_SESSION_BUS_PID" 2>/dev/null
+  test -n "$xvfb_pid" && kill "$xvfb_pid" 2>/dev/null
+  if test -n "$BENCH_KEEP"; then
+    echo "bench.directory=$tmp"
+  else
+    rm -rf "$tmp"
+  fi
+}
+trap cleanup EXIT
+trap 'exit 1' HUP INT TERM
+
+#
+# private X server, the first free display from :99 down
+#
+display=99
+while test $display -gt 10 && test -e "/tmp/.X$display-lock"; do
+  display=`expr $display - 1`
+done
+
+Xvfb ":$display" -screen 0 1600x1200x24 -nolisten tcp >"$tmp/xvfb.log" 2>&1 &
+xvfb_pid=$!
+
+i=0
+while ! test -S "/tmp/.X11-unix/X$display"; do
+  i=`expr $i + 1`
+  test $i -le 50 || skip "Xvfb did not start on :$display"
+  sleep 0.1
+done
+
+DISPLAY=":$display"
+export DISPLAY
+
+#
+# private session bus, blconfd is started on it and stores
+# everything below the private XDG_CONFIG_HOME
+#
+eval `dbus-launch --sh-syntax` || skip "failed to start a D-Bus session"
+
+XDG_CONFIG_HOME="$tmp/config"
+XDG_CACHE_HOME="$tmp/cache"
+XDG_CONFIG_DIRS="$tmp/xdg"
+export XDG_CONFIG_HOME XDG_CACHE_HOME XDG_CONFIG_DIRS
+mkdir -p "$XDG_CONFIG_HOME" "$XDG_CACHE_HOME" "$XDG_CONFIG_DIRS/xfce4/bar"
+
+# workspace switches need a window manager, use one if asked for
+if test -n "$BENCH_WM"; then
+  $BENCH_WM >"$tmp/wm.log" 2>&1 &
+  wm_pid=$!
+fi
+
+#
+# synthetic default configuration, the empty store makes the bar
+# migrate it on the first start: each bar has a tasklist and
+# BENCH_PLUGINS - 1 plugins from BENCH_PLUGIN_NAMES
+#
+{
+  echo '<?xml version="1.0" encoding="UTF-8"?>'
+  echo
+  echo '<channel name="blade-bar" version="1.0">'
+  echo "  <property name=\"configver\" type=\"int\" value=\"$BLADE_BAR_CONFIG_VERSION\"/>"
+  echo "  <property name=\"shared-wrapper\" type=\"bool\" value=\"$BENCH_SHARED_WRAPPER\"/>"
+  echo '  <property name="bars" type="array">'
+
+  bar=1
+  while test $bar -le $BENCH_BARS; do
+    echo "    <value type=\"int\" value=\"$bar\"/>"
+    bar=`expr $bar + 1`
+  done
+
+  plugin_id=1
+  bar=1
+  while test $bar -le $BENCH_BARS; do
+    # alternate top and bottom
+    position=`expr \( $bar % 2 \) \* 4 + 6`
+    echo "    <property name=\"bar-$bar\" type=\"empty\">"
+    echo "      <property name=\"position\" type=\"string\" value=\"p=$position;x=0;y=0\"/>"
+    echo '      <property name="length" type="uint" value="100"/>'
+    echo '      <property name="position-locked" type="bool" value="true"/>'
+    echo '      <property name="plugin-ids" type="array">'
+    n=1
+    while test $n -le $BENCH_PLUGINS; do
+      echo "        <value type=\"int\" value=\"$plugin_id\"/>"
+      plugin_id=`expr $plugin_id + 1`
+      n=`expr $n + 1`
+    done
+    echo '      </property>'
+    echo '    </property>'
+    bar=`expr $bar + 1`
+  done
+
+  echo '  </property>'
+  echo '  <property name="plugins" type="empty">'
+
+  plugin_id=1
+  bar=1
+  while test $bar -le $BENCH_BARS; do
+    echo "    <property name=\"plugin-$plugin_id\" type=\"string\" value=\"tasklist\"/>"
+    plugin_id=`expr $plugin_id + 1`
+    n=2
+    set -- $BENCH_PLUGIN_NAMES
+    while test $n -le $BENCH_PLUGINS; do
+      test $# -gt 0 || set -- $BENCH_PLUGIN_NAMES
+      echo "    <property name=\"plugin-$plugin_id\" type=\"string\" value=\"$1\"/>"
+      shift
+      plugin_id=`expr $plugin_id + 1`
+      n=`expr $n + 1`
+    done
+    bar=`expr $bar + 1`
+  done
+
+  echo '  </property>'
+  echo '</channel>'
+} >"$XDG_CONFIG_DIRS/xfce4/bar/default.xml"
+
+#
+# start the bar and wait for the main loop
+#
+BAR_TRACE="$trace" BAR_DEBUG=tasklist,windowmenu BLADE_BAR_MIGRATE_DEFAULT=1 \
+  "$BLADE_BAR" --disable-wm-check >"$tmp/bar.log" 2>&1 &
+bar_pid=$!
+
+i=0
+while ! grep -q '"name":"main-loop"' "$trace" 2>/dev/null; do
+  kill -0 $bar_pid 2>/dev/null || { cat "$tmp/bar.log" >&2; fail "the bar exited during startup"; }
+  i=`expr $i + 1`
+  test $i -le 300 || fail "the bar did not reach the main loop"
+  sleep 0.1
+done
+
+# external plugins finish their startup after the main loop
+sleep $BENCH_SETTLE
+
+"$WINDOW_STORM" --windows=$BENCH_WINDOWS --rounds=$BENCH_ROUNDS \
+  --switches=$BENCH_SWITCHES $BENCH_STORM_ARGS >"$tmp/storm.txt" 2>"$tmp/storm.log" \
+  || fail "the window storm failed"
+
+# the event counters are reported every 5 seconds
+sleep 6
+
+kill -0 $bar_pid 2>/dev/null || { cat "$tmp/bar.log" >&2; fail "the bar crashed"; }
+
+"$BLADE_BAR" --quit >/dev/null 2>&1
+i=0
+while kill -0 $bar_pid 2>/dev/null; do
+  i=`expr $i + 1`
+  test $i -le 100 || break
+  sleep 0.1
+done
+bar_pid=
+
+#
+# report
+#
+{
+  echo "bench.bars=$BENCH_BARS"
+  echo "bench.plugins=$BENCH_PLUGINS"
+  echo "bench.windows=$BENCH_WINDOWS"
+  echo "bench.rounds=$BENCH_ROUNDS"
+  echo "bench.switches=$BENCH_SWITCHES"
+
+  # one event per line, see common/bar-trace.c
+  awk '
+    function field(line, key,   re, v)
+    {
+      re = "\"" key "\":"
+      if (!match(line, re "(\"[^\"]*\"|-?[0-9]+)"))
+        return ""
+      v = substr(line, RSTART + length(re), RLENGTH - length(re))
+      gsub(/"/, "", v)
+      return v
+    }
+
+    function span(name, dur)
+    {
+      count[name]++
+      total[name] += dur
+      if (dur > longest[name])
+        longest[name] = dur
+    }
+
+    /"ph":"M"/ { next }
+
+    {
+      ph = field($0, "ph")
+      ts = field($0, "ts")
+      pid = field($0, "pid")
+      name = field($0, "name")
+      if (ts == "")
+        next
+
+      ts += 0
+      if (!have_first || ts < first)
+        {
+          first = ts
+          have_first = 1
+        }
+
+      if (ph == "i" && name == "main-loop" && main_loop == "")
+        main_loop = ts
+      else if (ph == "B")
+        open[pid, name] = ts
+      else if (ph == "E" && ((pid, name) in open))
+        {
+          span(name, ts - open[pid, name])
+          delete open[pid, name]
+        }
+      else if (ph == "b")
+        async[pid, name, field($0, "id")] = ts
+      else if (ph == "e" && ((pid, name, field($0, "id")) in async))
+        {
+          span(name, ts - async[pid, name, field($0, "id")])
+          delete async[pid, name, field($0, "id")]
+        }
+      else if (ph == "C")
+        {
+          value = field($0, "value")
+          last[name] = value
+          if (!(name in highest) || value + 0 > highest[name] + 0)
+            highest[name] = value
+          if (name == "tasklist-buttons")
+            {
+              if (updates == 0)
+                updates_first = ts
+              updates_last = ts
+              updates++
+            }
+        }
+    }
+
+    END {
+      if (main_loop != "")
+        printf "startup.ms=%.1f\n", (main_loop - first) / 1000.0
+      for (name in count)
+        {
+          printf "span.%s.count=%d\n", name, count[name]
+          printf "span.%s.total-ms=%.2f\n", name, total[name] / 1000.0
+          printf "span.%s.avg-ms=%.3f\n", name, total[name] / count[name] / 1000.0
+          printf "span.%s.max-ms=%.3f\n", name, longest[name] / 1000.0
+        }
+      for (name in last)
+        printf "counter.%s=%s\n", name, last[name]
+      if ("rss-kb" in highest)
+        printf "counter.rss-kb.max=%s\n", highest["rss-kb"]
+      if (updates > 1 && updates_last > updates_first)
+        printf "tasklist.updates-per-second=%.0f\n",
+               updates / ((updates_last - updates_first) / 1000000.0)
+    }
+  ' "$trace" | sort
+
+  cat "$tmp/storm.txt"
+} >"$tmp/report.txt"
+
+cat "$tmp/report.txt"
+test -z "$BENCH_REPORT" || cp "$tmp/report.txt" "$BENCH_REPORT"
+
+grep -q '^startup.ms=' "$tmp/report.txt" || fail "no startup in the trace"
+
+exit 0
@@ -32,6 +32,12 @@
 #ifdef HAVE_STRING_H
 #include <string.h>
 #endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
 
 #include <dbus/dbus.h>
 #include <dbus/dbus-glib.h>
@@ -40,6 +46,8 @@
 #include <gtk/gtk.h>
 #include <common/bar-private.h>
 #include <common/bar-dbus.h>
+#include <common/bar-debug.h>
+#include <common/bar-trace.h>
 #include <libbladeutil/libbladeutil.h>
 #include <libbladebar/libbladebar.h>
 #include <libbladebar/blade-bar-plugin-provider.h>
@@ -50,10 +58,53 @@
 
 
 
+typedef struct _WrapperHostPlugin WrapperHostPlugin;
+
+
+
+static void wrapper_host_plugin_quit (WrapperHostPlugin *plugin,
+                                      gint               exit_code);
+static void wrapper_heartbeat_start  (GtkWidget         *provider,
+                                      DBusGProxy        *dbus_gproxy,
+                                      gint               interval);
+
+
+
+/* a plugin running in a shared wrapper host */
+struct _WrapperHostPlugin
+{
+  gint         unique_id;
+
+  DBusGProxy  *dbus_gproxy;
+  guint        gproxy_destroy_id;
+
+  GtkWidget   *provider;
+  WrapperPlug *plug;
+
+  /* delayed removal from the host */
+  guint        quit_idle_id;
+  gint         exit_code;
+};
+
+
+
 static GQuark   plug_quark = 0;
+static GQuark   heartbeat_quark = 0;
 static gboolean gproxy_destroyed = FALSE;
 static gint     retval = PLUGIN_EXIT_FAILURE;
 
+/* providers in this process and the ones the bar has to save */
+static GSList  *providers = NULL;
+static GQuark   save_needed_quark = 0;
+
+/* shared wrapper host, host_plugins is only set in a host */
+static GHashTable      *host_plugins = NULL;
+static GHashTable      *host_modules = NULL;
+static GQuark           host_plugin_quark = 0;
+static DBusGConnection *host_dbus_gconnection = NULL;
+static GString         *host_buffer = NULL;
+static gint             host_reply_fd = -1;
+
 
 
 static void
@@ -131,11 +182,22 @@ wrapper_gproxy_set (DBusGProxy              *dbus_gproxy,
 
         case PROVIDER_PROP_TYPE_ACTION_SAVE:
           blade_bar_plugin_provider_save (provider);
+          g_object_set_qdata (G_OBJECT (provider), save_needed_quark, NULL);
           break;
 
         case PROVIDER_PROP_TYPE_ACTION_QUIT_FOR_RESTART:
-          retval = PLUGIN_EXIT_SUCCESS_AND_RESTART;
         case PROVIDER_PROP_TYPE_ACTION_QUIT:
+          if (G_UNLIKELY (host_plugins != NULL))
+            {
+              /* only stop this plugin, not the entire host */
+              wrapper_host_plugin_quit (g_object_get_qdata (G_OBJECT (provider), host_plugin_quark),
+                                        type == PROVIDER_PROP_TYPE_ACTION_QUIT_FOR_RESTART ?
+                                            PLUGIN_EXIT_SUCCESS_AND_RESTART : PLUGIN_EXIT_SUCCESS);
+              break;
+            }
+
+          if (type == PROVIDER_PROP_TYPE_ACTION_QUIT_FOR_RESTART)
+            retval = PLUGIN_EXIT_SUCCESS_AND_RESTART;
           gtk_main_quit ();
           break;
 
@@ -151,6 +213,11 @@ wrapper_gproxy_set (DBusGProxy              *dbus_gproxy,
           blade_bar_plugin_provider_ask_remove (provider);
           break;
 
+        case PROVIDER_PROP_TYPE_SET_HEARTBEAT_INTERVAL:
+          wrapper_heartbeat_start (GTK_WIDGET (provider), dbus_gproxy,
+                                   g_value_get_int (value));
+          break;
+
         default:
           bar_assert_not_reached ();
           break;
@@ -253,6 +320,546 @@ wrapper_gproxy_destroyed (DBusGProxy *dbus_gproxy)
 
 
 
+static gboolean
+wrapper_heartbeat (gpointer user_data)
+{
+  /* tell the bar our main loop is still running */
+  if (G_LIKELY (!gproxy_destroyed))
+    wrapper_dbus_heartbeat (user_data, NULL);
+
+  return TRUE;
+}
+
+
+
+static void
+wrapper_heartbeat_stop (gpointer data)
+{
+  g_source_remove (GPOINTER_TO_UINT (data));
+}
+
+
+
+static void
+wrapper_heartbeat_start (GtkWidget  *provider,
+                         DBusGProxy *dbus_gproxy,
+                         gint        interval)
+{
+  guint heartbeat_id;
+
+  /* the bar only asks for heartbeats if its watchdog checks for
+   * stalls, the qdata removes the previous timeout */
+  if (interval > 0)
+    {
+      heartbeat_id = g_timeout_add_seconds (interval, wrapper_heartbeat, dbus_gproxy);
+      g_object_set_qdata_full (G_OBJECT (provider), heartbeat_quark,
+                               GUINT_TO_POINTER (heartbeat_id),
+                               wrapper_heartbeat_stop);
+    }
+  else
+    {
+      g_object_set_qdata (G_OBJECT (provider), heartbeat_quark, NULL);
+    }
+}
+
+
+
+static void
+wrapper_save_needed (GtkWidget *provider)
+{
+  /* tell the bar once, until it asked the plugin to save */
+  if (g_object_get_qdata (G_OBJECT (provider), save_needed_quark) == NULL)
+    {
+      g_object_set_qdata (G_OBJECT (provider), save_needed_quark, GINT_TO_POINTER (TRUE));
+      blade_bar_plugin_provider_emit_signal (BLADE_BAR_PLUGIN_PROVIDER (provider),
+                                              PROVIDER_SIGNAL_SAVE_NEEDED);
+    }
+}
+
+
+
+static gboolean
+wrapper_input_hook (GSignalInvocationHint *ihint,
+                    guint                  n_param_values,
+                    const GValue          *param_values,
+                    gpointer               user_data)
+{
+  GtkWidget *widget;
+  GSList    *li;
+
+  /* walk up to the plugin, menus continue at their attach widget */
+  widget = g_value_get_object (param_values);
+  while (widget != NULL)
+    {
+      if (BLADE_IS_BAR_PLUGIN_PROVIDER (widget))
+        {
+          wrapper_save_needed (widget);
+          return TRUE;
+        }
+
+      if (GTK_IS_MENU (widget))
+        widget = gtk_menu_get_attach_widget (GTK_MENU (widget));
+      else
+        widget = gtk_widget_get_parent (widget);
+    }
+
+  /* most likely a plugin dialog, in a host we can't
+   * tell which plugin it belongs to */
+  for (li = providers; li != NULL; li = li->next)
+    wrapper_save_needed (li->data);
+
+  return TRUE;
+}
+
+
+
+static void
+wrapper_provider_connect (GtkWidget   *provider,
+                          WrapperPlug *plug,
+                          DBusGProxy  *dbus_gproxy)
+{
+  static const gchar *input_signals[] =
+    { "button-release-event", "key-release-event", "scroll-event" };
+  guint               i;
+
+  /* the bar only asks plugins to save that had user input since the
+   * last save, so watch the input in this process */
+  if (save_needed_quark == 0)
+    {
+      save_needed_quark = g_quark_from_static_string ("save-needed");
+      for (i = 0; i < G_N_ELEMENTS (input_signals); i++)
+        g_signal_add_emission_hook (g_signal_lookup (input_signals[i], GTK_TYPE_WIDGET),
+                                    0, wrapper_input_hook, NULL, NULL);
+    }
+
+  providers = g_slist_prepend (providers, provider);
+
+  /* set plug data to provider */
+  plug_quark = g_quark_from_static_string ("plug-quark");
+  g_object_set_qdata (G_OBJECT (provider), plug_quark, plug);
+  heartbeat_quark = g_quark_from_static_string ("heartbeat-quark");
+
+  /* monitor provider signals */
+  g_signal_connect (G_OBJECT (provider), "provider-signal",
+      G_CALLBACK (wrapper_gproxy_provider_signal), dbus_gproxy);
+
+  /* connect to service signals */
+  dbus_g_proxy_add_signal (dbus_gproxy, "Set",
+      BAR_TYPE_DBUS_SET_SIGNAL, G_TYPE_INVALID);
+  dbus_g_proxy_connect_signal (dbus_gproxy, "Set",
+      G_CALLBACK (wrapper_gproxy_set), g_object_ref (provider),
+      (GClosureNotify) g_object_unref);
+
+  dbus_g_object_register_marshaller (wrapper_marshal_VOID__STRING_BOXED_UINT,
+      G_TYPE_NONE, G_TYPE_STRING, G_TYPE_VALUE, G_TYPE_UINT, G_TYPE_INVALID);
+  dbus_g_proxy_add_signal (dbus_gproxy, "RemoteEvent",
+      G_TYPE_STRING, G_TYPE_VALUE, G_TYPE_UINT, G_TYPE_INVALID);
+  dbus_g_proxy_connect_signal (dbus_gproxy, "RemoteEvent",
+      G_CALLBACK (wrapper_gproxy_remote_event), g_object_ref (provider),
+      (GClosureNotify) g_object_unref);
+}
+
+
+
+static void
+wrapper_provider_disconnect (GtkWidget  *provider,
+                             DBusGProxy *dbus_gproxy)
+{
+  providers = g_slist_remove (providers, provider);
+
+  dbus_g_proxy_disconnect_signal (dbus_gproxy, "Set",
+      G_CALLBACK (wrapper_gproxy_set), provider);
+  dbus_g_proxy_disconnect_signal (dbus_gproxy, "RemoteEvent",
+      G_CALLBACK (wrapper_gproxy_remote_event), provider);
+}
+
+
+
+static void
+wrapper_host_reply (gint unique_id,
+                    gint exit_code)
+{
+  GString *message;
+  gsize    written = 0;
+  gssize   n;
+
+  /* same format as the messages from the bar, see bar-private.h */
+  message = g_string_new ("3");
+  g_string_append_len (message, "\0" BAR_WRAPPER_HOST_EXITED "\0",
+                       strlen (BAR_WRAPPER_HOST_EXITED) + 2);
+  g_string_append_printf (message, "%d", unique_id);
+  g_string_append_c (message, '\0');
+  g_string_append_printf (message, "%d", exit_code);
+  g_string_append_c (message, '\0');
+
+  while (written < message->len)
+    {
+      n = write (host_reply_fd, message->str + written, message->len - written);
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            continue;
+
+          g_warning ("Failed to send the exit status of plugin %d to the bar: %s",
+                     unique_id, g_strerror (errno));
+          break;
+        }
+
+      written += n;
+    }
+
+  g_string_free (message, TRUE);
+}
+
+
+
+static void
+wrapper_host_plugin_free (gpointer data)
+{
+  WrapperHostPlugin *plugin = data;
+
+  if (plugin->quit_idle_id != 0)
+    g_source_remove (plugin->quit_idle_id);
+
+  g_object_set_qdata (G_OBJECT (plugin->provider), heartbeat_quark, NULL);
+
+  if (!gproxy_destroyed)
+    {
+      wrapper_provider_disconnect (plugin->provider, plugin->dbus_gproxy);
+      g_signal_handler_disconnect (G_OBJECT (plugin->dbus_gproxy),
+                                   plugin->gproxy_destroy_id);
+    }
+
+  /* destroy the plug and provider */
+  if (plugin->plug != NULL)
+    {
+      g_object_remove_weak_pointer (G_OBJECT (plugin->plug), (gpointer *) &plugin->plug);
+      gtk_widget_destroy (GTK_WIDGET (plugin->plug));
+    }
+
+  g_object_unref (G_OBJECT (plugin->dbus_gproxy));
+
+  g_slice_free (WrapperHostPlugin, plugin);
+}
+
+
+
+static gboolean
+wrapper_host_plugin_quit_idle (gpointer data)
+{
+  WrapperHostPlugin *plugin = data;
+  gint               unique_id = plugin->unique_id;
+  gint               exit_code = plugin->exit_code;
+
+  plugin->quit_idle_id = 0;
+
+  /* destroy the plugin before the bar respawns it */
+  g_hash_table_remove (host_plugins, GINT_TO_POINTER (unique_id));
+
+  wrapper_host_reply (unique_id, exit_code);
+
+  return FALSE;
+}
+
+
+
+static void
+wrapper_host_plugin_quit (WrapperHostPlugin *plugin,
+                          gint               exit_code)
+{
+  bar_return_if_fail (plugin != NULL);
+
+  /* don't loose a restart request */
+  if (plugin->exit_code != PLUGIN_EXIT_SUCCESS_AND_RESTART)
+    plugin->exit_code = exit_code;
+
+  /* we're possibly called from one of the plugin's signal
+   * handlers, so destroy the plugin from an idle */
+  if (plugin->quit_idle_id == 0)
+    plugin->quit_idle_id = g_idle_add (wrapper_host_plugin_quit_idle, plugin);
+}
+
+
+
+static void
+wrapper_host_add (gint    argc,
+                  gchar **argv)
+{
+  BladeBarPluginPreInit  preinit_func;
+  WrapperHostPlugin     *plugin;
+  WrapperModule         *module;
+  GModule               *library;
+  DBusGProxy            *dbus_gproxy;
+  GtkWidget             *provider;
+  GError                *error = NULL;
+  gchar                 *path;
+  const gchar           *filename;
+  gint                   unique_id;
+#if GTK_CHECK_VERSION (3, 0, 0)
+  Window                 socket_id;
+#else
+  GdkNativeWindow        socket_id;
+#endif
+  const gchar           *name;
+  gint                   exit_code = PLUGIN_EXIT_FAILURE;
+
+  if (G_UNLIKELY (argc < PLUGIN_ARGV_ARGUMENTS))
+    {
+      g_critical ("Not enough arguments are passed to the wrapper host");
+      return;
+    }
+
+  filename = argv[PLUGIN_ARGV_FILENAME];
+  unique_id = strtol (argv[PLUGIN_ARGV_UNIQUE_ID], NULL, 0);
+  socket_id = strtol (argv[PLUGIN_ARGV_SOCKET_ID], NULL, 0);
+  name = argv[PLUGIN_ARGV_NAME];
+
+  /* the bar waits for the exit of a plugin before it is
+   * started again, but never run the same plugin twice */
+  g_hash_table_remove (host_plugins, GINT_TO_POINTER (unique_id));
+
+  /* modules are never closed in the host, so their types
+   * are registered only once */
+  module = g_hash_table_lookup (host_modules, filename);
+  if (module == NULL)
+    {
+      bar_trace_begin ("module-open %s", name);
+      library = g_module_open (filename, G_MODULE_BIND_LOCAL);
+      bar_trace_end ("module-open %s", name);
+      if (G_UNLIKELY (library == NULL))
+        {
+          g_set_error (&error, 0, 0, "Failed to open plugin module \"%s\": %s",
+                       filename, g_module_error ());
+          goto leave;
+        }
+
+      /* the host already initialized gtk, so the preinit function
+       * runs too late here, see BLADE_BAR_DEFINE_PREINIT_FUNC */
+      if (g_module_symbol (library, "blade_bar_module_preinit", (gpointer) &preinit_func)
+          && preinit_func != NULL
+          && (*preinit_func) (argc, argv) == FALSE)
+        {
+          g_module_close (library);
+          exit_code = PLUGIN_EXIT_PREINIT_FAILED;
+          goto leave;
+        }
+
+      module = wrapper_module_new (library);
+      g_hash_table_insert (host_modules, g_strdup (filename), module);
+    }
+
+  /* every plugin has its own proxy on the shared connection */
+  path = g_strdup_printf (BAR_DBUS_WRAPPER_PATH, unique_id);
+  dbus_gproxy = dbus_g_proxy_new_for_name_owner (host_dbus_gconnection,
+                                                 BAR_DBUS_NAME,
+                                                 path,
+                                                 BAR_DBUS_WRAPPER_INTERFACE,
+                                                 &error);
+  g_free (path);
+  if (G_UNLIKELY (dbus_gproxy == NULL))
+    goto leave;
+
+  bar_trace_begin ("new-provider %s-%d", name, unique_id);
+  provider = wrapper_module_new_provider (module,
+                                          gdk_screen_get_default (),
+                                          name, unique_id,
+                                          argv[PLUGIN_ARGV_DISPLAY_NAME],
+                                          argv[PLUGIN_ARGV_COMMENT],
+                                          argv + PLUGIN_ARGV_ARGUMENTS);
+  bar_trace_end ("new-provider %s-%d", name, unique_id);
+
+  if (G_UNLIKELY (provider == NULL))
+    {
+      g_object_unref (G_OBJECT (dbus_gproxy));
+      exit_code = PLUGIN_EXIT_NO_PROVIDER;
+      goto leave;
+    }
+
+  plugin = g_slice_new0 (WrapperHostPlugin);
+  plugin->unique_id = unique_id;
+  plugin->dbus_gproxy = dbus_gproxy;
+  plugin->provider = provider;
+  plugin->exit_code = PLUGIN_EXIT_SUCCESS;
+
+  /* quit when the proxy is destroyed (bar segfault for example) */
+  plugin->gproxy_destroy_id = g_signal_connect (G_OBJECT (dbus_gproxy), "destroy",
+      G_CALLBACK (wrapper_gproxy_destroyed), NULL);
+
+  /* create the wrapper plug */
+  plugin->plug = wrapper_plug_new (socket_id);
+  gtk_container_add (GTK_CONTAINER (plugin->plug), provider);
+  g_object_add_weak_pointer (G_OBJECT (plugin->plug), (gpointer *) &plugin->plug);
+  gtk_widget_show (GTK_WIDGET (plugin->plug));
+
+  g_object_set_qdata (G_OBJECT (provider), host_plugin_quark, plugin);
+  wrapper_provider_connect (provider, plugin->plug, dbus_gproxy);
+
+  g_hash_table_insert (host_plugins, GINT_TO_POINTER (unique_id), plugin);
+
+  /* show the plugin */
+  bar_trace_begin ("show %s-%d", name, unique_id);
+  gtk_widget_show (provider);
+  bar_trace_end ("show %s-%d", name, unique_id);
+
+  return;
+
+leave:
+  if (G_UNLIKELY (error != NULL))
+    {
+      g_critical ("Wrapper %s-%d: %s.", name,
+                  unique_id, error->message);
+      g_error_free (error);
+    }
+
+  wrapper_host_reply (unique_id, exit_code);
+}
+
+
+
+static gboolean
+wrapper_host_parse (gchar ***strv_return)
+{
+  const gchar *p = host_buffer->str;
+  const gchar *end = host_buffer->str + host_buffer->len;
+  const gchar *nul;
+  gchar      **strv;
+  guint        i, n;
+
+  /* number of strings in the message */
+  nul = memchr (p, '\0', end - p);
+  if (nul == NULL)
+    return FALSE;
+
+  n = strtoul (p, NULL, 10);
+  p = nul + 1;
+
+  strv = g_new0 (gchar *, n + 1);
+  for (i = 0; i < n; i++)
+    {
+      nul = memchr (p, '\0', end - p);
+      if (nul == NULL)
+        {
+          /* wait for the remainder of the message */
+          g_strfreev (strv);
+          return FALSE;
+        }
+
+      strv[i] = g_strndup (p, nul - p);
+      p = nul + 1;
+    }
+
+  g_string_erase (host_buffer, 0, p - host_buffer->str);
+  *strv_return = strv;
+
+  return TRUE;
+}
+
+
+
+static gboolean
+wrapper_host_read (GIOChannel   *source,
+                   GIOCondition  condition,
+                   gpointer      user_data)
+{
+  gchar               buf[1024];
+  gssize              n;
+  gchar             **strv;
+  gint                argc;
+  WrapperHostPlugin  *plugin;
+
+  n = read (STDIN_FILENO, buf, sizeof (buf));
+  if (n < 0 && (errno == EINTR || errno == EAGAIN))
+    return TRUE;
+
+  if (n <= 0)
+    {
+      /* the bar closed the pipe, this host is not used anymore */
+      gtk_main_quit ();
+      return FALSE;
+    }
+
+  g_string_append_len (host_buffer, buf, n);
+
+  while (wrapper_host_parse (&strv))
+    {
+      argc = g_strv_length (strv);
+
+      if (argc > 0 && strcmp (strv[0], BAR_WRAPPER_HOST_ADD) == 0)
+        {
+          wrapper_host_add (argc, strv);
+        }
+      else if (argc == 3 && strcmp (strv[0], BAR_WRAPPER_HOST_QUIT) == 0)
+        {
+          plugin = g_hash_table_lookup (host_plugins,
+                                        GINT_TO_POINTER (strtol (strv[1], NULL, 0)));
+          if (G_LIKELY (plugin != NULL))
+            wrapper_host_plugin_quit (plugin, strcmp (strv[2], "1") == 0 ?
+                                      PLUGIN_EXIT_SUCCESS_AND_RESTART : PLUGIN_EXIT_SUCCESS);
+        }
+
+      g_strfreev (strv);
+    }
+
+  return TRUE;
+}
+
+
+
+static gint
+wrapper_host_main (gint    argc,
+                   gchar **argv)
+{
+  GIOChannel *channel;
+
+#if defined(HAVE_SYS_PRCTL_H) && defined(PR_SET_NAME)
+  /* change the process name to something that makes sence */
+  if (prctl (PR_SET_NAME, (gulong) "bar-host", 0, 0, 0) == -1)
+    g_warning ("Failed to change the process name to \"%s\".", "bar-host");
+#endif
+
+  /* append to the startup trace of the bar */
+  bar_trace_open ("wrapper-host", FALSE);
+
+  gtk_init (&argc, &argv);
+
+  host_dbus_gconnection = dbus_g_bus_get (DBUS_BUS_SESSION, NULL);
+  if (G_UNLIKELY (host_dbus_gconnection == NULL))
+    {
+      g_critical ("Wrapper host: failed to connect to the session bus.");
+      return PLUGIN_EXIT_FAILURE;
+    }
+
+  /* stdout is our reply channel to the bar, move it aside so
+   * messages printed by the plugins end up in stderr */
+  host_reply_fd = dup (STDOUT_FILENO);
+  dup2 (STDERR_FILENO, STDOUT_FILENO);
+
+  host_plugin_quark = g_quark_from_static_string ("host-plugin");
+  host_plugins = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                        NULL, wrapper_host_plugin_free);
+  host_modules = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                        g_free, NULL);
+  host_buffer = g_string_new (NULL);
+
+  /* read commands from the bar */
+  channel = g_io_channel_unix_new (STDIN_FILENO);
+  g_io_add_watch (channel, G_IO_IN | G_IO_HUP | G_IO_ERR,
+                  wrapper_host_read, NULL);
+  g_io_channel_unref (channel);
+
+  bar_trace_instant ("main-loop");
+
+  gtk_main ();
+
+  /* destroy the remaining plugins, the bar sees the exit
+   * of the host as a normal exit for all of them */
+  g_hash_table_destroy (host_plugins);
+
+  return PLUGIN_EXIT_SUCCESS;
+}
+
+
+
 gint
 main (gint argc, gchar **argv)
 {
@@ -289,6 +896,13 @@ main (gint argc, gchar **argv)
   g_log_set_always_fatal (G_LOG_LEVEL_CRITICAL | G_LOG_LEVEL_WARNING);
 #endif
 
+  /* dump the debug ring of this process on SIGUSR2 or a crash */
+  bar_debug_install_dump_handlers ();
+
+  /* run as a shared host for several plugins */
+  if (argc == 2 && strcmp (argv[1], BAR_WRAPPER_HOST_ARGUMENT) == 0)
+    return wrapper_host_main (argc, argv);
+
   /* check if we have all the reuiqred arguments */
   if (G_UNLIKELY (argc < PLUGIN_ARGV_ARGUMENTS))
     {
@@ -313,8 +927,18 @@ main (gint argc, gchar **argv)
     g_warning ("Failed to change the process name to \"%s\".", process_name);
 #endif
 
+  /* append to the startup trace of the bar */
+  if (g_getenv ("BAR_TRACE") != NULL)
+    {
+      path = g_strdup_printf ("wrapper %s-%d", name, unique_id);
+      bar_trace_open (path, FALSE);
+      g_free (path);
+    }
+
   /* open the plugin module */
+  bar_trace_begin ("module-open");
   library = g_module_open (filename, G_MODULE_BIND_LOCAL);
+  bar_trace_end ("module-open");
   if (G_UNLIKELY (library == NULL))
     {
       g_set_error (&error, 0, 0, "Failed to open plugin module \"%s\": %s",
@@ -331,12 +955,18 @@ main (gint argc, gchar **argv)
       goto leave;
     }
 
+  bar_trace_begin ("gtk-init");
   gtk_init (&argc, &argv);
+  bar_trace_end ("gtk-init");
 
   /* connect the dbus proxy */
+  bar_trace_begin ("dbus-proxy");
   dbus_gconnection = dbus_g_bus_get (DBUS_BUS_SESSION, &error);
   if (G_UNLIKELY (dbus_gconnection == NULL))
-    goto leave;
+    {
+      bar_trace_end ("dbus-proxy");
+      goto leave;
+    }
 
   path = g_strdup_printf (BAR_DBUS_WRAPPER_PATH, unique_id);
   dbus_gproxy = dbus_g_proxy_new_for_name_owner (dbus_gconnection,
@@ -345,6 +975,7 @@ main (gint argc, gchar **argv)
                                                  BAR_DBUS_WRAPPER_INTERFACE,
                                                  &error);
   g_free (path);
+  bar_trace_end ("dbus-proxy");
   if (G_UNLIKELY (dbus_gproxy == NULL))
     goto leave;
 
@@ -356,11 +987,13 @@ main (gint argc, gchar **argv)
   module = wrapper_module_new (library);
 
   /* create the plugin provider */
+  bar_trace_begin ("new-provider");
   provider = wrapper_module_new_provider (module,
                                           gdk_screen_get_default (),
                                           name, unique_id,
                                           display_name, comment,
                                           arguments);
+  bar_trace_end ("new-provider");
 
   if (G_LIKELY (provider != NULL))
     {
@@ -370,42 +1003,22 @@ main (gint argc, gchar **argv)
       g_object_add_weak_pointer (G_OBJECT (plug), (gpointer *) &plug);
       gtk_widget_show (GTK_WIDGET (plug));
 
-      /* set plug data to provider */
-      plug_quark = g_quark_from_static_string ("plug-quark");
-      g_object_set_qdata (G_OBJECT (provider), plug_quark, plug);
-
-      /* monitor provider signals */
-      g_signal_connect (G_OBJECT (provider), "provider-signal",
-          G_CALLBACK (wrapper_gproxy_provider_signal), dbus_gproxy);
-
-      /* connect to service signals */
-      dbus_g_proxy_add_signal (dbus_gproxy, "Set",
-          BAR_TYPE_DBUS_SET_SIGNAL, G_TYPE_INVALID);
-      dbus_g_proxy_connect_signal (dbus_gproxy, "Set",
-          G_CALLBACK (wrapper_gproxy_set), g_object_ref (provider),
-          (GClosureNotify) g_object_unref);
-
-      dbus_g_object_register_marshaller (wrapper_marshal_VOID__STRING_BOXED_UINT,
-          G_TYPE_NONE, G_TYPE_STRING, G_TYPE_VALUE, G_TYPE_UINT, G_TYPE_INVALID);
-      dbus_g_proxy_add_signal (dbus_gproxy, "RemoteEvent",
-          G_TYPE_STRING, G_TYPE_VALUE, G_TYPE_UINT, G_TYPE_INVALID);
-      dbus_g_proxy_connect_signal (dbus_gproxy, "RemoteEvent",
-          G_CALLBACK (wrapper_gproxy_remote_event), g_object_ref (provider),
-          (GClosureNotify) g_object_unref);
+      wrapper_provider_connect (provider, plug, dbus_gproxy);
 
       /* show the plugin */
+      bar_trace_begin ("show");
       gtk_widget_show (GTK_WIDGET (provider));
+      bar_trace_end ("show");
+
+      bar_trace_instant ("main-loop");
 
       gtk_main ();
 
+      g_object_set_qdata (G_OBJECT (provider), heartbeat_quark, NULL);
+
       /* disconnect signals */
       if (!gproxy_destroyed)
-        {
-          dbus_g_proxy_disconnect_signal (dbus_gproxy, "Set",
-              G_CALLBACK (wrapper_gproxy_set), provider);
-          dbus_g_proxy_disconnect_signal (dbus_gproxy, "RemoteEvent",
-              G_CALLBACK (wrapper_gproxy_remote_event), provider);
-        }
+        wrapper_provider_disconnect (provider, dbus_gproxy);
 
       /* destroy the plug and provider */
       if (plug != NULL)